@@ -0,0 +1,66 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file
+    \brief Allocator - Memory allocation for classes created in large numbers
+*/
+
+#ifndef rp_allocator_hpp
+#define rp_allocator_hpp
+
+#include <rp/rpdefines.hpp>
+#include <boost/make_shared.hpp>
+#include <memory>
+
+#if defined(RP_ENABLE_POOLED_ALLOCATION)
+    #include <boost/pool/pool_alloc.hpp>
+#endif
+
+namespace reposit {
+
+    //! The allocator for classes which are created and destroyed in large numbers.
+    /*! This applies to ObjectWrapper, ObjectWrapperXL, and the classes derived
+        from ValueObject.  Instances should be created with boost::allocate_shared,
+        so that the instance and the reference count of its shared_ptr occupy a
+        single block of memory:
+        \code
+            boost::shared_ptr<ObjectWrapper> objectWrapper =
+                boost::allocate_shared<ObjectWrapper>(Allocator<ObjectWrapper>::type(), object);
+        \endcode
+
+        By default the blocks are obtained from std::allocator.  If
+        RP_ENABLE_POOLED_ALLOCATION is defined (configure --enable-pooled-allocation)
+        then they are obtained instead from boost::fast_pool_allocator, which
+        maintains a free list for each block size.  Memory released to the pool
+        is reused for subsequent instances of the same size, but is not returned
+        to the operating system.
+    */
+    template <class T>
+    struct Allocator {
+#if defined(RP_ENABLE_POOLED_ALLOCATION)
+        typedef boost::fast_pool_allocator<T> type;
+#else
+        typedef std::allocator<T> type;
+#endif
+    };
+
+}
+
+#endif
+
@@ -25,6 +25,7 @@
 #define rp_logger_hpp
 
 #include <rp/singleton.hpp>
+#include <string>
 
 namespace reposit {
 
@@ -26,8 +26,10 @@
 #define rp_objectwrapper_hpp
 
 #include <ostream>
+#include <boost/atomic.hpp>
 #include <rp/object.hpp>
 #include <rp/observable.hpp>
+#include <rp/allocator.hpp>
 #include <rp/serializationfactory.hpp>
 #include <rp/utilities.hpp>
 
@@ -79,13 +81,21 @@ namespace reposit {
         //! \name Inspectors
         //@{
         //! The object's initial creation time.
-        double creationTime() const { return creationTime_; }
+        double creationTime() const { return tickToTime(creationTick_); }
         //! The time of the object's last update.
-        double updateTime() const { return updateTime_; }
+        double updateTime() const { return tickToTime(updateTick_); }
         //! Query the value of the dirty flag.
         /*! False means the Object is up to date, true means it is invalid.
+            A thread which reads false also sees the Object written by the
+            recreate() which cleared the flag.
         */
-        bool dirty() const { return dirty_; }
+        bool dirty() const { return dirty_.load(boost::memory_order_acquire); }
+        //! Determine whether the contained Object was created from an identical ValueObject.
+        /*! The hash of the contained Object's ValueObject is computed on the first
+            call and retained until the Object is replaced.  A matching hash is
+            confirmed by a comparison of the property values.
+        */
+        bool identical(const boost::shared_ptr<ValueObject> &valueObject) const;
         //@}
 
         //! \name Logging
@@ -99,25 +109,29 @@ namespace reposit {
         boost::shared_ptr<Object> object_;
 
     private:
-        // Flag indicating whether contained Object is up to date.
-        bool dirty_;
-        // Time at which Object was first created.
-        double creationTime_;
-        // Time at which Object was last recreated.
-        double updateTime_;
+        // Flag indicating whether contained Object is up to date.  Cleared
+        // last, with release ordering, by recreate() and reset().
+        boost::atomic<bool> dirty_;
+        // Time at which Object was first created, converted on demand.
+        Tick creationTick_;
+        // Time at which Object was last recreated, converted on demand.
+        Tick updateTick_;
+        // Hash of the ValueObject of the contained Object, computed on demand.
+        mutable std::size_t contentHash_;
+        mutable bool contentHashValid_;
     };
 
     inline ObjectWrapper::ObjectWrapper(const boost::shared_ptr<Object>& object)
-        : object_(object), dirty_(false) {
-            creationTime_ = updateTime_ = getTime();
+        : object_(object), dirty_(false), contentHash_(0), contentHashValid_(false) {
+            creationTick_ = updateTick_ = getTick();
     }
 
     inline void ObjectWrapper::recreate(){
         try {
             object_ = SerializationFactory::instance().recreateObject( 
                 object_->properties());
-            dirty_ = false;
-            updateTime_ = getTime();
+            updateTick_ = getTick();
+            dirty_.store(false, boost::memory_order_release);
         } catch (const std::exception &e) {
             RP_FAIL("Error in function ObjectWrapper::recreate() : " << e.what());
         }
@@ -125,16 +139,29 @@ namespace reposit {
 
     inline void ObjectWrapper::update(){
         notifyObservers();
-        dirty_ = true;
+        dirty_.store(true, boost::memory_order_release);
     }
 
     inline void ObjectWrapper::reset(boost::shared_ptr<Object> object) {
         object_ = object;
-        dirty_ = false;
-        updateTime_ = getTime();
+        contentHashValid_ = false;
+        updateTick_ = getTick();
+        dirty_.store(false, boost::memory_order_release);
         notifyObservers();
     }
 
+    inline bool ObjectWrapper::identical(const boost::shared_ptr<ValueObject> &valueObject) const {
+        const boost::shared_ptr<ValueObject> &properties = object_->properties();
+        if (!valueObject || !properties)
+            return false;
+        if (!contentHashValid_) {
+            contentHash_ = properties->contentHash();
+            contentHashValid_ = true;
+        }
+        return valueObject->contentHash() == contentHash_
+            && valueObject->contentEquals(*properties);
+    }
+
     //! Log the given ObjectWrapper to the given stream.
     inline std::ostream& operator<<(std::ostream& out, const boost::shared_ptr<ObjectWrapper> &ow) {
         ow->dump(out);
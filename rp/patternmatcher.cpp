@@ -0,0 +1,150 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#if defined(HAVE_CONFIG_H)     // Dynamically created by configure
+#include <rp/config.hpp>
+#endif
+
+#include <rp/patternmatcher.hpp>
+#include <cctype>
+#include <cstring>
+
+namespace reposit {
+
+    namespace {
+        inline char upper(char c) {
+            return static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        }
+
+        // The characters which denote themselves when preceded by a backslash.
+        const char escapedLiterals[] = "\\.^$|()[]{}*+?-/";
+    }
+
+    PatternMatcher::PatternMatcher(const std::string &pattern)
+        : pattern_(pattern), simple_(false) {
+
+        simple_ = compileGlob();
+        if (!simple_)
+            regex_.assign(pattern_, boost::regex::perl | boost::regex::icase);
+    }
+
+    bool PatternMatcher::literal(std::string::size_type i) const {
+        // A literal character must not be followed by a quantifier.
+        if (i >= pattern_.length())
+            return true;
+        char c = pattern_[i];
+        return c != '*' && c != '+' && c != '?' && c != '{';
+    }
+
+    bool PatternMatcher::compileGlob() {
+
+        for (std::string::size_type i = 0; i < pattern_.length(); ++i) {
+            char c = pattern_[i];
+            char next = i + 1 < pattern_.length() ? pattern_[i + 1] : 0;
+            switch (c) {
+                case '\\':
+                    // An escaped metacharacter is a literal.  Any other escape
+                    // may have a meaning of its own, e.g. \d is a character
+                    // class and \< a word boundary, so leave it to boost::regex.
+                    if (!next || !std::strchr(escapedLiterals, next))
+                        return false;
+                    if (!literal(i + 2))
+                        return false;
+                    glob_ += upper(next);
+                    tokens_.push_back(Literal);
+                    ++i;
+                    break;
+                case '.':
+                    if (next == '*') {
+                        ++i;
+                    } else if (next == '+') {
+                        glob_ += ' ';
+                        tokens_.push_back(AnyChar);
+                        ++i;
+                    } else if (next == '?' || next == '{') {
+                        return false;
+                    } else {
+                        glob_ += ' ';
+                        tokens_.push_back(AnyChar);
+                        break;
+                    }
+                    // Adjacent sequence wildcards are redundant.
+                    if (tokens_.empty() || tokens_.back() != AnySequence) {
+                        glob_ += ' ';
+                        tokens_.push_back(AnySequence);
+                    }
+                    break;
+                case '^': case '$': case '|': case '(': case ')':
+                case '[': case ']': case '{': case '}':
+                case '*': case '+': case '?':
+                    return false;
+                default:
+                    if (!literal(i + 1))
+                        return false;
+                    glob_ += upper(c);
+                    tokens_.push_back(Literal);
+            }
+        }
+        return true;
+    }
+
+    bool PatternMatcher::matches(const std::string &value) const {
+
+        if (!simple_)
+            return boost::regex_match(value, regex_);
+
+        // Iterative wildcard match - on a mismatch, backtrack to the most
+        // recent sequence wildcard and let it absorb one more character.
+        const std::string::size_type npos = std::string::npos;
+        std::string::size_type v = 0, p = 0, star = npos, mark = 0;
+        while (v < value.length()) {
+            if (p < tokens_.size() && (tokens_[p] == AnyChar
+                || (tokens_[p] == Literal && glob_[p] == upper(value[v])))) {
+                ++v;
+                ++p;
+            } else if (p < tokens_.size() && tokens_[p] == AnySequence) {
+                star = p++;
+                mark = v;
+            } else if (star != npos) {
+                p = star + 1;
+                v = ++mark;
+            } else {
+                return false;
+            }
+        }
+        while (p < tokens_.size() && tokens_[p] == AnySequence)
+            ++p;
+        return p == tokens_.size();
+    }
+
+    bool PatternMatcher::matchesAll() const {
+        return simple_ && tokens_.size() == 1 && tokens_[0] == AnySequence;
+    }
+
+    std::string PatternMatcher::prefix() const {
+        if (!simple_)
+            return std::string();
+        std::string::size_type n = 0;
+        while (n < tokens_.size() && tokens_[n] == Literal)
+            ++n;
+        return glob_.substr(0, n);
+    }
+
+}
+
@@ -0,0 +1,102 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file
+    \brief Class PatternMatcher - Case insensitive matching of strings against a regex
+*/
+
+#ifndef rp_patternmatcher_hpp
+#define rp_patternmatcher_hpp
+
+#include <rp/rpdefines.hpp>
+#include <boost/regex.hpp>
+#include <string>
+#include <vector>
+
+namespace reposit {
+
+    //! Case insensitive matching of strings against a perl regular expression.
+    /*! reposit accepts regular expressions from the user in a number of places,
+        e.g. to select the files to be deserialized, or the IDs of the Objects
+        to be listed.  In practice almost all of these patterns are of the
+        form "EUR_.*" or ".*\\.xml" and it is wasteful to run them through
+        boost::regex.
+
+        The PatternMatcher constructor inspects the pattern.  If the pattern
+        uses only literal characters, backslash-escaped metacharacters, and
+        the wildcards ".", ".*" and ".+", it is compiled to a simple glob which
+        is evaluated without recourse to boost::regex.  Any other pattern is
+        compiled once to a boost::regex with flags perl | icase.  Either way
+        the result of a match is identical.
+
+        As with boost::regex, an empty pattern matches only the empty string.
+    */
+    class PatternMatcher {
+    public:
+        //! \name Structors
+        //@{
+        //! Constructor - compile the given pattern.
+        /*! Throws if the pattern is not a valid regular expression.
+        */
+        PatternMatcher(const std::string &pattern = "");
+        //@}
+
+        //! \name Matching
+        //@{
+        //! Determine whether the given string matches the pattern in its entirety.
+        bool matches(const std::string &value) const;
+        //@}
+
+        //! \name Inspectors
+        //@{
+        //! The pattern that was passed to the constructor.
+        const std::string &pattern() const { return pattern_; }
+        //! Indicate whether the pattern was compiled to a glob.
+        bool simple() const { return simple_; }
+        //! Indicate whether the pattern matches any string.
+        bool matchesAll() const;
+        //! The literal text with which any matching string must begin, in upper case.
+        /*! Empty if the pattern is not simple or begins with a wildcard.
+        */
+        std::string prefix() const;
+        //@}
+
+    private:
+        // Attempt to convert the regex to a glob, return false on failure.
+        bool compileGlob();
+        // Whether the character at the given offset may follow a literal.
+        bool literal(std::string::size_type i) const;
+
+        // The kinds of token in a compiled glob.
+        enum Token { Literal, AnyChar, AnySequence };
+
+        std::string pattern_;
+        bool simple_;
+        // Upper case literal characters of the glob, undefined for wildcards.
+        std::string glob_;
+        // The kind of each token in glob_.
+        std::vector<Token> tokens_;
+        // Fallback for patterns which cannot be expressed as a glob.
+        boost::regex regex_;
+    };
+
+}
+
+#endif
+
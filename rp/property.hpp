@@ -34,6 +34,7 @@
 #include <boost/serialization/access.hpp>
 #include <boost/serialization/nvp.hpp>
 #include <boost/serialization/variant.hpp>
+#include <boost/functional/hash.hpp>
 #include <rp/conversions/convert.hpp>
 
 namespace reposit {
@@ -45,6 +46,9 @@ namespace reposit {
         void serialize(Archive &ar, const unsigned int) {}
     };
 
+    //! All null values are equal, required for comparison of values of type property_t
+    inline bool operator==(const empty_property_tag&, const empty_property_tag&) { return true; }
+
     //! The underlying types supported by property_t
     typedef boost::make_recursive_variant<empty_property_tag, bool, int, std::string, long, double,
             std::vector<boost::recursive_variant_> >::type property_base;
@@ -164,6 +168,35 @@ namespace reposit {
         }
     }
 
+    //! Determine whether two property values are of the same type and hold the same data.
+    inline bool propertyEquals(const property_base &lhs, const property_base &rhs) {
+        return lhs == rhs;
+    }
+
+    //! Compute a hash of the given property value.
+    /*! Values which compare equal under propertyEquals() produce the same hash.
+        The hash is stable for the lifetime of the process, it is not suitable
+        for persisting to disk.
+    */
+    inline std::size_t propertyHash(const property_base &p) {
+
+        std::size_t seed = static_cast<std::size_t>(p.which());
+        if (const property_t::vector* val = boost::get<property_t::vector>(&p)) {
+            for (property_t::vector::const_iterator i = val->begin(); i != val->end(); ++i)
+                boost::hash_combine(seed, propertyHash(*i));
+        } else if (const double* val = boost::get<double>(&p))
+            boost::hash_combine(seed, *val);
+        else if (const std::string* val = boost::get<std::string>(&p))
+            boost::hash_combine(seed, *val);
+        else if (const long* val = boost::get<long>(&p))
+            boost::hash_combine(seed, *val);
+        else if (const int* val = boost::get<int>(&p))
+            boost::hash_combine(seed, *val);
+        else if (const bool* val = boost::get<bool>(&p))
+            boost::hash_combine(seed, *val);
+        return seed;
+    }
+
     //! Log the given property_t value to the given stream.
     inline std::ostream &operator<<(std::ostream &out, const property_t &p) {
 
@@ -27,8 +27,21 @@
 #include <rp/serializationfactory.hpp>
 #include <rp/exception.hpp>
 #include <rp/group.hpp>
-#include <boost/regex.hpp>
+#include <rp/patternmatcher.hpp>
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/recursive_mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
+#include <cctype>
+#include <deque>
+#include <functional>
 #include <ostream>
+#include <set>
 #include <sstream>
 
 using boost::shared_ptr;
@@ -44,11 +57,214 @@ namespace reposit {
     // so instead we use a static variable.
     Repository::ObjectMap objectMap_;
 
+    // Arbitrates between threads holding shared or exclusive access to the Repository.
+    boost::shared_mutex repositoryMutex_;
+
+    // Serializes the recreation of dirty Objects by threads holding shared access.
+    // Recursive, because recreating an Object retrieves its precedents, which
+    // may themselves be dirty.
+    boost::recursive_mutex recreateMutex_;
+
+    RepositoryReadLock::RepositoryReadLock() {
+        repositoryMutex_.lock_shared();
+    }
+
+    RepositoryReadLock::~RepositoryReadLock() {
+        repositoryMutex_.unlock_shared();
+    }
+
+    RepositoryWriteLock::RepositoryWriteLock() {
+        repositoryMutex_.lock();
+    }
+
+    RepositoryWriteLock::~RepositoryWriteLock() {
+        repositoryMutex_.unlock();
+    }
+
+    namespace {
+
+        // While deferred destruction is enabled, the ObjectWrappers removed
+        // from objectMap_ are held in reclamationQueue_ until they are released
+        // by Repository::reclaimObjects() or by the reclamation thread.
+        bool deferredDestruction_ = false;
+        std::deque<shared_ptr<ObjectWrapper> > reclamationQueue_;
+
+        // Guards reclamationQueue_ and stopReclamation_.
+        boost::mutex reclamationMutex_;
+        boost::condition_variable reclamationCondition_;
+        boost::scoped_ptr<boost::thread> reclamationThread_;
+        bool stopReclamation_ = false;
+
+        std::size_t reclaim(std::size_t maxObjects) {
+            // The ObjectWrappers are released when slice goes out of scope,
+            // after the queue has been unlocked.
+            std::vector<shared_ptr<ObjectWrapper> > slice;
+            boost::mutex::scoped_lock lock(reclamationMutex_);
+            std::size_t count = reclamationQueue_.size();
+            if (maxObjects && maxObjects < count)
+                count = maxObjects;
+            slice.assign(reclamationQueue_.begin(), reclamationQueue_.begin() + count);
+            reclamationQueue_.erase(reclamationQueue_.begin(), reclamationQueue_.begin() + count);
+            std::size_t remaining = reclamationQueue_.size();
+            lock.unlock();
+            return remaining;
+        }
+
+        void reclamationLoop(std::size_t sliceSize) {
+            boost::mutex::scoped_lock lock(reclamationMutex_);
+            for (;;) {
+                while (reclamationQueue_.empty() && !stopReclamation_)
+                    reclamationCondition_.wait(lock);
+                if (stopReclamation_)
+                    return;
+                lock.unlock();
+                // Never block on the Repository lock: the thread stopping this
+                // one may hold it while it waits for the join.
+                bool reclaimed = false;
+                {
+                    boost::unique_lock<boost::shared_mutex> writeLock(repositoryMutex_, boost::try_to_lock);
+                    if (writeLock.owns_lock()) {
+                        reclaim(sliceSize);
+                        reclaimed = true;
+                    }
+                }
+                lock.lock();
+                if (!reclaimed && !stopReclamation_)
+                    reclamationCondition_.timed_wait(lock, boost::posix_time::milliseconds(10));
+            }
+        }
+
+    }
+
+    namespace {
+
+        // Order the elements of objectMap_ by address, which is stable for
+        // the lifetime of the element.
+        struct PositionLess {
+            bool operator()(Repository::ObjectMap::iterator lhs,
+                            Repository::ObjectMap::iterator rhs) const {
+                return std::less<const void*>()(&*lhs, &*rhs);
+            }
+        };
+
+        // The elements of objectMap_ holding Objects which are not permanent,
+        // so that deleteAllObjects(false) need not visit the permanent Objects.
+        typedef std::set<Repository::ObjectMap::iterator, PositionLess> Partition;
+        Partition transientObjects_;
+
+        // Order the elements of objectMap_ by ID, as in objectMap_ itself.
+        struct PositionIDLess {
+            bool operator()(Repository::ObjectMap::iterator lhs,
+                            Repository::ObjectMap::iterator rhs) const {
+                return less_(lhs->first, rhs->first);
+            }
+            my_iless less_;
+        };
+
+        typedef std::set<Repository::ObjectMap::iterator, PositionIDLess> PositionSet;
+
+        // The elements of objectMap_ grouped by the class name of the Object.
+        // A class name is removed from the index with its last Object.
+        typedef std::map<string, PositionSet, my_iless> ClassIndex;
+        ClassIndex classIndex_;
+
+        // The elements of objectMap_ grouped by the IDs of their precedents,
+        // i.e. the reverse of the relation given by
+        // ValueObject::getPrecedentObjects().  A precedent need not be present
+        // in objectMap_.  An ID is removed from the index with its last dependent.
+        typedef std::map<string, PositionSet, my_iless> DependentIndex;
+        DependentIndex dependentIndex_;
+
+        const string &objectClassName(Repository::ObjectMap::iterator position) {
+            return position->second->object()->properties()->className();
+        }
+
+        // Compiled patterns, keyed on the pattern passed to listObjectIDs() or
+        // listObjectIDsByClass(), so that a sheet which repeatedly issues the
+        // same query compiles it once.  The cache is emptied when it fills up.
+        typedef std::map<string, shared_ptr<const PatternMatcher> > MatcherCache;
+        MatcherCache matcherCache_;
+        boost::mutex matcherMutex_;
+        const std::size_t MATCHER_CACHE_SIZE = 64;
+
+        shared_ptr<const PatternMatcher> cachedMatcher(const string &pattern) {
+            boost::mutex::scoped_lock lock(matcherMutex_);
+            MatcherCache::const_iterator i = matcherCache_.find(pattern);
+            if (i != matcherCache_.end())
+                return i->second;
+            shared_ptr<const PatternMatcher> matcher(new PatternMatcher(pattern));
+            if (matcherCache_.size() >= MATCHER_CACHE_SIZE)
+                matcherCache_.clear();
+            matcherCache_[pattern] = matcher;
+            return matcher;
+        }
+
+        // Whether the given ID begins with the given upper case prefix.
+        bool hasPrefix(const string &objectID, const string &prefix) {
+            if (objectID.length() < prefix.length())
+                return false;
+            for (string::size_type i = 0; i < prefix.length(); ++i) {
+                if (std::toupper(static_cast<unsigned char>(objectID[i])) != prefix[i])
+                    return false;
+            }
+            return true;
+        }
+
+    }
+
+    void Repository::indexObject(ObjectMap::iterator position) {
+        if (!position->second->object()->permanent())
+            transientObjects_.insert(position);
+        classIndex_[objectClassName(position)].insert(position);
+
+        const set<string> &precedentIDs =
+            position->second->object()->properties()->getPrecedentObjects();
+        string buffer;
+        for (set<string>::const_iterator i = precedentIDs.begin(); i != precedentIDs.end(); ++i)
+            dependentIndex_[formatID(*i, buffer)].insert(position);
+    }
+
+    void Repository::unindexObject(ObjectMap::iterator position) {
+        transientObjects_.erase(position);
+        ClassIndex::iterator i = classIndex_.find(objectClassName(position));
+        if (i != classIndex_.end()) {
+            i->second.erase(position);
+            if (i->second.empty())
+                classIndex_.erase(i);
+        }
+
+        const set<string> &precedentIDs =
+            position->second->object()->properties()->getPrecedentObjects();
+        string buffer;
+        for (set<string>::const_iterator j = precedentIDs.begin(); j != precedentIDs.end(); ++j) {
+            DependentIndex::iterator k = dependentIndex_.find(formatID(*j, buffer));
+            if (k != dependentIndex_.end()) {
+                k->second.erase(position);
+                if (k->second.empty())
+                    dependentIndex_.erase(k);
+            }
+        }
+    }
+
+    void Repository::eraseObject(ObjectMap::iterator position) {
+        unindexObject(position);
+        if (deferredDestruction_) {
+            boost::mutex::scoped_lock lock(reclamationMutex_);
+            reclamationQueue_.push_back(position->second);
+            reclamationCondition_.notify_one();
+        }
+        objectMap_.erase(position);
+    }
+
     Repository::Repository() {
         instance_ = this;
     }
 
     Repository::~Repository() {
+        // The Repository may be a global object, destroyed after the static
+        // variables of this file, so touch them only if deferral is enabled.
+        if (deferredDestruction_)
+            setDeferredDestruction(false);
         instance_ = 0;
     }
 
@@ -58,28 +274,116 @@ namespace reposit {
         return *instance_;
     }
 
-    // TODO: implement Scott Meyers' "Effective STL" item 24
+    bool Repository::lookupObject(const string &objectID, ObjectMap::iterator &position) {
+        position = objectMap_.lower_bound(objectID);
+        return position != objectMap_.end() && !objectMap_.key_comp()(objectID, position->first);
+    }
+
+    // Scott Meyers' "Effective STL" item 24 - a single search of the map
+    // serves both to test for an existing object and as the insertion hint.
     string Repository::storeObject(const string &objectID,
                                    const shared_ptr<Object> &object,
                                    bool overwrite,
                                    boost::shared_ptr<ValueObject>) {
-        RP_REQUIRE(overwrite || !objectExists(objectID),
-                   "Cannot store object with ID '" << objectID <<
-                   "' because an object with that ID already exists");
-
-        if(objectExists(objectID)){
-            ObjectMap::const_iterator result = objectMap_.find(objectID);
-            //result->second->notifyObservers();
+        ObjectMap::iterator result;
+        if (lookupObject(objectID, result)) {
+            RP_REQUIRE(overwrite,
+                       "Cannot store object with ID '" << objectID <<
+                       "' because an object with that ID already exists");
+            unindexObject(result);
             result->second->reset(object);
-        } else{
-            shared_ptr<ObjectWrapper> objWrapper(new ObjectWrapper(object));
-            objectMap_[objectID] = objWrapper;
+        } else {
+            result = objectMap_.insert(result, std::make_pair(objectID,
+                boost::allocate_shared<ObjectWrapper>(Allocator<ObjectWrapper>::type(), object)));
         }
+        indexObject(result);
 
-        registerObserver(objectMap_[objectID]);
+        registerObserver(result->second);
         return objectID;
     }
 
+    namespace {
+
+        // Sort StoreItems by ID, with the same case insensitive ordering as ObjectMap.
+        struct StoreItemLess {
+            bool operator()(const StoreItem *lhs, const StoreItem *rhs) const {
+                return less_(lhs->objectID, rhs->objectID);
+            }
+            my_iless less_;
+        };
+
+    }
+
+    std::vector<string> Repository::storeObjects(const std::vector<StoreItem> &items,
+                                                 bool overwrite) {
+
+        // Sort the batch into ObjectMap order.  The sort is stable so that
+        // where an ID occurs more than once, the last occurrence wins.
+        std::vector<const StoreItem*> sorted;
+        sorted.reserve(items.size());
+        for (std::vector<StoreItem>::const_iterator i = items.begin(); i != items.end(); ++i)
+            sorted.push_back(&*i);
+        StoreItemLess less;
+        std::stable_sort(sorted.begin(), sorted.end(), less);
+
+        std::vector<const StoreItem*> unique;
+        unique.reserve(sorted.size());
+        for (std::vector<const StoreItem*>::const_iterator i = sorted.begin(); i != sorted.end(); ++i) {
+            if (i + 1 != sorted.end() && !less(*i, *(i + 1))) {
+                RP_REQUIRE(overwrite, "Cannot store object with ID '" << (*i)->objectID <<
+                           "' because that ID occurs more than once in the list");
+                continue;
+            }
+            unique.push_back(*i);
+        }
+
+        if (!overwrite) {
+            for (std::vector<const StoreItem*>::const_iterator i = unique.begin(); i != unique.end(); ++i)
+                RP_REQUIRE(!objectExists((*i)->objectID),
+                           "Cannot store object with ID '" << (*i)->objectID <<
+                           "' because an object with that ID already exists");
+        }
+
+        std::set<string, my_iless> batchIDs;
+        for (std::vector<const StoreItem*>::const_iterator i = unique.begin(); i != unique.end(); ++i)
+            batchIDs.insert(batchIDs.end(), (*i)->objectID);
+        for (std::vector<const StoreItem*>::const_iterator i = unique.begin(); i != unique.end(); ++i)
+            requirePrecedents((*i)->objectID, (*i)->object, batchIDs);
+
+        // Insert the batch into the map, using the result of each search
+        // as the hint for the insertion of a new element.
+        std::vector<shared_ptr<ObjectWrapper> > wrappers;
+        wrappers.reserve(unique.size());
+        for (std::vector<const StoreItem*>::const_iterator i = unique.begin(); i != unique.end(); ++i) {
+            ObjectMap::iterator result;
+            if (lookupObject((*i)->objectID, result)) {
+                unindexObject(result);
+                result->second->reset((*i)->object);
+            } else {
+                result = objectMap_.insert(result, std::make_pair((*i)->objectID,
+                    boost::allocate_shared<ObjectWrapper>(Allocator<ObjectWrapper>::type(), (*i)->object)));
+            }
+            indexObject(result);
+            wrappers.push_back(result->second);
+        }
+
+        for (std::vector<shared_ptr<ObjectWrapper> >::const_iterator i = wrappers.begin();
+            i != wrappers.end(); ++i)
+            registerObserver(*i);
+
+        std::vector<string> ret;
+        ret.reserve(items.size());
+        for (std::vector<StoreItem>::const_iterator i = items.begin(); i != items.end(); ++i)
+            ret.push_back(i->objectID);
+        return ret;
+    }
+
+    bool Repository::objectUnchanged(const string &objectID,
+                                     const shared_ptr<ValueObject> &valueObject) {
+        ObjectMap::const_iterator result = objectMap_.find(objectID);
+        return result != objectMap_.end() && result->second->identical(valueObject);
+    }
+
     void Repository::retrieveObject(shared_ptr<Object> &ret,
                                     const string &id) {
         ret = retrieveObjectImpl(id);
@@ -87,12 +391,19 @@ namespace reposit {
 
     shared_ptr<Object> Repository::retrieveObjectImpl(const string &objectID) {
 
-        ObjectMap::const_iterator result = objectMap_.find(formatID(objectID));
+        string buffer;
+        ObjectMap::const_iterator result = objectMap_.find(formatID(objectID, buffer));
         RP_REQUIRE(result != objectMap_.end(),
                    "reposit error: attempt to retrieve object "
                    "with unknown ID '" << objectID << "'");
+        // A clean Object is returned without locking.  A dirty one is
+        // recreated under the lock, unless another thread has done so while
+        // this one waited.  Objects are only marked dirty under exclusive
+        // access, so the flag cannot be set again in the meantime.
         if(result->second->dirty()) {
-            result->second->recreate();
+            boost::recursive_mutex::scoped_lock lock(recreateMutex_);
+            if(result->second->dirty())
+                result->second->recreate();
         }
         return result->second->object();
     }
@@ -114,20 +425,35 @@ namespace reposit {
 
         const set<string>& relationObs =
             objWrapper->object()->properties()->getPrecedentObjects();
+        string buffer;
         set<string>::const_iterator iter = relationObs.begin();
         for(; iter != relationObs.end();  iter++) {
-            shared_ptr<ObjectWrapper> objServable =
-                                            getObjectWrapper(formatID(*iter));
-            objWrapper->registerWith(objServable);
+            objWrapper->registerWith(getObjectWrapper(formatID(*iter, buffer)));
+        }
+    }
+
+    void Repository::requirePrecedents(const string &objectID,
+                                       const shared_ptr<Object> &object,
+                                       const std::set<string, my_iless> &batchIDs) {
+
+        const set<string>& relationObs = object->properties()->getPrecedentObjects();
+        string buffer;
+        for (set<string>::const_iterator i = relationObs.begin(); i != relationObs.end(); ++i) {
+            const string &precedentID = formatID(*i, buffer);
+            RP_REQUIRE(batchIDs.count(precedentID) || objectMap_.count(precedentID),
+                       "Cannot store object with ID '" << objectID << "' because its precedent '" <<
+                       precedentID << "' is neither in the list nor in the Repository");
         }
     }
 
     void Repository::deleteObject(const string &objectID) {
-        string realID = formatID(objectID);
-        RP_REQUIRE(objectExists(realID),
+        string buffer;
+        const string &realID = formatID(objectID, buffer);
+        ObjectMap::iterator result = objectMap_.find(realID);
+        RP_REQUIRE(result != objectMap_.end(),
                    "Cannot delete '" << realID << "' because no Object with "
                    "that ID is present in the Repository");
-        objectMap_.erase(realID);
+        eraseObject(result);
     }
 
     void Repository::deleteObject(const std::vector<string> &objectIDs) {
@@ -141,18 +467,61 @@ namespace reposit {
     void Repository::deleteAllObjects(const bool &deletePermanent) {
 
         if (deletePermanent) {
+            if (deferredDestruction_) {
+                boost::mutex::scoped_lock lock(reclamationMutex_);
+                for (ObjectMap::const_iterator i = objectMap_.begin(); i != objectMap_.end(); ++i)
+                    reclamationQueue_.push_back(i->second);
+                reclamationCondition_.notify_one();
+            }
+            transientObjects_.clear();
+            classIndex_.clear();
+            dependentIndex_.clear();
             objectMap_.clear();
         } else {
-            ObjectMap::iterator i = objectMap_.begin();
-            while (i != objectMap_.end()) {
-                if (i->second->object()->permanent())
-                    ++i;
-                else
-                    objectMap_.erase(i++);                    
-            }
+            // Visit only the transient Objects.
+            Partition transientObjects;
+            transientObjects.swap(transientObjects_);
+            for (Partition::const_iterator i = transientObjects.begin(); i != transientObjects.end(); ++i)
+                eraseObject(*i);
         }
     }
 
+    void Repository::setDeferredDestruction(bool deferred) {
+        deferredDestruction_ = deferred;
+        if (!deferred) {
+            stopReclamationThread();
+            reclaimObjects();
+        }
+    }
+
+    bool Repository::deferredDestruction() const {
+        return deferredDestruction_;
+    }
+
+    std::size_t Repository::reclaimObjects(std::size_t maxObjects) {
+        return reclaim(maxObjects);
+    }
+
+    void Repository::startReclamationThread(std::size_t sliceSize) {
+        RP_REQUIRE(sliceSize > 0, "Invalid value for reclamation slice size: " << sliceSize);
+        if (reclamationThread_)
+            return;
+        stopReclamation_ = false;
+        reclamationThread_.reset(new boost::thread(boost::bind(reclamationLoop, sliceSize)));
+    }
+
+    void Repository::stopReclamationThread() {
+        if (!reclamationThread_)
+            return;
+        {
+            boost::mutex::scoped_lock lock(reclamationMutex_);
+            stopReclamation_ = true;
+            reclamationCondition_.notify_all();
+        }
+        reclamationThread_->join();
+        reclamationThread_.reset();
+    }
+
     void Repository::dump(std::ostream& out) {
 
         out << "dump of all objects in reposit:" << endl << endl;
@@ -165,7 +534,8 @@ namespace reposit {
 
     void Repository::dumpObject(const string &objectID, std::ostream &out) {
 
-        string realID = formatID(objectID);
+        string buffer;
+        const string &realID = formatID(objectID, buffer);
         ObjectMap::const_iterator result = objectMap_.find(realID);
         if (result == objectMap_.end()) {
             out << "no object in repository with ID = " << realID << endl;
@@ -182,18 +552,58 @@ namespace reposit {
     const std::vector<string> Repository::listObjectIDs(const string &regex) {
 
         std::vector<string> objectIDs;
-        if (regex.empty()) {
+        shared_ptr<const PatternMatcher> matcher;
+        if (!regex.empty())
+            matcher = cachedMatcher(regex);
+        if (!matcher || matcher->matchesAll()) {
             objectIDs.reserve(objectMap_.size());
             ObjectMap::const_iterator i;
             for (i=objectMap_.begin(); i!=objectMap_.end(); ++i)
                 objectIDs.push_back(i->first);
         } else {
-            boost::regex r(regex, boost::regex::perl | boost::regex::icase);
-            ObjectMap::const_iterator i;
-            for (i=objectMap_.begin(); i!=objectMap_.end(); ++i) {
-                string objectID = i->first;
-                if (regex_match(objectID, r))
-                    objectIDs.push_back(objectID);
+            // objectMap_ is ordered case insensitively, so the IDs which begin
+            // with the literal prefix of the pattern, if any, are contiguous.
+            const string prefix = matcher->prefix();
+            ObjectMap::const_iterator i = prefix.empty() ?
+                objectMap_.begin() : objectMap_.lower_bound(prefix);
+            for (; i!=objectMap_.end() && hasPrefix(i->first, prefix); ++i) {
+                if (matcher->matches(i->first))
+                    objectIDs.push_back(i->first);
+            }
+        }
+        return objectIDs;
+    }
+
+    const std::vector<string> Repository::listClassNames() {
+        std::vector<string> classNames;
+        classNames.reserve(classIndex_.size());
+        for (ClassIndex::const_iterator i = classIndex_.begin(); i != classIndex_.end(); ++i)
+            classNames.push_back(i->first);
+        return classNames;
+    }
+
+    int Repository::objectCount(const string &className) {
+        ClassIndex::const_iterator i = classIndex_.find(className);
+        return i == classIndex_.end() ? 0 : i->second.size();
+    }
+
+    const std::vector<string> Repository::listObjectIDsByClass(const string &className,
+                                                              const string &regex) {
+        std::vector<string> objectIDs;
+        ClassIndex::const_iterator result = classIndex_.find(className);
+        if (result == classIndex_.end())
+            return objectIDs;
+        const PositionSet &objects = result->second;
+        PositionSet::const_iterator i;
+        if (regex.empty()) {
+            objectIDs.reserve(objects.size());
+            for (i = objects.begin(); i != objects.end(); ++i)
+                objectIDs.push_back((*i)->first);
+        } else {
+            shared_ptr<const PatternMatcher> matcher = cachedMatcher(regex);
+            for (i = objects.begin(); i != objects.end(); ++i) {
+                if (matcher->matches((*i)->first))
+                    objectIDs.push_back((*i)->first);
             }
         }
         return objectIDs;
@@ -206,10 +616,12 @@ namespace reposit {
     std::vector<bool>
     Repository::objectExists(const std::vector<string> &objectList) {
         std::vector<bool> ret;
+        ret.reserve(objectList.size());
 
+        string buffer;
         std::vector<string>::const_iterator i;
         for (i = objectList.begin(); i != objectList.end(); ++i) {
-                ret.push_back(objectExists(formatID(*i)));
+                ret.push_back(objectExists(formatID(*i, buffer)));
         }
 
         return ret;
@@ -218,12 +630,13 @@ namespace reposit {
     std::vector<double>
     Repository::creationTime(const std::vector<string> &objectList) {
         std::vector<double> ret;
+        ret.reserve(objectList.size());
 
+        string buffer;
         std::vector<string>::const_iterator i;
         for (i = objectList.begin(); i != objectList.end(); ++i) {
-            string realID = formatID(*i);
-            if(objectExists(realID)){
-                ObjectMap::const_iterator result = objectMap_.find(realID);
+            ObjectMap::const_iterator result = objectMap_.find(formatID(*i, buffer));
+            if (result != objectMap_.end()) {
                 ret.push_back(result->second->creationTime());
             } else {
                 RP_FAIL("Unable to retrieve object with ID "<<*i);
@@ -235,13 +648,14 @@ namespace reposit {
     std::vector<double>
     Repository::updateTime(const std::vector<string> &objectList) {
         std::vector<double> ret;
+        ret.reserve(objectList.size());
 
+        string buffer;
         for (std::vector<string>::const_iterator i = objectList.begin();
             i != objectList.end(); ++i) {
 
-                string realID = formatID(*i);
-                if (objectExists(realID)){
-                    ObjectMap::const_iterator result = objectMap_.find(realID);
+                ObjectMap::const_iterator result = objectMap_.find(formatID(*i, buffer));
+                if (result != objectMap_.end()) {
                     ret.push_back( result->second->updateTime());
                 } else {
                     RP_FAIL("Unable to retrieve object with ID "<<*i);
@@ -252,10 +666,9 @@ namespace reposit {
 
     const std::vector<string>
     Repository::precedentIDs(const string &objectID) {
-        string realID = formatID(objectID);
-        if (objectExists(realID)){
-			ObjectMap::const_iterator result = objectMap_.find(realID);
-
+        string buffer;
+        ObjectMap::const_iterator result = objectMap_.find(formatID(objectID, buffer));
+        if (result != objectMap_.end()) {
 			shared_ptr<Object> object = result->second->object();
 			shared_ptr<Group> group = boost::dynamic_pointer_cast<Group>(object);
 
@@ -267,7 +680,7 @@ namespace reposit {
 			std::vector<string> vecRelationObs;
 			set<string>::const_iterator it = relationObs.begin();
 			for(; it != relationObs.end(); ++it){
-				vecRelationObs.push_back(formatID(*it));
+				vecRelationObs.push_back(formatID(*it, buffer));
 			}
 			return vecRelationObs;
         } else {
@@ -275,6 +688,40 @@ namespace reposit {
         }
     }
 
+    const std::vector<string>
+    Repository::dependentIDs(const string &objectID, bool transitive) {
+        string buffer;
+        const string &realID = formatID(objectID, buffer);
+        RP_REQUIRE(objectExists(realID), "Unable to retrieve object with ID " << objectID);
+
+        std::vector<string> ret;
+        DependentIndex::const_iterator result = dependentIndex_.find(realID);
+        if (result == dependentIndex_.end())
+            return ret;
+
+        PositionSet dependents(result->second);
+        if (transitive) {
+            // Search the dependents of the dependents, visiting each once.
+            std::vector<ObjectMap::iterator> pending(dependents.begin(), dependents.end());
+            while (!pending.empty()) {
+                ObjectMap::iterator position = pending.back();
+                pending.pop_back();
+                DependentIndex::const_iterator next = dependentIndex_.find(position->first);
+                if (next == dependentIndex_.end())
+                    continue;
+                for (PositionSet::const_iterator i = next->second.begin(); i != next->second.end(); ++i) {
+                    if (dependents.insert(*i).second)
+                        pending.push_back(*i);
+                }
+            }
+        }
+
+        ret.reserve(dependents.size());
+        for (PositionSet::const_iterator i = dependents.begin(); i != dependents.end(); ++i)
+            ret.push_back((*i)->first);
+        return ret;
+    }
+
 	const std::vector<string>
     Repository::precedentIDs(const shared_ptr<Group>& group) {
 		std::vector<string> ret;
@@ -291,12 +738,13 @@ namespace reposit {
     std::vector<bool>
     Repository::isPermanent(const std::vector<string> &objectList) {
         std::vector<bool> ret;
+        ret.reserve(objectList.size());
 
+        string buffer;
         std::vector<string>::const_iterator i;
         for (i = objectList.begin(); i != objectList.end(); ++i) {
-            string realID = formatID(*i);
-            if (objectExists(realID)){
-                ObjectMap::const_iterator result = objectMap_.find(realID);
+            ObjectMap::const_iterator result = objectMap_.find(formatID(*i, buffer));
+            if (result != objectMap_.end()) {
                 ret.push_back(result->second->object()->permanent());
             } else {
                 RP_FAIL("Unable to retrieve object with ID "<<*i);
@@ -308,13 +756,13 @@ namespace reposit {
     const std::vector<string>
     Repository::className(const std::vector<string> &objectList) {
         std::vector<string> ret;
+        ret.reserve(objectList.size());
 
+        string buffer;
         std::vector<string>::const_iterator i;
         for (i = objectList.begin(); i != objectList.end(); ++i) {
-            string realID = formatID(*i);
-            if (objectExists(realID)){
-
-                ObjectMap::const_iterator result = objectMap_.find(realID);
+            ObjectMap::const_iterator result = objectMap_.find(formatID(*i, buffer));
+            if (result != objectMap_.end()) {
 
                 ret.push_back(result->second->object()->properties()->className());
 
@@ -325,9 +773,13 @@ namespace reposit {
         return ret;
     }
 
-    string Repository::formatID(const string &objectID) {
+    const string &Repository::formatID(const string &objectID, string &) {
         return objectID;
     }
 
+    Repository::FormatIDReplaced Repository::formatID(const string &) {
+        return FormatIDReplaced();
+    }
+
 }
 
@@ -29,6 +29,7 @@
 #include <rp/rpdefines.hpp>
 #include <rp/iless.hpp>
 #include <map>
+#include <set>
 
 //! reposit
 /*! Namespace for reposit functionality.
@@ -38,6 +39,49 @@ namespace reposit {
 	//! Forward declarations
 	class Group;
 
+    //! The arguments to one Object in a call to Repository::storeObjects().
+    struct StoreItem {
+        //! Constructor
+        StoreItem(const std::string &objectID,
+                  const boost::shared_ptr<Object> &object,
+                  const boost::shared_ptr<ValueObject> &valueObject = boost::shared_ptr<ValueObject>())
+            : objectID(objectID), object(object), valueObject(valueObject) {}
+        //! ID of the Object
+        std::string objectID;
+        //! The Object to be stored
+        boost::shared_ptr<Object> object;
+        //! The ValueObject of the Object, may be null
+        boost::shared_ptr<ValueObject> valueObject;
+    };
+
+    //! Hold shared access to the Repository for the lifetime of this object.
+    /*! Any number of threads may hold shared access at once, so that functions
+        which only query the Repository may run concurrently.  Shared access
+        excludes exclusive access, see RepositoryWriteLock.
+    */
+    class DLL_API RepositoryReadLock {
+    public:
+        RepositoryReadLock();
+        ~RepositoryReadLock();
+    private:
+        RepositoryReadLock(const RepositoryReadLock&);
+        RepositoryReadLock &operator=(const RepositoryReadLock&);
+    };
+
+    //! Hold exclusive access to the Repository for the lifetime of this object.
+    /*! Any function which may modify the Repository, or any other state of
+        the client application, must hold exclusive access if other threads
+        may be querying the Repository at the same time.
+    */
+    class DLL_API RepositoryWriteLock {
+    public:
+        RepositoryWriteLock();
+        ~RepositoryWriteLock();
+    private:
+        RepositoryWriteLock(const RepositoryWriteLock&);
+        RepositoryWriteLock &operator=(const RepositoryWriteLock&);
+    };
+
     //! Maintain a store of Objects.
     /*! The client application may store, retrieve, and delete Objects in
         the Repository.
@@ -49,6 +93,14 @@ namespace reposit {
 
         This class is designed so that it can be exported across DLL
         boundaries on the Windows platform.
+
+        The Repository does not synchronize its own member functions.  A
+        client application which calls the Repository from more than one
+        thread must hold a RepositoryReadLock or RepositoryWriteLock for the
+        duration of each call.  The one exception is the recreation of a dirty
+        Object by retrieveObject(), which is serialized internally so that
+        retrieveObject() may be called under shared access.  The retrieval
+        of a clean Object takes no lock.
     */
     class DLL_API Repository {
     public:
@@ -79,6 +131,31 @@ namespace reposit {
                                         bool overwrite = false,
                                         boost::shared_ptr<ValueObject> valueObject = boost::shared_ptr<ValueObject>());
 
+        //! Store a batch of Objects.
+        /*! Equivalent to calling storeObject() for each item, except that:
+            - The batch is validated before any Object is stored, so if an ID is
+              already in use and overwrite is false then nothing is stored.
+            - Each Object is registered as an Observer of its precedents only after
+              the whole batch has been stored, so that the items of the batch may
+              appear in any order relative to their precedents.  Each precedent
+              must be either in the batch or already in the Repository, otherwise
+              nothing is stored.
+            - If an ID occurs more than once in the batch then only the last Object
+              with that ID is stored, provided overwrite is true.
+
+            Returns the IDs of the stored Objects, in the same order as the batch.
+        */
+        virtual std::vector<std::string> storeObjects(const std::vector<StoreItem> &items,
+                                                      bool overwrite = false);
+
+        //! Determine whether the Object with the given ID was created from an identical ValueObject.
+        /*! Returns false if no Object exists with that ID.  Used when reloading
+            serialized Objects, to avoid recreating an Object whose inputs are
+            unchanged and thereby invalidating its dependents.
+        */
+        virtual bool objectUnchanged(const std::string &objectID,
+                                     const boost::shared_ptr<ValueObject> &valueObject);
+
         //! Template member function to retrieve the Object with given ID.
         /*! Retrieve the object with the given ID and downcast it to the desired type.
             Throw an exception if no Object exists with that ID.
@@ -129,6 +206,43 @@ namespace reposit {
         virtual void deleteAllObjects(const bool &deletePermanent = false);
         //@}
 
+        /*! \name Deferred destruction
+            Destroying a large graph of Objects can take several seconds.  When
+            deferred destruction is enabled, the ObjectWrappers removed by
+            deleteObject() and deleteAllObjects() are moved to a reclamation
+            queue.  The deletion is visible in the Repository immediately, but
+            the Objects are destroyed later, by reclaimObjects() or by the
+            reclamation thread.
+        */
+        //@{
+        //! Enable or disable deferred destruction.
+        /*! Disabling deferred destruction stops the reclamation thread and
+            destroys any Objects remaining in the queue.
+        */
+        void setDeferredDestruction(bool deferred);
+        //! Indicate whether deferred destruction is enabled.
+        bool deferredDestruction() const;
+        //! Destroy at most maxObjects of the queued Objects, or all of them if maxObjects is zero.
+        /*! Returns the number of Objects remaining in the queue.  The caller
+            must hold exclusive access if other threads use the Repository.
+        */
+        std::size_t reclaimObjects(std::size_t maxObjects = 0);
+        //! Destroy the queued Objects on a background thread.
+        /*! The thread destroys the queue in slices of at most sliceSize
+            Objects, and holds a RepositoryWriteLock for each slice.  This is
+            suitable only for a client application which holds a
+            RepositoryReadLock or RepositoryWriteLock around every call to the
+            Repository, and whose Objects may be destroyed on any thread.
+            Take no action if the thread is already running.
+        */
+        void startReclamationThread(std::size_t sliceSize = 1000);
+        //! Stop the reclamation thread, leaving any remaining Objects in the queue.
+        /*! The thread does not block on the Repository lock, so this may be
+            called while holding a RepositoryWriteLock.
+        */
+        void stopReclamationThread();
+        //@}
+
         //! \name Logging
         //@{
         //! Log the indicated Object to the given stream.
@@ -148,7 +262,12 @@ namespace reposit {
         virtual int objectCount();
 
         //! List the IDs of all the Objects in the Repository.
-        /*! Returns an empty list if the Repository is empty.
+        /*! If regex is not empty then only the IDs which match it are returned.
+            A pattern which begins with literal text, e.g. "EUR_SWAP_.*", visits
+            only the IDs which begin with that text.  Compiled patterns are
+            cached, see PatternMatcher.
+
+            Returns an empty list if the Repository is empty.
         */
         virtual const std::vector<std::string> listObjectIDs(
             const std::string &regex = "");
@@ -157,6 +276,24 @@ namespace reposit {
         virtual std::vector<bool> objectExists(const std::vector<std::string> &objectList);
         //@}
 
+        /*! \name Class index
+            The Repository maintains an index of its Objects by class name, so
+            that the Objects of one class may be listed or counted without
+            visiting the other Objects.  Class names are case insensitive.
+        */
+        //@{
+        //! List the names of the classes of the Objects in the Repository.
+        virtual const std::vector<std::string> listClassNames();
+        //! Count of the Objects of the given class.
+        virtual int objectCount(const std::string &className);
+        //! List the IDs of the Objects of the given class.
+        /*! If regex is not empty then only the IDs which match it are returned.
+            Returns an empty list if there are no Objects of the given class.
+        */
+        virtual const std::vector<std::string> listObjectIDsByClass(
+            const std::string &className, const std::string &regex = "");
+        //@}
+
         //! Define the type of the structure used to store the Objects.
         /*! The Repository class cannot declare a private data member of type
             ObjectMap, because std::map cannot be exported across DLL boundaries
@@ -165,10 +302,22 @@ namespace reposit {
         */
         typedef std::map<std::string, boost::shared_ptr<ObjectWrapper>, my_iless> ObjectMap;
 
-        //! \name Precedent object IDs and timestamps
+        //! \name Precedent and dependent object IDs and timestamps
         //@{
         //! Retrieve the list of IDs of precedent objects
         virtual const std::vector<std::string> precedentIDs(const std::string &objectID);
+        //! Retrieve the list of IDs of the objects which depend on the given object.
+        /*! An object depends on the objects listed in the precedents of its
+            ValueObject, and is invalidated if any of them changes.  If
+            transitive is true then the dependents of the dependents are also
+            included, recursively.  The IDs are returned in sorted order.
+
+            The Repository maintains an index of dependents, so the time taken
+            is proportional to the number of dependents rather than to the
+            number of objects in the Repository.
+        */
+        virtual const std::vector<std::string> dependentIDs(const std::string &objectID,
+                                                            bool transitive = false);
         //! The object's initial creation time
         virtual std::vector<double> creationTime(const std::vector<std::string> &objectList);
         //! The time of the object's last update
@@ -196,11 +345,60 @@ namespace reposit {
         virtual void registerObserver( 
             boost::shared_ptr<ObjectWrapper> objWrapper);
 
+        //! Check that each precedent of the given Object can be found.
+        /*! A precedent must either be among batchIDs, the IDs of a batch about
+            to be stored, or be present in the Repository.  storeObjects() calls
+            this before storing anything, so that registerObserver() cannot fail
+            partway through the batch.
+        */
+        void requirePrecedents(const std::string &objectID,
+                               const boost::shared_ptr<Object> &object,
+                               const std::set<std::string, my_iless> &batchIDs);
+
         //! Convert Excel-format Object IDs into the format recognized by the base Repository class
         /*! The functiong will be used in derived class(e.g in class
             repositoryXL it will change the objectID custom_#0001 into custom);
+
+            To avoid copying the ID on every lookup, the function returns a reference
+            to the ID itself if no conversion is required, otherwise the converted
+            ID is written to the buffer and a reference to the buffer is returned.
+            The result is valid for as long as both arguments.
+
+            This replaces the single argument formatID() of earlier releases,
+            which returned the converted ID by value.  A derived class which
+            still overrides that signature fails to compile, see below, and
+            must be changed to override this one.
         */
-        virtual std::string formatID(const std::string &objectID);
+        virtual const std::string &formatID(const std::string &objectID, std::string &buffer);
+
+        /*! \name Secondary indexes
+            The Repository maintains indexes of the ObjectMap in addition to the
+            map itself.  A derived class which modifies the ObjectMap directly
+            must keep the indexes up to date with these functions.
+        */
+        //@{
+        //! Add the element at the given position of the ObjectMap to the indexes.
+        /*! Call after inserting the element, or after replacing its Object.
+        */
+        void indexObject(ObjectMap::iterator position);
+        //! Remove the element at the given position of the ObjectMap from the indexes.
+        /*! Call before replacing the element's Object.
+        */
+        void unindexObject(ObjectMap::iterator position);
+        //! Remove the element at the given position from the ObjectMap and from the indexes.
+        /*! Destruction of the element's ObjectWrapper is deferred if deferred
+            destruction is enabled.
+        */
+        void eraseObject(ObjectMap::iterator position);
+        //@}
+
+        //! Search the ObjectMap for the given ID.
+        /*! Return true if the ID is found, in which case position is set to the
+            corresponding element.  Otherwise return false and set position to the
+            element before which the ID would be inserted, for use as the hint
+            for the insertion.
+        */
+        static bool lookupObject(const std::string &objectID, ObjectMap::iterator &position);
 
         //! Indicate whether an Object with the given ID is found in the Repository.
         virtual bool objectExists(const std::string &objectID) const;
@@ -208,6 +406,20 @@ namespace reposit {
         //! Retrieve the list of IDs of precedent objects containde in this group
 		virtual const std::vector<std::string> precedentIDs(const boost::shared_ptr<Group>& group);
 
+    private:
+        //! Placeholder for the single argument formatID() of earlier releases.
+        /*! A derived class which still overrides formatID(const std::string&)
+            fails to compile, with a conflicting return type, rather than
+            silently declaring a function which is never called.  Override the
+            two argument formatID() instead.
+
+            The placeholder is virtual, so it adds a slot to the vtable of this
+            class, which is exported across the DLL boundary.  Clients must be
+            rebuilt against this header.
+        */
+        struct FormatIDReplaced {};
+        virtual FormatIDReplaced formatID(const std::string &objectID);
+
     };
 
 }
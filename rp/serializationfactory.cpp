@@ -28,6 +28,7 @@
 #include <rp/group.hpp>
 #include <rp/repository.hpp>
 #include <rp/conversions/getobjectvector.hpp>
+#include <rp/patternmatcher.hpp>
 
 //#if BOOST_VERSION > 105000
     //#define BOOST_FILESYSTEM_VERSION 3
@@ -35,13 +36,14 @@
     #define BOOST_FILESYSTEM_VERSION 2
 #endif
 
-#include <boost/regex.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/serialization/variant.hpp>
 #include <boost/serialization/vector.hpp>
 #include <boost/serialization/shared_ptr.hpp>
 
 #include <fstream>
+#include <sstream>
+#include <ctime>
 
 namespace reposit {
 
@@ -68,9 +70,85 @@ namespace reposit {
 				boost::get<bool>(valueObject->getProperty("PERMANENT"))));
     }
 
+    namespace {
+
+        // The result of a previous call to SerializationFactory::scanDirectory().
+        struct DirectoryManifest {
+            // The time at which the scan started.
+            std::time_t scanTime;
+            // Each directory visited by the scan, with its last write time.
+            std::vector<std::pair<boost::filesystem::path, std::time_t> > directories;
+            // The files which matched the pattern, in the order they were found.
+            std::vector<std::string> files;
+        };
+
+        // std::map cannot be exported across DLL boundaries
+        // so instead we use a static variable.
+        typedef std::map<std::string, DirectoryManifest> ManifestMap;
+        ManifestMap manifestMap_;
+
+        // Determine whether anything has been added to or removed from
+        // the directories covered by the manifest since it was written.
+        // Write times have a resolution of one second, so a directory written
+        // in the second in which the scan started, or later, may have changed
+        // after it was scanned without a change to its write time, and is
+        // never trusted.
+        bool manifestCurrent(const DirectoryManifest &manifest) {
+            try {
+                for (std::vector<std::pair<boost::filesystem::path, std::time_t> >::const_iterator
+                    i = manifest.directories.begin(); i != manifest.directories.end(); ++i) {
+                    if (i->second >= manifest.scanTime
+                        || boost::filesystem::last_write_time(i->first) != i->second)
+                        return false;
+                }
+                return true;
+            } catch (const std::exception&) {
+                // e.g. one of the directories has been deleted.
+                return false;
+            }
+        }
+
+        // Write to the manifest the regular files in the given directory
+        // whose names match the pattern.  The traversal visits entries in
+        // the same sequence as boost::filesystem::recursive_directory_iterator.
+        void scanPath(
+            const boost::filesystem::path &directory,
+            const PatternMatcher &matcher,
+            bool recurse,
+            DirectoryManifest &manifest) {
+
+            manifest.directories.push_back(std::make_pair(
+                directory, boost::filesystem::last_write_time(directory)));
+
+            for (boost::filesystem::directory_iterator itr(directory);
+                itr != boost::filesystem::directory_iterator(); ++itr) {
+
+                // The directory iterator caches the file type reported by the
+                // directory listing itself, so on most platforms the tests below
+                // are answered without a call to stat().  Test the type before
+                // the name so that subdirectories never reach the matcher.
+                if (boost::filesystem::is_directory(itr->symlink_status())) {
+                    if (recurse)
+                        scanPath(itr->path(), matcher, recurse, manifest);
+                    continue;
+                }
+                if (!boost::filesystem::is_regular(itr->status()))
+                    continue;
+
+#if BOOST_VERSION < 105000
+                if (matcher.matches(itr->path().leaf()))
+#else
+                if (matcher.matches(itr->path().leaf().string()))
+#endif
+                    manifest.files.push_back(itr->path().string());
+            }
+        }
+    }
+
     SerializationFactory *SerializationFactory::instance_;
 
-    SerializationFactory::SerializationFactory() {
+    SerializationFactory::SerializationFactory()
+        : cacheDirectoryScans_(false), skippedObjectCount_(0) {
         instance_ = this;
         registerCreator("rpRange", createRange);
         registerCreator("rpGroup", createGroup);
@@ -112,10 +190,20 @@ namespace reposit {
         bool overwriteExisting) const {
 
         StrObjectPair object;
-        object.second = recreateObject(valueObject);
 
         // FIXME just call ValueObject::objectId()?
         object.first = boost::get<std::string>(valueObject->getProperty("OBJECTID"));
+
+        // If the existing Object was created from identical inputs then keep it,
+        // resetting it would only cause all of its dependents to be recreated.
+        if (overwriteExisting
+            && reposit::Repository::instance().objectUnchanged(object.first, valueObject)) {
+            reposit::Repository::instance().retrieveObject(object.second, object.first);
+            skippedObjectCount_++;
+            return object;
+        }
+
+        object.second = recreateObject(valueObject);
         reposit::Repository::instance().storeObject(object.first, object.second, overwriteExisting);
 
         return object;
@@ -269,54 +357,60 @@ namespace reposit {
         RP_REQUIRE(boost::filesystem::exists(boostPath) && boost::filesystem::is_directory(boostPath),
             "The specified directory is not valid : " << directory);
 
-        std::vector<std::string> returnValue;
-        bool fileFound = false;
-        boost::regex r(pattern, boost::regex::perl | boost::regex::icase);
-
-        if (recurse) {
-
-            for (boost::filesystem::recursive_directory_iterator itr(boostPath);
-                itr != boost::filesystem::recursive_directory_iterator(); ++itr) {
-#if BOOST_VERSION < 105000
-                    if (regex_match(itr->path().leaf(), r) &&
-#else
-                    if (regex_match(itr->path().leaf().string(), r) &&
-#endif
-                                    boost::filesystem::is_regular(itr->status())) {
-                        fileFound = true;
-                        processPath(itr->path().string(), overwriteExisting, returnValue);
-                    }
-            }
-
-        } else {
+        std::vector<std::string> paths = scanDirectory(directory, pattern, recurse);
 
-            for (boost::filesystem::directory_iterator itr(boostPath);
-                itr != boost::filesystem::directory_iterator(); ++itr) {
-#if BOOST_VERSION < 105000
-                    if (regex_match(itr->path().leaf(), r) &&
-#else
-                    if (regex_match(itr->path().leaf().string(), r) &&
-#endif
-                                    boost::filesystem::is_regular(itr->status())) {
-                        fileFound = true;
-                        processPath(itr->path().string(), overwriteExisting, returnValue);
-                    }
-            }
-
-        }
-
-        RP_REQUIRE(fileFound, "Found no files matching pattern '" << pattern << "' in directory '"
+        RP_REQUIRE(!paths.empty(), "Found no files matching pattern '" << pattern << "' in directory '"
             << directory << "' with recursion = " << std::boolalpha << recurse);
 
+        skippedObjectCount_ = 0;
+        std::vector<std::string> returnValue;
+        for (std::vector<std::string>::const_iterator i = paths.begin(); i != paths.end(); ++i)
+            processPath(*i, overwriteExisting, returnValue);
+
         // processPath() will already have thrown if empty files were detected
         // so the following is a redundant sanity check.
         RP_REQUIRE(!returnValue.empty(), "No objects loaded from directory : " << directory);
 
         ProcessorFactory::instance().postProcess();
 
+        if (skippedObjectCount_)
+            RP_LOG_MESSAGE("Loaded " << returnValue.size() << " object(s) from directory " << directory
+                << ", of which " << skippedObjectCount_ << " were unchanged and not recreated");
+
         return returnValue;
     }
 
+    std::vector<std::string> SerializationFactory::scanDirectory(
+        const std::string &directory,
+        const std::string &pattern,
+        bool recurse) {
+
+        if (!cacheDirectoryScans_) {
+            DirectoryManifest manifest;
+            manifest.scanTime = std::time(0);
+            scanPath(directory, PatternMatcher(pattern), recurse, manifest);
+            return manifest.files;
+        }
+
+        std::ostringstream key;
+        key << directory << '\n' << pattern << '\n' << recurse;
+        ManifestMap::iterator i = manifestMap_.find(key.str());
+        if (i == manifestMap_.end() || !manifestCurrent(i->second)) {
+            DirectoryManifest manifest;
+            manifest.scanTime = std::time(0);
+            scanPath(directory, PatternMatcher(pattern), recurse, manifest);
+            manifestMap_[key.str()] = manifest;
+            return manifest.files;
+        }
+        return i->second.files;
+    }
+
+    void SerializationFactory::setCacheDirectoryScans(bool cacheDirectoryScans) {
+        cacheDirectoryScans_ = cacheDirectoryScans;
+        if (!cacheDirectoryScans_)
+            manifestMap_.clear();
+    }
+
     std::string SerializationFactory::saveObjectString(
         const std::vector<boost::shared_ptr<reposit::Object> > &objectList,
         bool forceOverwrite /* TODO : we need to remove this arg */) {
@@ -339,6 +433,7 @@ namespace reposit {
         bool overwriteExisting) {
 
         std::vector<std::string> returnValue;
+        skippedObjectCount_ = 0;
 
         try {
             boost::archive::xml_iarchive ia(xmlStream);
@@ -368,6 +463,10 @@ namespace reposit {
 
         RP_REQUIRE(!returnValue.empty(), "No objects loaded from xml");
 
+        if (skippedObjectCount_)
+            RP_LOG_MESSAGE("Loaded " << returnValue.size() << " object(s) from xml, of which "
+                << skippedObjectCount_ << " were unchanged and not recreated");
+
         return returnValue;
     }
 
@@ -107,6 +107,26 @@ namespace reposit {
             bool overwriteExisting);
         //@}
 
+        //! \name Directory Scanning
+        //@{
+        //! Enable or disable the cache of directory scans performed by loadObject().
+        /*! When the cache is enabled, the list of files found by loadObject() for
+            a given directory, pattern and recursion flag is retained, and reused
+            on subsequent calls for as long as the last write time of every
+            directory visited by the original scan remains unchanged.  A file
+            added to or removed from any of those directories invalidates the
+            cached list.  Write times are compared to the second, so a directory
+            written in the second in which the scan started, or later, is
+            scanned again on every call until the list is replaced by a later
+            scan.
+
+            The cache is disabled by default.
+        */
+        void setCacheDirectoryScans(bool cacheDirectoryScans);
+        //! Indicate whether the cache of directory scans is enabled.
+        bool cacheDirectoryScans() const { return cacheDirectoryScans_; }
+        //@}
+
         //! \name Object Creation
         //@{
         //! Recreate an Object from its ValueObject
@@ -116,10 +136,16 @@ namespace reposit {
         /*! This function calls recreateObject to recreate the Object from its
             ValueObject then stores the newly created Object in the Repository
             with a call to Repository::storeObject().
+
+            If overwriteExisting is true and the Repository already holds an Object
+            created from an identical ValueObject, then the existing Object is
+            retained, so that Objects which depend on it are not invalidated.
         */
         StrObjectPair restoreObject(
             const boost::shared_ptr<reposit::ValueObject> &valueObject,
             bool overwriteExisting) const;
+        //! The number of Objects retained unchanged by the most recent load.
+        int skippedObjectCount() const { return skippedObjectCount_; }
         //@}
 
       protected:
@@ -128,6 +154,14 @@ namespace reposit {
             const std::string &path,
             bool overwriteExisting,
             std::vector<std::string> &processedIDs);
+        //! List the regular files in the directory whose names match the pattern.
+        /*! The pattern is a case insensitive perl regular expression, see
+            class PatternMatcher.
+        */
+        std::vector<std::string> scanDirectory(
+            const std::string &directory,
+            const std::string &pattern,
+            bool recurse);
         /*virtual std::string processObject(
             const boost::shared_ptr<reposit::ValueObject> &valueObject,
             bool overwriteExisting);*/
@@ -147,6 +181,10 @@ namespace reposit {
         // Cannot export std::map across DLL boundaries, so instead of a data member
         // use a private member function that wraps a reference to a static variable.
         CreatorMap &creatorMap_() const;
+        // Flag indicating whether the results of scanDirectory() are cached.
+        bool cacheDirectoryScans_;
+        // Count of Objects retained unchanged by restoreObject().
+        mutable int skippedObjectCount_;
     };
 
 }
@@ -31,6 +31,12 @@
 #include <sstream>
 #include <ctime>
 #include <sys/timeb.h>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
 #include <iostream>
 
 #define SECS_PER_DAY        (60 * 60 * 24)
@@ -280,6 +286,52 @@ namespace reposit {
 
     }
 
+    namespace {
+
+        // The number of ticks returned by getTick() in one second.
+        double tickFrequency() {
+#if defined(_WIN32)
+            LARGE_INTEGER frequency;
+            QueryPerformanceFrequency(&frequency);
+            return static_cast<double>(frequency.QuadPart);
+#else
+            return 1e9;
+#endif
+        }
+
+        // Readings of the wall clock and of the monotonic clock taken together
+        // when the library is loaded, used as the origin for tickToTime().
+        struct TickBase {
+            TickBase() : time(getTime()), tick(getTick()),
+                ticksPerDay(tickFrequency() * SECS_PER_DAY) {}
+            double time;
+            Tick tick;
+            double ticksPerDay;
+        };
+
+        const TickBase tickBase;
+    }
+
+    Tick getTick() {
+#if defined(_WIN32)
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        return counter.QuadPart;
+#else
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<Tick>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+#endif
+    }
+
+    double tickToTime(Tick tick) {
+        // A tick read before tickBase was initialized precedes the origin.
+        double elapsed = tick >= tickBase.tick
+            ? static_cast<double>(tick - tickBase.tick)
+            : -static_cast<double>(tickBase.tick - tick);
+        return tickBase.time + elapsed / tickBase.ticksPerDay;
+    }
+
     std::string formatTime(double tm){
 
         unsigned long long years, monthes, days, hours, minutes, seconds, milliseconds;
@@ -113,6 +113,20 @@ namespace reposit {
     double getTime();
     //! Return the given time as a string in format HH:MM:SS.
     std::string formatTime(double tm);
+    //! A raw reading of the monotonic clock.
+    typedef unsigned long long Tick;
+    //! Read the monotonic clock.
+    /*! This is much cheaper than getTime(), which takes the libc timezone
+        lock, and is suitable for timestamping events which are queried
+        rarely.  Use tickToTime() to convert the result.
+    */
+    Tick getTick();
+    //! Convert a value returned by getTick() to the representation returned by getTime().
+    /*! The conversion is relative to a reading of both clocks taken when
+        the library is loaded, so subsequent adjustments to the wall clock
+        (e.g. daylight saving) are not reflected.
+    */
+    double tickToTime(Tick tick);
     //@}
 
     /** \name logFile and logLevel
@@ -32,6 +32,7 @@
 #include <set>
 #include <algorithm>
 #include <rp/property.hpp>
+#include <rp/allocator.hpp>
 #include <rp/utilities.hpp>
 #include <boost/serialization/access.hpp>
 
@@ -106,6 +107,17 @@ namespace reposit {
         const std::string &className() const { return className_; }
         //@}
 
+        //! \name Comparison
+        //@{
+        //! Compute a hash of the class name and the values of all properties.
+        /*! The Object ID does not contribute to the hash, so that the contents
+            of ValueObjects with different IDs may be compared.
+        */
+        std::size_t contentHash() const;
+        //! Determine whether the given ValueObject has the same class and property values as this one.
+        bool contentEquals(const ValueObject &other) const;
+        //@}
+
         //! \name processorName
         //@{
         //! the name of the processor that is required for that ValueObject;
@@ -187,6 +199,31 @@ namespace reposit {
             return getSystemProperty(name);
     }
 
+    inline std::size_t ValueObject::contentHash() const {
+        std::size_t seed = 0;
+        boost::hash_combine(seed, className_);
+        boost::hash_combine(seed, permanent_);
+        std::vector<std::string> names = getPropertyNamesVector();
+        for (std::vector<std::string>::const_iterator i = names.begin(); i != names.end(); ++i) {
+            boost::hash_combine(seed, *i);
+            boost::hash_combine(seed, propertyHash(getProperty(*i)));
+        }
+        return seed;
+    }
+
+    inline bool ValueObject::contentEquals(const ValueObject &other) const {
+        if (className_ != other.className_ || permanent_ != other.permanent_)
+            return false;
+        std::vector<std::string> names = getPropertyNamesVector();
+        if (names != other.getPropertyNamesVector())
+            return false;
+        for (std::vector<std::string>::const_iterator i = names.begin(); i != names.end(); ++i) {
+            if (!propertyEquals(getProperty(*i), other.getProperty(*i)))
+                return false;
+        }
+        return true;
+    }
+
     inline bool ValueObject::hasProperty(const std::string& name) const {
         return userProperties.find(name) != userProperties.end();
     }
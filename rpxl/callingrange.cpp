@@ -24,87 +24,287 @@
 #include <rpxl/repositoryxl.hpp>
 #include <rpxl/functioncall.hpp>
 #include <rpxl/xloper.hpp>
+#include <rp/rpdefines.hpp>
 #include <iomanip>
 #include <sstream>
-#include <cmath>
+#include <functional>
+#include <map>
+#include <queue>
+#include <vector>
 
 namespace reposit {
 
-    int CallingRange::keyCount_ = 0;
-    const int CallingRange::KEY_WIDTH = 5;
+    const int CallingRange::KEY_WIDTH = 8;
 
     namespace {
         const char counterDelimiter = '#';
+
+        // The update count which suffixes a full ID is rendered as a fixed
+        // number of decimal digits.
+        const int COUNT_WIDTH = 4;
+        const int COUNT_MAX = 9999;
+
+        // The numbers of the keys assigned to calling ranges.  The key of a
+        // deleted range is returned to freeKeys_ once its name has been deleted,
+        // and is reused before a new number is issued.  The lowest free number
+        // is reused first, so that ranges created together are numbered in
+        // the order of their creation whatever ranges were deleted before.
+        std::priority_queue<std::size_t, std::vector<std::size_t>,
+                            std::greater<std::size_t> > freeKeys_;
+        // The number of distinct key numbers issued so far.
+        std::size_t keyCount_ = 0;
+        // The number of times each key number has been reused, which
+        // distinguishes the anonymous IDs derived from the same key.
+        std::vector<std::size_t> keyGenerations_;
+
+        std::size_t allocateKey() {
+            if (!freeKeys_.empty()) {
+                std::size_t index = freeKeys_.top();
+                freeKeys_.pop();
+                ++keyGenerations_[index];
+                return index;
+            }
+            RP_REQUIRE(keyCount_ < 0xFFFFFFFFUL, "CallingRange: max key value exceeded");
+            keyGenerations_.push_back(0);
+            return keyCount_++;
+        }
+
+        void releaseKey(const std::string &key) {
+            std::size_t index;
+            if (CallingRange::parseKey(key, index))
+                freeKeys_.push(index);
+        }
+
+        // Append the given count to the string, padded with leading zeros.
+        void appendCount(std::string &s, int count) {
+            char buffer[COUNT_WIDTH];
+            for (int i = COUNT_WIDTH - 1; i >= 0; --i) {
+                buffer[i] = static_cast<char>('0' + count % 10);
+                count /= 10;
+            }
+            s.append(buffer, COUNT_WIDTH);
+        }
+
+        // Hidden names awaiting creation, keyed by the identity of the calling range.
+        typedef std::map<CallerId, std::string> PendingNameMap;
+        PendingNameMap pendingNames_;
+        // Hidden names awaiting deletion.
+        std::vector<std::string> pendingDeletions_;
+        bool deferNames_ = false;
+
+        // The keys of the calling ranges, keyed by the identity of the caller
+        // with which each range was last identified.
+        typedef std::map<CallerId, std::string> CallerKeyMap;
+        CallerKeyMap callerKeys_;
+
+        void setName(const std::string &key, const XLOPER *reference) {
+            XLOPER xRet;
+            Excel(xlfSetName, &xRet, 2, TempStrStl(key), reference);
+            RP_REQUIRE(xRet.xltype == xltypeBool && xRet.val.xbool, "Error on call to xlfSetName");
+        }
     }
 
     CallingRange::CallingRange() 
-        : updateCount_(0), callerType_(FunctionCall::instance().callerType()) {
+        : identified_(false), namePending_(false), updateCount_(0),
+          callerType_(FunctionCall::instance().callerType()) {
 
         if (callerType_ == CallerType::Cell) {
             // name the calling range
-            key_ = getKeyCount();
-            XLOPER xRet;
-            Excel(xlfSetName, &xRet, 2, TempStrStl(key_), FunctionCall::instance().callerReference());
-            //RP_REQUIRE(xRet.xltype == xltypeBool && xRet.val.boolean, "Error on call to xlfSetName");
-            RP_REQUIRE(xRet.xltype == xltypeBool && xRet.val.xbool, "Error on call to xlfSetName");
+            keyIndex_ = allocateKey();
+            keyGeneration_ = keyGenerations_[keyIndex_];
+            key_ = formatKey(keyIndex_);
+            CallerId callerId;
+            bool identified = FunctionCall::instance().callerId(callerId);
+            if (deferNames_ && identified) {
+                pendingNames_[callerId] = key_;
+                namePending_ = true;
+            } else {
+                setName(key_, FunctionCall::instance().callerReference());
+            }
+            if (identified)
+                identifyCaller(callerId);
         } else {
+            keyIndex_ = 0;
+            keyGeneration_ = 0;
             key_ = "VBA";
         }
     }
 
     CallingRange::~CallingRange() {
         // unname the calling range
-        if (callerType_ == CallerType::Cell)
+        if (callerType_ != CallerType::Cell)
+            return;
+        forgetCaller();
+        if (namePending_) {
+            // If the name has not been created yet then there is nothing to delete.
+            PendingNameMap::iterator i = pendingNames_.find(callerId_);
+            if (i != pendingNames_.end() && i->second == key_) {
+                pendingNames_.erase(i);
+                freeKeys_.push(keyIndex_);
+                return;
+            }
+        }
+        // The key is not reused until its name has been deleted.
+        if (deferNames_) {
+            pendingDeletions_.push_back(key_);
+        } else {
+            freeKeys_.push(keyIndex_);
             Excel(xlfSetName, 0, 1, TempStrStl(key_));
+        }
     }
 
-    std::string CallingRange::getKeyCount() {
-        static const int KEY_BASE = 16;
-        static const double KEY_MAX = pow((double)KEY_BASE, KEY_WIDTH);
+    void CallingRange::setDeferNames(bool deferNames) {
+        if (!deferNames)
+            flushNames();
+        deferNames_ = deferNames;
+    }
 
-        RP_REQUIRE(keyCount_ < KEY_MAX, "CallingRange::getKeyCount() : max key value exceeded");
-        std::ostringstream s;
-        s << '_' << std::setw(KEY_WIDTH) << std::setfill('0') << std::setbase(KEY_BASE) << keyCount_++;
-        return s.str();
+    bool CallingRange::deferNames() {
+        return deferNames_;
     }
 
-    void CallingRange::clearResidentObjects(bool deletePermanent) {
-        if (deletePermanent) {
-            // Iterate through the list of resident objects and delete them.
-            // Each object's dtor calls CallingRange::unregisterObject() which
-            // removes an entry from the map over which we're iterating, so we must
-            // increment the iterator before calling deleteObject().
-            ObjectXLMap::iterator i = residentObjects_.begin();
-            while (i != residentObjects_.end()) {
-                std::string objectId = i->first;
-                ++i;
-                Repository::instance().deleteObject(objectId);
+    bool CallingRange::pendingName(const CallerId &callerId, std::string &key) {
+        PendingNameMap::const_iterator i = pendingNames_.find(callerId);
+        if (i == pendingNames_.end())
+            return false;
+        key = i->second;
+        return true;
+    }
+
+    bool CallingRange::callerKey(const CallerId &callerId, std::string &key) {
+        CallerKeyMap::const_iterator i = callerKeys_.find(callerId);
+        if (i == callerKeys_.end())
+            return false;
+        key = i->second;
+        return true;
+    }
+
+    void CallingRange::identifyCaller(const CallerId &callerId) const {
+        forgetCaller();
+        callerId_ = callerId;
+        identified_ = true;
+        callerKeys_[callerId_] = key_;
+    }
+
+    void CallingRange::forgetCaller() const {
+        if (!identified_)
+            return;
+        // Another range may since have been identified with the same caller.
+        CallerKeyMap::iterator i = callerKeys_.find(callerId_);
+        if (i != callerKeys_.end() && i->second == key_)
+            callerKeys_.erase(i);
+        identified_ = false;
+    }
+
+    void CallingRange::flushNames() {
+
+        // A failure affects only the range concerned, so log it and carry on.
+        for (std::vector<std::string>::const_iterator i = pendingDeletions_.begin();
+            i != pendingDeletions_.end(); ++i) {
+            releaseKey(*i);
+            try {
+                Excel(xlfSetName, 0, 1, TempStrStl(*i));
+            } catch (const std::exception &e) {
+                RP_LOG_ERROR("Error deleting name " << *i << ": " << e.what());
             }
-            residentObjects_.clear();
-        } else {
-            ObjectXLMap::iterator i = residentObjects_.begin();
-            while (i != residentObjects_.end()) {
-                boost::shared_ptr<ObjectWrapperXL> objectXL = i->second.lock();
-                if (objectXL && objectXL->permanent()) {
-                    ++i;
-                } else {
-                    Repository::instance().deleteObject(i->first);
-                    residentObjects_.erase(i++);
-                }
+        }
+        pendingDeletions_.clear();
+
+        for (PendingNameMap::const_iterator i = pendingNames_.begin();
+            i != pendingNames_.end(); ++i) {
+            XLMREF xMref;
+            xMref.count = 1;
+            xMref.reftbl[0] = i->first.ref;
+            XLOPER xRef;
+            xRef.xltype = xltypeRef;
+            xRef.val.mref.idSheet = i->first.idSheet;
+            xRef.val.mref.lpmref = &xMref;
+            try {
+                setName(i->second, &xRef);
+            } catch (const std::exception &e) {
+                RP_LOG_ERROR("Error creating name " << i->second << ": " << e.what());
             }
         }
+        pendingNames_.clear();
+    }
+
+    std::string CallingRange::formatKey(std::size_t index) {
+        static const char digits[] = "0123456789abcdef";
+        std::string key(KEY_WIDTH + 1, '0');
+        key[0] = '_';
+        for (int i = KEY_WIDTH; i > 0; --i, index >>= 4)
+            key[i] = digits[index & 0xF];
+        return key;
+    }
+
+    bool CallingRange::parseKey(const std::string &key, std::size_t &index) {
+        if (key.length() != static_cast<std::string::size_type>(KEY_WIDTH + 1) || key[0] != '_')
+            return false;
+        index = 0;
+        for (int i = 1; i <= KEY_WIDTH; ++i) {
+            char c = key[i];
+            index <<= 4;
+            if (c >= '0' && c <= '9')
+                index += c - '0';
+            else if (c >= 'a' && c <= 'f')
+                index += c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                index += c - 'A' + 10;
+            else
+                return false;
+        }
+        return true;
+    }
+
+    void CallingRange::deleteResidentObjects(ObjectXLMap &objects) {
+        // Take the contents of the map before deleting anything, because each
+        // object's dtor calls unregisterObject().
+        ObjectXLMap residents;
+        residents.swap(objects);
+        for (ObjectXLMap::const_iterator i = residents.begin(); i != residents.end(); ++i) {
+            boost::shared_ptr<ObjectWrapperXL> objectXL = i->second.lock();
+            if (objectXL)
+                RepositoryXL::instance().deleteResidentObject(i->first, objectXL.get());
+        }
+    }
+
+    void CallingRange::clearResidentObjects(bool deletePermanent) {
+        deleteResidentObjects(transientObjects_);
+        if (deletePermanent)
+            deleteResidentObjects(permanentObjects_);
     }
 
     void CallingRange::registerObject(const std::string &objectID, boost::weak_ptr<ObjectWrapperXL> objectWrapperXL) {
-        residentObjects_[objectID] = objectWrapperXL;
+        boost::shared_ptr<ObjectWrapperXL> objectXL = objectWrapperXL.lock();
+        if (objectXL && objectXL->permanent()) {
+            transientObjects_.erase(objectID);
+            permanentObjects_[objectID] = objectWrapperXL;
+        } else {
+            permanentObjects_.erase(objectID);
+            transientObjects_[objectID] = objectWrapperXL;
+        }
+    }
+
+    void CallingRange::unregisterResidentObject(ObjectXLMap &objects, const std::string &objectID,
+                                                const ObjectWrapperXL *objectWrapperXL) {
+        ObjectXLMap::iterator i = objects.find(objectID);
+        if (i == objects.end())
+            return;
+        // An expired entry refers to the object being destroyed.
+        boost::shared_ptr<ObjectWrapperXL> resident = i->second.lock();
+        if (!resident || resident.get() == objectWrapperXL)
+            objects.erase(i);
     }
 
-    void CallingRange::unregisterObject(const std::string &objectID) {
-        residentObjects_.erase(objectID);
+    void CallingRange::unregisterObject(const std::string &objectID, const ObjectWrapperXL *objectWrapperXL) {
+        unregisterResidentObject(transientObjects_, objectID, objectWrapperXL);
+        unregisterResidentObject(permanentObjects_, objectID, objectWrapperXL);
     }
 
     bool CallingRange::valid() const {
         if (callerType_ == CallerType::Cell) {
+            if (!pendingNames_.empty())
+                flushNames();
             Xloper xDef, xRef;
             
             Excel(xlfGetName, &xDef, 1, TempStrStl(key_));
@@ -113,6 +313,16 @@ namespace reposit {
             Excel(xlfTextref, &xRef, 1, TempStrStl(address.substr(1)));
 
             bool ret = (xRef->xltype & (xltypeRef | xltypeSRef)) != 0;
+            // Take the opportunity to correct the identity of the caller,
+            // in case the range has moved.
+            if (!ret) {
+                forgetCaller();
+            } else if ((xRef->xltype & xltypeRef) && xRef->val.mref.lpmref->count == 1) {
+                CallerId callerId;
+                callerId.idSheet = xRef->val.mref.idSheet;
+                callerId.ref = xRef->val.mref.lpmref->reftbl[0];
+                identifyCaller(callerId);
+            }
             return ret;
         } else {
             return true;
@@ -121,6 +331,8 @@ namespace reposit {
 
     std::string CallingRange::addressString() const {
         if (callerType_ == CallerType::Cell) {
+            if (!pendingNames_.empty())
+                flushNames();
             Xloper xDef;
             Excel(xlfGetName, &xDef, 1, TempStrStl(key_));
             std::string address = ConvertOper(xDef());
@@ -133,21 +345,25 @@ namespace reposit {
         }
     }
 
+    int CallingRange::nextUpdateCount() {
+        if (updateCount_ > COUNT_MAX) updateCount_ = 0;
+        return updateCount_++;
+    }
+
     std::string CallingRange::updateCount() {
-        if (updateCount_ > 9999) updateCount_ = 0;
-        std::ostringstream s;
-        s << std::setw(4) << std::setfill('0') << updateCount_++;
-        return s.str();
+        std::string ret;
+        appendCount(ret, nextUpdateCount());
+        return ret;
     }
 
     std::string CallingRange::getUpdateCount(){
         int count = updateCount_;
         if(count != 0)
             count -= 1;
-        if (count > 9999) count = 0;
-        std::ostringstream s;
-        s << std::setw(4) << std::setfill('0') << count;
-        return s.str();
+        if (count > COUNT_MAX) count = 0;
+        std::string ret;
+        appendCount(ret, count);
+        return ret;
     }
 
     std::ostream &operator<<(std::ostream &out, const boost::shared_ptr<CallingRange> &callingRange) {
@@ -162,11 +378,14 @@ namespace reposit {
         out << "update count: "  << std::left << std::setw(COL_WIDTH)
             << callingRange->updateCount_ << std::endl;
         out << "resident objects: " << std::left << std::setw(COL_WIDTH)
-            << callingRange->residentObjects_.size() << std::endl;
+            << callingRange->transientObjects_.size() + callingRange->permanentObjects_.size() << std::endl;
         CallingRange::ObjectXLMap::const_iterator i;
-        for (i = callingRange->residentObjects_.begin(); 
-             i != callingRange->residentObjects_.end(); ++i)
+        for (i = callingRange->transientObjects_.begin(); 
+             i != callingRange->transientObjects_.end(); ++i)
             out << "       object ID: " << std::left << std::setw(COL_WIDTH) << i->first << std::endl;
+        for (i = callingRange->permanentObjects_.begin(); 
+             i != callingRange->permanentObjects_.end(); ++i)
+            out << "       object ID: " << std::left << std::setw(COL_WIDTH) << i->first << " (permanent)" << std::endl;
         out << std::endl;
         return out;
     }
@@ -178,7 +397,13 @@ namespace reposit {
 
         if (objectID.empty()) {
             if (callerType_ == CallerType::Cell) {
-                return anonPrefix + key_;
+                // The key may have belonged to a deleted range, so suffix the
+                // generation to prevent a stale ID from resolving to this Object.
+                if (keyGeneration_ == 0)
+                    return anonPrefix + key_;
+                std::ostringstream s;
+                s << anonPrefix << key_ << '_' << keyGeneration_;
+                return s.str();
             } else {
                 RP_FAIL("Null string specified for object ID");
             }
@@ -194,18 +419,32 @@ namespace reposit {
     }
 
     std::string CallingRange::updateID(const std::string &objectID) {
-        if (callerType_ == CallerType::Cell)
-            return objectID + counterDelimiter + updateCount();
-        else
-            return objectID;
+        std::string ret;
+        updateID(objectID, ret);
+        return ret;
+    }
+
+    void CallingRange::updateID(const std::string &objectID, std::string &idFull) {
+        if (callerType_ == CallerType::Cell) {
+            idFull.reserve(objectID.length() + 1 + COUNT_WIDTH);
+            idFull.assign(objectID);
+            idFull += counterDelimiter;
+            appendCount(idFull, nextUpdateCount());
+        } else {
+            idFull.assign(objectID);
+        }
     }
 
     std::string CallingRange::getStub(const std::string &objectID) {
-        int counterOffset = objectID.length() - keyWidth();
+        return objectID.substr(0, stubLength(objectID));
+    }
+
+    std::string::size_type CallingRange::stubLength(const std::string &objectID) {
+        int counterOffset = objectID.length() - (COUNT_WIDTH + 1);
         if (counterOffset >= 0 && objectID[counterOffset] == counterDelimiter)
-            return objectID.substr(0, counterOffset);
+            return counterOffset;
         else
-            return objectID;
+            return objectID.length();
     }
 
 }
@@ -43,6 +43,11 @@ namespace reposit {
         The CallingRange object can also be queried to indicate whether the associated Excel range
         remains valid, this facilitates garbage collection of objects orphaned by the deletion
         of the calling cell.
+
+        If deferred naming is enabled, the calls to xlfSetName which create and
+        delete the hidden names are queued, and issued together by flushNames()
+        at the end of the calculation cycle.  Until then the key of a new
+        CallingRange is retrieved from the queue by pendingName().
     */
     class CallingRange {
         friend std::ostream &operator<<(std::ostream&, const boost::shared_ptr<CallingRange>&);
@@ -51,10 +56,45 @@ namespace reposit {
         //@{
         //! Constructor - assigns a name to the calling range.
         CallingRange();
-        //! Destructor - presently takes no action.
+        //! Destructor - deletes the name of the calling range and releases its key.
         ~CallingRange();
         //! Returns the size in bytes of the values used to identify ranges.
         static int keyWidth() { return KEY_WIDTH; }
+        //! Retrieve the number encoded in the given key.
+        /*! Returns false if the value is not a key assigned by CallingRange.
+            The keys of deleted ranges are reused, so that the numbers of the
+            keys in use remain small enough to index a vector.
+        */
+        static bool parseKey(const std::string &key, std::size_t &index);
+        //@}
+
+        //! \name Deferred Naming
+        //@{
+        //! Queue the creation and deletion of hidden names instead of performing them immediately.
+        /*! Only enable deferred naming if flushNames() is guaranteed to be
+            called at the end of each calculation cycle.
+        */
+        static void setDeferNames(bool deferNames);
+        //! Indicate whether deferred naming is enabled.
+        static bool deferNames();
+        //! Retrieve the key of the CallingRange whose name is pending for the given caller.
+        static bool pendingName(const CallerId &callerId, std::string &key);
+        //! Create and delete all queued hidden names.
+        static void flushNames();
+        //@}
+
+        //! \name Caller Identity
+        //@{
+        //! Retrieve the key of the CallingRange identified with the given caller.
+        /*! A CallingRange is identified with the caller which created it, or
+            which last found it by name, see identifyCaller().  This allows the
+            range of a formula to be found without converting the reference of
+            the caller to text.  The identity is refreshed by valid(), so that
+            garbage collection corrects it for ranges which have moved.
+        */
+        static bool callerKey(const CallerId &callerId, std::string &key);
+        //! Identify this CallingRange with the given caller.
+        void identifyCaller(const CallerId &callerId) const;
         //@}
 
         //! \name Object Management
@@ -62,17 +102,28 @@ namespace reposit {
         //! Indicate that the given object is resident in this range.
         void registerObject(const std::string &objectID, boost::weak_ptr<ObjectWrapperXL> objectWrapperXL);
         //! Remove the given object from the list of resident objects.
-        void unregisterObject(const std::string &objectID);
+        /*! Take no action if another object has since been registered with
+            the same ID, which happens if the given object was deleted while
+            deferred destruction was enabled and its ID was then reused.
+        */
+        void unregisterObject(const std::string &objectID, const ObjectWrapperXL *objectWrapperXL);
         //! Delete all objects associated with this range, e.g. if the range has been deleted.
+        /*! Permanent and transient objects are held separately, so that the
+            permanent objects are not visited unless deletePermanent is true.
+        */
         void clearResidentObjects(bool deletePermanent);
         //! Indicate whether any objects presently reside in this range.
-        bool empty() { return residentObjects_.empty(); }
+        bool empty() { return transientObjects_.empty() && permanentObjects_.empty(); }
         //@}
 
         //! \name Inspectors
         //@{
         //! The unique key assigned internally to this calling range.
         const std::string &key() const { return key_; }
+        //! The number encoded in the key, see parseKey().
+        /*! Only meaningful for ranges in worksheet cells.
+        */
+        std::size_t keyIndex() const { return keyIndex_; }
         //! The address of the range as a string.
         /*! The address is derived anew each time this function is called.
             This allows for any changes resulting e.g. from cut and paste operations.
@@ -98,10 +149,17 @@ namespace reposit {
             if full the suffix is removed, if normal the value is returned unmodified.
         */
         static DLL_API std::string getStub(const std::string &objectID);
+        //! The length of the normal ID within the given normal or full ID.
+        /*! Equal to the length of the value returned by getStub(), but does not
+            copy the ID.
+        */
+        static DLL_API std::string::size_type stubLength(const std::string &objectID);
         //! Initialize the Object ID.
         /*! If a value has been provided then validate it.
             If not then autogenerate a value.  In this case the Object is
-            considered to be "anonymous".
+            considered to be "anonymous".  The value is derived from the key,
+            e.g. obj_0000001f, and is suffixed with the generation of the key,
+            e.g. obj_0000001f_2, if the key has been reused.
         */
         std::string initializeID(const std::string &objectID);
         //! Update the Object ID.
@@ -110,16 +168,31 @@ namespace reposit {
             then no change is made to the ID.
         */
         std::string updateID(const std::string &objectID);
+        //! Update the Object ID, writing the result to the given string.
+        /*! Equivalent to the function above, but reuses the memory already
+            allocated to idFull.
+        */
+        void updateID(const std::string &objectID, std::string &idFull);
         //@}
 
     private:
-        static int keyCount_;
-        static std::string getKeyCount();
+        static std::string formatKey(std::size_t index);
+        int nextUpdateCount();
         static const int KEY_WIDTH;
         std::string key_;
+        std::size_t keyIndex_;
+        std::size_t keyGeneration_;
+        void forgetCaller() const;
+        mutable CallerId callerId_;
+        mutable bool identified_;
+        bool namePending_;
         int updateCount_;
         typedef std::map<std::string, boost::weak_ptr<ObjectWrapperXL>, my_iless > ObjectXLMap;
-        ObjectXLMap residentObjects_;
+        ObjectXLMap transientObjects_;
+        ObjectXLMap permanentObjects_;
+        static void deleteResidentObjects(ObjectXLMap &objects);
+        static void unregisterResidentObject(ObjectXLMap &objects, const std::string &objectID,
+                                             const ObjectWrapperXL *objectWrapperXL);
         CallerType::Type callerType_;
     };
 
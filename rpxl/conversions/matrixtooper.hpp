@@ -25,13 +25,24 @@
 #define rpxl_conversions_matrixtooper_hpp
 
 #include <rpxl/conversions/scalartooper.hpp>
+#include <string>
 #include <vector>
 
 namespace reposit {
 
-    //! Convert type std::vector<std::vector<T> > to an Excel OPER.
-    template <class T>
-    void matrixToOper(const std::vector<std::vector<T> > &vv, OPER &xMatrix) {
+    //! Convert a matrix of strings to an Excel OPER.
+    /*! The elements and their strings are allocated in a single block of memory.
+    */
+    DLL_API void matrixToOper(const std::vector<std::vector<std::string> > &vv, OPER &xMatrix);
+
+    //! Convert a matrix of strings to an Excel OPER12.
+    /*! The elements and their strings are allocated in a single block of memory.
+    */
+    DLL_API void matrixToOper(const std::vector<std::vector<std::string> > &vv, OPER12 &xMatrix);
+
+    //! Convert type std::vector<std::vector<T> > to an Excel OPER or OPER12.
+    template <class T, class OperType>
+    void matrixToOper(const std::vector<std::vector<T> > &vv, OperType &xMatrix) {
 
         if (vv.empty() || vv[0].empty()) {
             xMatrix.xltype = xltypeErr;
@@ -41,11 +52,11 @@ namespace reposit {
 
         xMatrix.val.array.rows = vv.size();
         xMatrix.val.array.columns = vv[0].size();
-        xMatrix.val.array.lparray = new OPER[xMatrix.val.array.rows * xMatrix.val.array.columns]; 
+        xMatrix.val.array.lparray = new OperType[xMatrix.val.array.rows * xMatrix.val.array.columns];
         xMatrix.xltype = xltypeMulti | xlbitDLLFree;
 
         for (unsigned int i=0; i<vv.size(); ++i) {
-            std::vector<T> v = vv[i];
+            const std::vector<T> &v = vv[i];
             for (unsigned int j=0; j<v.size(); ++j) {
                 // FIXME - is the workaround below still required,
                 // now that we are no longer using boost::any ?
@@ -25,10 +25,55 @@
 #define rpxl_conversions_opertomatrix_hpp
 
 #include <rpxl/convert_oper.hpp>
+#include <rpxl/conversions/opertovector.hpp>
 #include <vector>
 
 namespace reposit {
 
+    //! Convert a value of type ConvertOper to a matrix.
+    template <class T>
+    std::vector<std::vector<T> > operToMatrixImpl(
+        const ConvertOper &xMatrix, 
+        const std::string &paramName) {
+
+        try {
+            if (xMatrix.missing()) return std::vector<std::vector<T> >();
+
+            RP_REQUIRE(!xMatrix.error(), "input value has type=error");
+
+            const OPER *xMulti;
+            Xloper xCoerce;  // Freed automatically
+            OPER xSingle;
+
+            if (xMatrix->xltype == xltypeMulti)
+                xMulti = xMatrix.get();
+            else if (xMatrix->xltype & (xltypeNum | xltypeBool | xltypeStr)) {
+                // A scalar - treat it as a 1x1 array without calling back into Excel.
+                singleOper(*xMatrix.get(), xSingle);
+                xMulti = &xSingle;
+            } else {
+                Excel(xlCoerce, &xCoerce, 2, xMatrix.get(), TempInt(xltypeMulti));
+                xMulti = &xCoerce;
+            }
+
+            int rows = xMulti->val.array.rows;
+            int columns = xMulti->val.array.columns;
+            std::vector<std::vector<T> > ret(rows);
+            const OPER *xElement = xMulti->val.array.lparray;
+            for (int i=0; i<rows; ++i) {
+                std::vector<T> &row = ret[i];
+                row.reserve(columns);
+                for (int j=0; j<columns; ++j, ++xElement)
+                    row.push_back(convertElement<T>(*xElement));
+            }
+
+            return ret;
+        } catch (const std::exception &e) {
+            RP_FAIL("operToMatrixImpl: error converting parameter '" << paramName 
+                << "' to type '" << typeid(T).name() << "' : " << e.what());
+        }
+    }
+
     //! Helper template wrapper for operToMatrixImpl
     /*! Accept an OPER as input and wrap this in class ConvertOper.
         This simplifies syntax in client applications.
@@ -42,10 +87,10 @@ namespace reposit {
             (ConvertOper(xMatrix, false), paramName);
     }
 
-    //! Convert a value of type ConvertOper to a matrix.
+    //! Convert a value of type ConvertOper12 to a matrix.
     template <class T>
     std::vector<std::vector<T> > operToMatrixImpl(
-        const ConvertOper &xMatrix, 
+        const ConvertOper12 &xMatrix,
         const std::string &paramName) {
 
         try {
@@ -53,25 +98,29 @@ namespace reposit {
 
             RP_REQUIRE(!xMatrix.error(), "input value has type=error");
 
-            const OPER *xMulti;
-            Xloper xCoerce;  // Freed automatically
+            const OPER12 *xMulti;
+            Xloper12 xCoerce;  // Freed automatically
+            OPER12 xSingle;
 
             if (xMatrix->xltype == xltypeMulti)
                 xMulti = xMatrix.get();
-            else {
-                Excel(xlCoerce, &xCoerce, 2, xMatrix.get(), TempInt(xltypeMulti));
+            else if (xMatrix->xltype & (xltypeNum | xltypeBool | xltypeStr)) {
+                singleOper(*xMatrix.get(), xSingle);
+                xMulti = &xSingle;
+            } else {
+                Excel12f(xlCoerce, &xCoerce, 2, xMatrix.get(), TempInt12(xltypeMulti));
                 xMulti = &xCoerce;
             }
 
-            std::vector<std::vector<T> > ret;
-            ret.reserve(xMulti->val.array.rows);
-            for (int i=0; i<xMulti->val.array.rows; ++i) {
-                std::vector<T> row;
-                row.reserve(xMulti->val.array.columns);
-                for (int j=0; j<xMulti->val.array.columns; ++j) {
-                    row.push_back(convert<T>(ConvertOper(xMulti->val.array.lparray[i * xMulti->val.array.columns + j])));                
-                }
-                ret.push_back(row);
+            int rows = xMulti->val.array.rows;
+            int columns = xMulti->val.array.columns;
+            std::vector<std::vector<T> > ret(rows);
+            const OPER12 *xElement = xMulti->val.array.lparray;
+            for (int i=0; i<rows; ++i) {
+                std::vector<T> &row = ret[i];
+                row.reserve(columns);
+                for (int j=0; j<columns; ++j, ++xElement)
+                    row.push_back(convertElement<T>(*xElement));
             }
 
             return ret;
@@ -81,18 +130,24 @@ namespace reposit {
         }
     }
 
+    //! Helper template wrapper for operToMatrixImpl, for input of type OPER12.
+    template <class T>
+    std::vector<std::vector<T> > operToMatrix(
+        const OPER12 &xMatrix, 
+        const std::string &paramName) {
+
+        return operToMatrixImpl<T>
+            (ConvertOper12(xMatrix, false), paramName);
+    }
+
     //! Convert an Excel FP to type std::vector<std::vector<T> >.
     template <class T>
     std::vector<std::vector<T> > fpToMatrix(const FP &fpMatrix) {
         std::vector<std::vector<T> > ret;
         ret.reserve(fpMatrix.rows);
-        for (int i=0; i<fpMatrix.rows; ++i) {
-            std::vector<T> row;
-            row.reserve(fpMatrix.columns);
-            for (int j=0; j<fpMatrix.columns; ++j)
-                row.push_back(fpMatrix.array[i * fpMatrix.columns + j]);
-            ret.push_back(row);
-        }
+        const double *row = fpMatrix.array;
+        for (int i=0; i<fpMatrix.rows; ++i, row += fpMatrix.columns)
+            ret.push_back(std::vector<T>(row, row + fpMatrix.columns));
         return ret;
     }
 
@@ -26,20 +26,90 @@
 
 #include <rpxl/convert_oper.hpp>
 #include <rpxl/utilities/xlutilities.hpp>
+#include <rp/conversions/convert.hpp>
 #include <vector>
 #include <boost/shared_ptr.hpp>
 
 namespace reposit {
 
-    //! Helper template wrapper for operToVectorImpl
-    /*! \li Accept an OPER as input and wrap this in class ConvertOper
-        \li Specify VariantToScalar as the algorithm to be used
+    //! Initialize an array OPER of one element which refers to the given scalar.
+    /*! The array does not own the element and must not be freed.
+    */
+    inline void singleOper(const OPER &xScalar, OPER &xSingle) {
+        xSingle.xltype = xltypeMulti;
+        xSingle.val.array.rows = 1;
+        xSingle.val.array.columns = 1;
+        xSingle.val.array.lparray = const_cast<OPER*>(&xScalar);
+    }
 
-        This simplifies syntax in client applications.
+    //! Convert an element of an array OPER to type T.
+    /*! Equivalent to convert<T>(ConvertOper(xElement)).  There are
+        specializations for numeric types which read numbers directly.
     */
     template <class T>
-    std::vector<T> operToVector(const OPER &xVector, const std::string &paramName) {
-        return operToVectorImpl<T>(ConvertOper(xVector, false), paramName);
+    inline T convertElement(const OPER &xElement) {
+        return convert<T>(ConvertOper(xElement));
+    }
+
+    template <>
+    inline double convertElement<double>(const OPER &xElement) {
+        if (xElement.xltype & xltypeNum)
+            return xElement.val.num;
+        return convert<double>(ConvertOper(xElement));
+    }
+
+    template <>
+    inline long convertElement<long>(const OPER &xElement) {
+        if (xElement.xltype & xltypeNum)
+            return static_cast<long>(xElement.val.num);
+        return convert<long>(ConvertOper(xElement));
+    }
+
+    template <>
+    inline unsigned int convertElement<unsigned int>(const OPER &xElement) {
+        if (xElement.xltype & xltypeNum)
+            return static_cast<unsigned int>(xElement.val.num);
+        return convert<unsigned int>(ConvertOper(xElement));
+    }
+
+    //! Initialize an array OPER12 of one element which refers to the given scalar.
+    /*! The array does not own the element and must not be freed.
+    */
+    inline void singleOper(const OPER12 &xScalar, OPER12 &xSingle) {
+        xSingle.xltype = xltypeMulti;
+        xSingle.val.array.rows = 1;
+        xSingle.val.array.columns = 1;
+        xSingle.val.array.lparray = const_cast<OPER12*>(&xScalar);
+    }
+
+    //! Convert an element of an array OPER12 to type T.
+    /*! Equivalent to convert<T>(ConvertOper12(xElement)), with the same
+        specializations as for OPER.
+    */
+    template <class T>
+    inline T convertElement(const OPER12 &xElement) {
+        return convert<T>(ConvertOper12(xElement));
+    }
+
+    template <>
+    inline double convertElement<double>(const OPER12 &xElement) {
+        if (xElement.xltype & xltypeNum)
+            return xElement.val.num;
+        return convert<double>(ConvertOper12(xElement));
+    }
+
+    template <>
+    inline long convertElement<long>(const OPER12 &xElement) {
+        if (xElement.xltype & xltypeNum)
+            return static_cast<long>(xElement.val.num);
+        return convert<long>(ConvertOper12(xElement));
+    }
+
+    template <>
+    inline unsigned int convertElement<unsigned int>(const OPER12 &xElement) {
+        if (xElement.xltype & xltypeNum)
+            return static_cast<unsigned int>(xElement.val.num);
+        return convert<unsigned int>(ConvertOper12(xElement));
     }
 
     struct X {
@@ -51,6 +121,16 @@ namespace reposit {
         }
     };
 
+    //! As struct X, for an OPER12.
+    struct X12 {
+        OPER12 o;
+        X12() { o.xltype = 0; }
+        ~X12() {
+            if (o.xltype)
+                freeOper(&o);
+        }
+    };
+
     //! Convert a value of type ConvertOper to a vector.
     template <class T>
     std::vector<T> operToVectorImpl(
@@ -66,21 +146,83 @@ namespace reposit {
             const OPER *xMulti;
             Xloper xCoerce;     // Freed automatically
             X xSplit;           // Freed automatically
+            OPER xSingle;
 
             if (xVector->xltype == xltypeMulti) {
                 xMulti = xVector.get();
             } else if (xVector->xltype == xltypeStr) {
                 splitOper(xVector.get(), &xSplit.o);
                 xMulti = &xSplit.o;
+            } else if (xVector->xltype & (xltypeNum | xltypeBool)) {
+                // A scalar - treat it as an array of one element without
+                // calling back into Excel.
+                singleOper(*xVector.get(), xSingle);
+                xMulti = &xSingle;
             } else {
                 Excel(xlCoerce, &xCoerce, 2, xVector.get(), TempInt(xltypeMulti));
                 xMulti = &xCoerce;
             }
 
+            int size = xMulti->val.array.rows * xMulti->val.array.columns;
+            std::vector<T> ret;
+            ret.reserve(size);
+            for (int i=0; i<size; ++i) {
+                ret.push_back(convertElement<T>(xMulti->val.array.lparray[i]));
+            }
+
+            return ret;
+        } catch (const std::exception &e) {
+            RP_FAIL("operToVectorImpl: error converting parameter '" << paramName 
+                << "' to type '" << typeid(T).name() << "' : " << e.what());
+        }
+    }
+
+    //! Helper template wrapper for operToVectorImpl
+    /*! \li Accept an OPER as input and wrap this in class ConvertOper
+        \li Specify VariantToScalar as the algorithm to be used
+
+        This simplifies syntax in client applications.
+    */
+    template <class T>
+    std::vector<T> operToVector(const OPER &xVector, const std::string &paramName) {
+        return operToVectorImpl<T>(ConvertOper(xVector, false), paramName);
+    }
+
+    //! Convert a value of type ConvertOper12 to a vector.
+    template <class T>
+    std::vector<T> operToVectorImpl(
+        const ConvertOper12 &xVector,
+        const std::string &paramName) {
+
+        try {
+
+            if (xVector.missing()) return std::vector<T>();
+
+            RP_REQUIRE(!xVector.error(), "input value has type=error");
+
+            const OPER12 *xMulti;
+            Xloper12 xCoerce;   // Freed automatically
+            X12 xSplit;         // Freed automatically
+            OPER12 xSingle;
+
+            if (xVector->xltype == xltypeMulti) {
+                xMulti = xVector.get();
+            } else if (xVector->xltype == xltypeStr) {
+                splitOper(xVector.get(), &xSplit.o);
+                xMulti = &xSplit.o;
+            } else if (xVector->xltype & (xltypeNum | xltypeBool)) {
+                singleOper(*xVector.get(), xSingle);
+                xMulti = &xSingle;
+            } else {
+                Excel12f(xlCoerce, &xCoerce, 2, xVector.get(), TempInt12(xltypeMulti));
+                xMulti = &xCoerce;
+            }
+
+            std::size_t size = static_cast<std::size_t>(xMulti->val.array.rows) * xMulti->val.array.columns;
             std::vector<T> ret;
-            ret.reserve(xMulti->val.array.rows * xMulti->val.array.columns);
-            for (int i=0; i<xMulti->val.array.rows * xMulti->val.array.columns; ++i) {
-                ret.push_back(convert<T>(ConvertOper(xMulti->val.array.lparray[i])));
+            ret.reserve(size);
+            for (std::size_t i=0; i<size; ++i) {
+                ret.push_back(convertElement<T>(xMulti->val.array.lparray[i]));
             }
 
             return ret;
@@ -89,6 +231,12 @@ namespace reposit {
                 << "' to type '" << typeid(T).name() << "' : " << e.what());
         }
     }
+
+    //! Helper template wrapper for operToVectorImpl, for input of type OPER12.
+    template <class T>
+    std::vector<T> operToVector(const OPER12 &xVector, const std::string &paramName) {
+        return operToVectorImpl<T>(ConvertOper12(xVector, false), paramName);
+    }
 }
 
 #endif
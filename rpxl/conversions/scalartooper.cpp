@@ -21,12 +21,79 @@
 #include <rpxl/conversions/scalartooper.hpp>
 #include <rpxl/conversions/vectortooper.hpp>
 #include <rpxl/conversions/matrixtooper.hpp>
+#include <rpxl/utilities/xlutilities.hpp>
+#include <rp/exception.hpp>
 #include <vector>
 #include <string>
+#include <cstring>
+#include <algorithm>
 #include <rp/property.hpp>
 
 namespace reposit {
 
+    namespace {
+
+        // The length of the value when converted to an Excel byte-counted string.
+        unsigned char operStringLength(const std::string &value) {
+            return __min(XL_MAX_STR_LEN - 1, value.length());
+        }
+
+        // Write the value as a byte-counted string to the given position in a
+        // block allocated by allocateOperArray() and return the next position.
+        // The element is not flagged xlbitDLLFree, because its string is
+        // released along with the block.
+        char *packString(const std::string &value, OPER &xString, char *buffer) {
+            unsigned char len = operStringLength(value);
+            buffer[0] = len;
+            if (len)
+                memcpy(buffer + 1, value.data(), len);
+            xString.xltype = xltypeStr;
+            xString.val.str = buffer;
+            return buffer + len + 1;
+        }
+
+        // The number of wide characters in the value, which Excel passes to
+        // the XLOPER functions in the ANSI code page.
+        std::size_t wideLength(const std::string &value) {
+            if (value.empty())
+                return 0;
+            return MultiByteToWideChar(CP_ACP, 0, value.data(), static_cast<int>(value.length()), 0, 0);
+        }
+
+        // The length of the value when converted to an Excel 2007 counted string.
+        std::size_t operStringLength12(const std::string &value) {
+            return std::min<std::size_t>(XL_MAX_STR_LEN12 - 1, wideLength(value));
+        }
+
+        // Write the first len wide characters of the value to the given buffer,
+        // converting from the ANSI code page as Excel does, so that a string
+        // has the same value in an OPER12 as in an OPER.
+        void widenString(const std::string &value, std::size_t len, XCHAR *buffer) {
+            if (!len)
+                return;
+            int size = static_cast<int>(value.length());
+            if (wideLength(value) == len) {
+                MultiByteToWideChar(CP_ACP, 0, value.data(), size, buffer, static_cast<int>(len));
+            } else {
+                // The value is truncated.
+                std::vector<XCHAR> wide(wideLength(value));
+                MultiByteToWideChar(CP_ACP, 0, value.data(), size, &wide[0], static_cast<int>(wide.size()));
+                std::copy(wide.begin(), wide.begin() + len, buffer);
+            }
+        }
+
+        // As packString(), for an element of an array OPER12.
+        XCHAR *packString(const std::string &value, OPER12 &xString, XCHAR *buffer) {
+            std::size_t len = operStringLength12(value);
+            buffer[0] = static_cast<XCHAR>(len);
+            widenString(value, len, buffer + 1);
+            xString.xltype = xltypeStr;
+            xString.val.str = buffer;
+            return buffer + len + 1;
+        }
+
+    }
+
     DLL_API void scalarToOper(const int &value, OPER &xInt, bool expandVector) {
         xInt.xltype = xltypeNum;
         xInt.val.num = value;
@@ -54,7 +121,7 @@ namespace reposit {
 
     DLL_API void scalarToOper(const std::string &value, OPER &xString, bool expandVector) {
         // Must use type unsigned char (BYTE) to process the 0th byte of Excel byte-counted string
-        unsigned char len = __min(XL_MAX_STR_LEN - 1, value.length());
+        unsigned char len = operStringLength(value);
         xString.val.str = new char[len + 1];
         xString.xltype = xltypeStr | xlbitDLLFree;
         xString.val.str[0] = len;
@@ -62,14 +129,48 @@ namespace reposit {
             strncpy(xString.val.str + 1, value.c_str(), len);
     }
 
-    void setError(OPER &oper, WORD val) {
+    DLL_API void scalarToOper(const int &value, OPER12 &xInt, bool expandVector) {
+        xInt.xltype = xltypeNum;
+        xInt.val.num = value;
+    }
+
+    DLL_API void scalarToOper(const long &value, OPER12 &xLong, bool expandVector) {
+        xLong.xltype = xltypeNum;
+        xLong.val.num = value;
+    }
+
+    DLL_API void scalarToOper(const double &value, OPER12 &xDouble, bool expandVector) {
+        xDouble.xltype = xltypeNum;
+        xDouble.val.num = value;
+    }
+
+    DLL_API void scalarToOper(const bool &value, OPER12 &xBoolean, bool expandVector) {
+        xBoolean.xltype = xltypeBool;
+        xBoolean.val.xbool = value;
+    }
+
+    DLL_API void scalarToOper(const char *value, OPER12 &xChar, bool expandVector) {
+        scalarToOper(std::string(value), xChar, expandVector);
+    }
+
+    DLL_API void scalarToOper(const std::string &value, OPER12 &xString, bool expandVector) {
+        std::size_t len = operStringLength12(value);
+        xString.val.str = new XCHAR[len + 1];
+        xString.xltype = xltypeStr | xlbitDLLFree;
+        xString.val.str[0] = static_cast<XCHAR>(len);
+        widenString(value, len, xString.val.str + 1);
+    }
+
+    template <class OperType>
+    void setError(OperType &oper, int val) {
         oper.xltype = xltypeErr;
         oper.val.err = val; 
     }
 
+    template <class OperType>
     class VariantToOper : public boost::static_visitor<> {
     public:
-        VariantToOper(OPER &oper, bool expand) : oper_(oper), m_expand(expand) {}
+        VariantToOper(OperType &oper, bool expand) : oper_(oper), m_expand(expand) {}
         VariantToOper(const VariantToOper& op) : oper_(op.oper_), m_expand(op.m_expand) {}
 
         void operator()(const empty_property_tag&) { setError(oper_, xlerrNA); }
@@ -94,13 +195,109 @@ namespace reposit {
         }
 
     private:
-        OPER &oper_;
+        OperType &oper_;
         bool m_expand;
     };
 
     DLL_API void scalarToOper(const reposit::property_t &value, OPER &xVariant, bool expandVector) {
-        VariantToOper variantToOper(xVariant, expandVector);
+        VariantToOper<OPER> variantToOper(xVariant, expandVector);
         boost::apply_visitor(variantToOper, value);
     }
-}
 
+    DLL_API void scalarToOper(const reposit::property_t &value, OPER12 &xVariant, bool expandVector) {
+        VariantToOper<OPER12> variantToOper(xVariant, expandVector);
+        boost::apply_visitor(variantToOper, value);
+    }
+
+    DLL_API void vectorToOper(
+        std::vector<std::string>::const_iterator begin,
+        std::vector<std::string>::const_iterator end,
+        OPER &xVector) {
+
+        std::size_t size = end - begin;
+        if (size == 0) {
+            setError(xVector, xlerrNA);
+            return;
+        }
+
+        std::size_t stringBytes = 0;
+        for (std::vector<std::string>::const_iterator i = begin; i != end; ++i)
+            stringBytes += operStringLength(*i) + 1;
+
+        setVectorDimensions(size, xVector);
+        char *buffer = allocateOperArray(xVector, stringBytes);
+        for (std::size_t i = 0; i < size; ++i, ++begin)
+            buffer = packString(*begin, xVector.val.array.lparray[i], buffer);
+    }
+
+    DLL_API void matrixToOper(const std::vector<std::vector<std::string> > &vv, OPER &xMatrix) {
+
+        if (vv.empty() || vv[0].empty()) {
+            setError(xMatrix, xlerrNA);
+            return;
+        }
+
+        std::size_t stringBytes = 0;
+        for (std::size_t i = 0; i < vv.size(); ++i) {
+            RP_REQUIRE(vv[i].size() == vv[0].size(), "matrixToOper: row " << i
+                << " has " << vv[i].size() << " columns, expected " << vv[0].size());
+            for (std::size_t j = 0; j < vv[i].size(); ++j)
+                stringBytes += operStringLength(vv[i][j]) + 1;
+        }
+
+        xMatrix.val.array.rows = vv.size();
+        xMatrix.val.array.columns = vv[0].size();
+        char *buffer = allocateOperArray(xMatrix, stringBytes);
+        OPER *element = xMatrix.val.array.lparray;
+        for (std::size_t i = 0; i < vv.size(); ++i) {
+            for (std::size_t j = 0; j < vv[i].size(); ++j)
+                buffer = packString(vv[i][j], *element++, buffer);
+        }
+    }
+
+    DLL_API void vectorToOper(
+        std::vector<std::string>::const_iterator begin,
+        std::vector<std::string>::const_iterator end,
+        OPER12 &xVector) {
+
+        std::size_t size = end - begin;
+        if (size == 0) {
+            setError(xVector, xlerrNA);
+            return;
+        }
+
+        std::size_t stringChars = 0;
+        for (std::vector<std::string>::const_iterator i = begin; i != end; ++i)
+            stringChars += operStringLength12(*i) + 1;
+
+        setVectorDimensions(size, xVector);
+        XCHAR *buffer = allocateOperArray(xVector, stringChars);
+        for (std::size_t i = 0; i < size; ++i, ++begin)
+            buffer = packString(*begin, xVector.val.array.lparray[i], buffer);
+    }
+
+    DLL_API void matrixToOper(const std::vector<std::vector<std::string> > &vv, OPER12 &xMatrix) {
+
+        if (vv.empty() || vv[0].empty()) {
+            setError(xMatrix, xlerrNA);
+            return;
+        }
+
+        std::size_t stringChars = 0;
+        for (std::size_t i = 0; i < vv.size(); ++i) {
+            RP_REQUIRE(vv[i].size() == vv[0].size(), "matrixToOper: row " << i
+                << " has " << vv[i].size() << " columns, expected " << vv[0].size());
+            for (std::size_t j = 0; j < vv[i].size(); ++j)
+                stringChars += operStringLength12(vv[i][j]) + 1;
+        }
+
+        xMatrix.val.array.rows = vv.size();
+        xMatrix.val.array.columns = vv[0].size();
+        XCHAR *buffer = allocateOperArray(xMatrix, stringChars);
+        OPER12 *element = xMatrix.val.array.lparray;
+        for (std::size_t i = 0; i < vv.size(); ++i) {
+            for (std::size_t j = 0; j < vv[i].size(); ++j)
+                buffer = packString(vv[i][j], *element++, buffer);
+        }
+    }
+}
@@ -46,6 +46,23 @@ namespace reposit {
     DLL_API void scalarToOper(const std::string &value, OPER &xString, bool expandVector = true);
     //! Convert a property_t to an OPER.
     DLL_API void scalarToOper(const property_t &value, OPER &xAny, bool expandVector = true);
+
+    //! Convert a int to an OPER12.
+    DLL_API void scalarToOper(const int &value, OPER12 &xInt, bool expandVector = true);
+    //! Convert a long to an OPER12.
+    DLL_API void scalarToOper(const long &value, OPER12 &xLong, bool expandVector = true);
+    //! Convert a double to an OPER12.
+    DLL_API void scalarToOper(const double &value, OPER12 &xDouble, bool expandVector = true);
+    //! Convert a bool to an OPER12.
+    DLL_API void scalarToOper(const bool &value, OPER12 &xBoolean, bool expandVector = true);
+    //! Convert a char * to an OPER12.
+    DLL_API void scalarToOper(const char *value, OPER12 &xChar, bool expandVector = true);
+    //! Convert a string to an OPER12.
+    /*! Each char is widened to an XCHAR as an unsigned value.
+    */
+    DLL_API void scalarToOper(const std::string &value, OPER12 &xString, bool expandVector = true);
+    //! Convert a property_t to an OPER12.
+    DLL_API void scalarToOper(const property_t &value, OPER12 &xAny, bool expandVector = true);
 }
 
 #endif
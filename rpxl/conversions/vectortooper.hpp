@@ -28,23 +28,48 @@
 #include <rpxl/rpxldefines.hpp>
 #include <rpxl/conversions/scalartooper.hpp>
 #include <rpxl/functioncall.hpp>
+#include <string>
 #include <vector>
 
 namespace reposit {
 
-    //! Wrapper for the other vectorToOper.
-    /*! Extracts the begin and end iterators of the input vector.
+    //! Set the dimensions of an array OPER or OPER12 which is to hold a vector of the given size.
+    /*! The vector is written to a row if the caller is a row, otherwise to a column.
     */
-    template <class T>
-    void vectorToOper(const std::vector<T> &v, OPER &xVector) {
-        vectorToOper<std::vector<T>::const_iterator>(v.begin(), v.end(), xVector);
+    template <class OperType>
+    inline void setVectorDimensions(std::size_t size, OperType &xVector) {
+        if (FunctionCall::instance().callerDimensions() == CallerDimensions::Row) {
+            xVector.val.array.columns = size;
+            xVector.val.array.rows = 1;
+        } else {
+            xVector.val.array.rows = size;
+            xVector.val.array.columns = 1;
+        }
     }
 
-    //! Convert type std::vector<T> to an Excel OPER.
+    //! Convert a range of strings to an Excel OPER.
+    /*! The elements and their strings are allocated in a single block of memory.
+        The function sets the xlbitDLLFree bit.
+    */
+    DLL_API void vectorToOper(
+        std::vector<std::string>::const_iterator begin,
+        std::vector<std::string>::const_iterator end,
+        OPER &xVector);
+
+    //! Convert a range of strings to an Excel OPER12.
+    /*! The elements and their strings are allocated in a single block of memory.
+        The function sets the xlbitDLLFree bit.
+    */
+    DLL_API void vectorToOper(
+        std::vector<std::string>::const_iterator begin,
+        std::vector<std::string>::const_iterator end,
+        OPER12 &xVector);
+
+    //! Convert type std::vector<T> to an Excel OPER or OPER12.
     /*! The function sets the xlbitDLLFree bit.
     */
-    template <class T>
-    void vectorToOper(T begin, T end, OPER &xVector) {
+    template <class T, class OperType>
+    void vectorToOper(T begin, T end, OperType &xVector) {
         std::size_t size = end - begin;
         if (size == 0) {
             xVector.xltype = xltypeErr;
@@ -52,20 +77,21 @@ namespace reposit {
             return;
         }
 
-        if (FunctionCall::instance().callerDimensions() == CallerDimensions::Row) {
-            xVector.val.array.columns = size;
-            xVector.val.array.rows = 1;
-        } else {
-            xVector.val.array.rows = size;
-            xVector.val.array.columns = 1;
-        }
-
-        xVector.val.array.lparray = new OPER[size]; 
+        setVectorDimensions(size, xVector);
+        xVector.val.array.lparray = new OperType[size];
         xVector.xltype = xltypeMulti | xlbitDLLFree;
         for (unsigned int i=0; i<size; ++i, ++begin)
             scalarToOper(*begin, xVector.val.array.lparray[i], false);
     }
 
+    //! Wrapper for the other vectorToOper.
+    /*! Extracts the begin and end iterators of the input vector.
+    */
+    template <class T, class OperType>
+    void vectorToOper(const std::vector<T> &v, OperType &xVector) {
+        vectorToOper(v.begin(), v.end(), xVector);
+    }
+
 }
 
 #endif
@@ -160,10 +160,134 @@ namespace reposit {
         // FIXME - We have converted an OPER to a std::string.  Certain callers
         // of this function have passed in an Excel format object ID e.g.
         // "my_object#00123" and need us to strip off the trailing "#00123",
-        // so we call getStub().  This conversion should be done only when
-        // it's definitely required.
-        //return ret;
-        return CallingRange::getStub(ret);
+        // so we truncate the string to the length of the stub.  This conversion
+        // should be done only when it's definitely required.
+        ret.resize(CallingRange::stubLength(ret));
+        return ret;
+    }
+
+    ConvertOper12::ConvertOper12(const OPER12 &xIn, const bool &decayVectorToScalar) {
+
+        if (decayVectorToScalar && xIn.xltype & xltypeMulti) {
+            if (xIn.val.array.rows == 1 && xIn.val.array.columns == 1) {
+                oper_ = &xIn.val.array.lparray[0];
+            } else {
+                RP_FAIL("input value is vector or matrix, expected scalar");
+            }
+        } else {
+            oper_ = &xIn;
+        }
+    }
+
+    ConvertOper12::operator long() const {
+        if (oper_->xltype & xltypeNum)
+            return static_cast<long>(oper_->val.num);
+        else {
+            OPER12 xLong;
+            Excel12f(xlCoerce, &xLong, 2, oper_, TempInt12(xltypeInt));
+            return xLong.val.w;
+        }
+    }
+
+    ConvertOper12::operator unsigned int() const {
+        if (oper_->xltype & xltypeNum)
+            return static_cast<unsigned int>(oper_->val.num);
+        else {
+            OPER12 xLong;
+            Excel12f(xlCoerce, &xLong, 2, oper_, TempInt12(xltypeInt));
+            return xLong.val.w;
+        }
+    }
+
+    ConvertOper12::operator double() const {
+        if (oper_->xltype & xltypeNum)
+            return oper_->val.num;
+        else {
+            OPER12 xDouble;
+            Excel12f(xlCoerce, &xDouble, 2, oper_, TempInt12(xltypeNum));
+            return xDouble.val.num;
+        }
+    }
+
+    ConvertOper12::operator bool() const {
+        if (oper_->xltype & xltypeBool)
+            return oper_->val.xbool != 0;
+        else {
+            OPER12 xBool;
+            Excel12f(xlCoerce, &xBool, 2, oper_, TempInt12(xltypeBool));
+            return xBool.val.xbool != 0;
+        }
+    }
+
+    ConvertOper12::operator std::string() const {
+        const OPER12 *xString;
+        Xloper12 xTemp;
+        if (oper_->xltype & xltypeStr) {
+            xString = oper_;
+        } else {
+            Excel12f(xlCoerce, &xTemp, 2, oper_, TempInt12(xltypeStr));
+            xString = &xTemp;
+        }
+        return strConv(xString);
+    }
+
+    const std::type_info& ConvertOper12::type() const {
+        if(oper_->xltype & xltypeNum)
+            return typeid(double);
+        else if(oper_->xltype & xltypeBool)
+            return typeid(bool);
+        else if(oper_->xltype & xltypeStr)
+            return typeid(std::string);
+        else if(missing() || error())
+            return typeid(empty_property_tag);
+        else
+            RP_FAIL("ConvertOper12: unexpected datatype: " << oper_->xltype);
+    }
+
+    ConvertOper12::operator property_t() const {
+        if (missing()) {
+            return empty_property_tag();
+        } else if (error()) {
+            return empty_property_tag();
+        } else if (oper_->xltype & xltypeNum) {
+            return oper_->val.num;
+        } else if (oper_->xltype & xltypeBool) {
+            return oper_->val.xbool != 0;
+        } else if (oper_->xltype & xltypeStr) {
+            return strConv(oper_);
+        } else {
+            RP_FAIL("ConvertOper12: unexpected datatype: " << oper_->xltype);
+        }
+    }
+
+    bool ConvertOper12::missing() const {
+        return (oper_->xltype & xltypeNil
+        ||  oper_->xltype & xltypeMissing
+        ||  (oper_->xltype & xltypeErr && oper_->val.err == xlerrNA));
+    }
+
+    bool ConvertOper12::error() const {
+        return (oper_->xltype & xltypeErr && oper_->val.err != xlerrNA);
+    }
+
+    std::string ConvertOper12::strConv(const OPER12 *xString) {
+        std::string ret;
+        if (xString->val.str) {
+            // The 0th character of an Excel 2007 string holds its length.
+            // Convert to the ANSI code page, in which Excel passes strings to
+            // the XLOPER functions, so that a string has the same value as
+            // when it is passed to those functions.
+            int len = static_cast<unsigned short>(xString->val.str[0]);
+            if (len) {
+                int size = WideCharToMultiByte(CP_ACP, 0, xString->val.str + 1, len, 0, 0, 0, 0);
+                ret.resize(size);
+                WideCharToMultiByte(CP_ACP, 0, xString->val.str + 1, len, &ret[0], size, 0, 0);
+            }
+        }
+
+        // As for ConvertOper::strConv(), strip the suffix of an Excel format object ID.
+        ret.resize(CallingRange::stubLength(ret));
+        return ret;
     }
 
 }
@@ -94,6 +94,57 @@ namespace reposit {
         static std::string strConv(const OPER *xString);
     };
 
+    //! Perform datatype conversions of OPER12s
+    /*! The counterpart of class ConvertOper for the XLOPER12 values received
+        by functions registered with Excel 2007 and later.  Excel 2007 strings
+        hold wide characters, each of which is converted to a char by
+        truncation to eight bits.
+    */
+    class DLL_API ConvertOper12 {
+    public:
+
+        //! Constructor - initialize the variant.
+        ConvertOper12(const OPER12 &xIn, const bool &decayVectorToScalar = true);
+
+        //! \name Inspectors
+        //@{
+        //! Indicate whether the OPER12 value is missing.
+        bool missing() const;
+        //! Indicate whether the OPER12 contains an error value.
+        bool error() const;
+        //@}
+
+        //! \name Conversion Operators
+        //@{
+        //! Convert the OPER12 to a long.
+        operator long() const;
+        //! Convert the OPER12 to an unsigned int.
+        operator unsigned int() const;
+        //! Convert the OPER12 to a double.
+        operator double() const;
+        //! Convert the OPER12 to a boolean.
+        operator bool() const;
+        //! Convert the OPER12 to a std::string.
+        operator std::string() const;
+        //! Convert the OPER12 to a Variant.
+        operator property_t() const;
+        //@}
+
+        //! Deduced C++ typeid - used in the convert templates
+        const std::type_info& type() const;
+
+        //! Return a const pointer to the underlying OPER12.
+        const OPER12 *operator->() const { return oper_; }
+        //! Return a const pointer to the underlying OPER12.
+        const OPER12 *get() const { return oper_; }
+
+    private:
+        // The underlying OPER12.
+        const OPER12 *oper_;
+        // A utility function for converting strings.
+        static std::string strConv(const OPER12 *xString);
+    };
+
 }
 
 #endif
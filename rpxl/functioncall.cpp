@@ -27,19 +27,30 @@
 
 namespace reposit {
 
-    FunctionCall *FunctionCall::instance_ = 0;
+    // A thread local variable may not be exported from a DLL
+    // so instead of a static member we use a static variable.
+    RPXL_THREAD_LOCAL FunctionCall *instance_ = 0;
 
-    FunctionCall::FunctionCall(const std::string functionName) :
+    FunctionCall::FunctionCall(const std::string functionName, bool readOnly) :
             functionName_(functionName), 
             callerDimensions_(CallerDimensions::Uninitialized),
+            hasCallerId_(false),
             error_(false) {
         RP_REQUIRE(!instance_, "Multiple attempts to initialize global FunctionCall object");
+        if (readOnly)
+            readLock_.reset(new RepositoryReadLock);
+        else
+            writeLock_.reset(new RepositoryWriteLock);
         instance_ = this;
 
         Excel(xlfCaller, &xCaller_, 0);
         if (xCaller_->xltype == xltypeRef || xCaller_->xltype == xltypeSRef) {
-            Excel(xlfReftext, &xReftext_, 1, &xCaller_);
-            refStr_ = ConvertOper(xReftext_());
+            if (xCaller_->xltype == xltypeRef && xCaller_->val.mref.lpmref
+                && xCaller_->val.mref.lpmref->count == 1) {
+                callerId_.idSheet = xCaller_->val.mref.idSheet;
+                callerId_.ref = xCaller_->val.mref.lpmref->reftbl[0];
+                hasCallerId_ = true;
+            }
             callerType_ = CallerType::Cell;
         } else if (xCaller_->xltype & xltypeErr) {
             callerType_ = CallerType::VBA;
@@ -66,6 +77,26 @@ namespace reposit {
         return *instance_;
     }
 
+    const XLOPER *FunctionCall::callerAddress() {
+        if (!xReftext_->xltype && callerType_ == CallerType::Cell)
+            Excel(xlfReftext, &xReftext_, 1, &xCaller_);
+        return &xReftext_;
+    }
+
+    const std::string &FunctionCall::refStr() {
+        if (refStr_.empty() && callerType_ == CallerType::Cell) {
+            std::string refStr = ConvertOper(*callerAddress());
+            refStr_ = refStr;
+        }
+        return refStr_;
+    }
+
+    bool FunctionCall::callerId(CallerId &id) const {
+        if (hasCallerId_)
+            id = callerId_;
+        return hasCallerId_;
+    }
+
     const XLOPER *FunctionCall::callerArray() {
         if (!xMulti_->xltype) Excel(xlCoerce, &xMulti_, 2, &xCaller_, TempInt(xltypeMulti));
         return &xMulti_;
@@ -75,7 +106,8 @@ namespace reposit {
         if (address_.empty()) {
             Xloper xAddress;
             Excel(xlfGetCell, &xAddress, 2, TempNum(1), &xCaller_);
-            address_ = ConvertOper(xAddress());
+            std::string address = ConvertOper(xAddress());
+            address_ = address;
         }
         return address_;
     }
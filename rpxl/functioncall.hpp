@@ -28,6 +28,7 @@
 #include <rpxl/rpxldefines.hpp>
 #include <rpxl/xloper.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
 
 namespace reposit {
 
@@ -46,28 +47,64 @@ namespace reposit {
         enum Type { Cell, VBA, Menu, Unknown };
     };
 
+    //! Identify a calling range without converting its reference to text.
+    /*! Built from the sheet ID and coordinates of the xltypeRef value
+        returned by xlfCaller.
+    */
+    struct CallerId {
+        //! The ID of the worksheet.
+        IDSHEET idSheet;
+        //! The coordinates of the range.
+        XLREF ref;
+    };
+
+    //! Order CallerId values so that they may be used as map keys.
+    inline bool operator<(const CallerId &lhs, const CallerId &rhs) {
+        if (lhs.idSheet != rhs.idSheet) return lhs.idSheet < rhs.idSheet;
+        if (lhs.ref.rwFirst != rhs.ref.rwFirst) return lhs.ref.rwFirst < rhs.ref.rwFirst;
+        if (lhs.ref.colFirst != rhs.ref.colFirst) return lhs.ref.colFirst < rhs.ref.colFirst;
+        if (lhs.ref.rwLast != rhs.ref.rwLast) return lhs.ref.rwLast < rhs.ref.rwLast;
+        return lhs.ref.colLast < rhs.ref.colLast;
+    }
+
+    class RepositoryReadLock;
+    class RepositoryWriteLock;
+
     //! Singleton encapsulating state relating to Excel function call.
     /*! An instance of this object is instantiated on the stack when the
         function is invoked such that the object goes out of scope when
         the function exits.  This class allows global access to
         function-specific state e.g. a reference to the range from which
         the active function was called.
+
+        The instance is global to the thread which invoked the function, so
+        that Excel may call functions concurrently on different threads.  For
+        the lifetime of the instance, i.e. for the whole of the function call,
+        the thread holds access to the Repository, shared if the function is
+        read only, and exclusive otherwise.  A function which modifies the
+        Repository therefore runs alone, while read only functions run
+        concurrently with one another.
     */
     class DLL_API FunctionCall {
     public:
         //! \name Structors and static members
         //@{
         //! Constructor - Store the name of the function in progress.
-        /*! The constructor calls xlfCaller and xlfReftext as the results of
-            these functions are always required in the destructor.
+        /*! The constructor calls xlfCaller, whose result is always required.
+            The call to xlfReftext is deferred until the text of the reference
+            is needed, which is normally only on the error path.
+
+            A function which does not modify the Repository may set readOnly
+            to true, in which case it may run concurrently with other read only
+            functions.
         */
-        FunctionCall(const std::string functionName);
+        FunctionCall(const std::string functionName, bool readOnly = false);
         //! Destructor - Clean up whatever resources were acquired.
         /*! If the function has completed successfully then any error message
             that may be associated with the calling cell is cleared.
         */
         ~FunctionCall();
-        //! A reference to the global FunctionCall Singleton.
+        //! A reference to the FunctionCall Singleton of the calling thread.
         /*! Clients of this class access it with a call to
             \code
                 FunctionCall::instance()
@@ -81,7 +118,9 @@ namespace reposit {
         //! Reference to the caller as returned by Excel function xlfCaller.
         const XLOPER *callerReference() { return &xCaller_; }
         //! Address of the caller as returned by Excel function xlfReftext.
-        const XLOPER *callerAddress() { return &xReftext_; }
+        /*! xlfReftext is called on the first invocation of this function.
+        */
+        const XLOPER *callerAddress();
         //! Calling range, coerced to type xltypeMulti.
         /*! If the caller is not an Excel range then this function returns
             an XLOPER with xltype initialized to zero.
@@ -100,7 +139,7 @@ namespace reposit {
         //! Address of the caller from xlfGetCell, converted to a string.
         const std::string &addressString();
         //! Text reference of the caller as returned by  xlfReftext, converted to a string
-        const std::string &refStr() { return refStr_; }
+        const std::string &refStr();
         //@}
 
         //! \name Inspectors
@@ -115,6 +154,13 @@ namespace reposit {
         CallerDimensions::Type callerDimensions();
         //! The type of the caller.
         CallerType::Type callerType() { return callerType_; }
+        //! Whether the function holds shared, rather than exclusive, access to the Repository.
+        bool readOnly() const { return readLock_.get() != 0; }
+        //! Retrieve the identity of the calling range.
+        /*! Returns false if the identity is not available, which is the case
+            unless xlfCaller returned a reference of type xltypeRef.
+        */
+        bool callerId(CallerId &id) const;
         //@}
 
         //! \name Error Messages
@@ -124,7 +170,8 @@ namespace reposit {
         //@}
 
     private:
-        static FunctionCall *instance_;
+        boost::scoped_ptr<RepositoryReadLock> readLock_;
+        boost::scoped_ptr<RepositoryWriteLock> writeLock_;
         std::string functionName_;
         std::string address_;
         std::string refStr_;
@@ -133,6 +180,8 @@ namespace reposit {
         Xloper xMulti_;
         CallerDimensions::Type callerDimensions_;
         CallerType::Type callerType_;
+        CallerId callerId_;
+        bool hasCallerId_;
         bool error_;
     };
 
@@ -32,12 +32,19 @@
 #pragma comment (linker, "/export:" EXPORT_PREFIX "ohListEnumeratedPairs")
 #pragma comment (linker, "/export:" EXPORT_PREFIX "ohListEnumeratedTypes")
 #pragma comment (linker, "/export:" EXPORT_PREFIX "ohRepositoryCollectGarbage")
+#pragma comment (linker, "/export:" EXPORT_PREFIX "ohRepositoryCollectGarbageIncremental")
 #pragma comment (linker, "/export:" EXPORT_PREFIX "ohRepositoryDeleteAllObjects")
 #pragma comment (linker, "/export:" EXPORT_PREFIX "ohRepositoryDeleteObject")
+#pragma comment (linker, "/export:" EXPORT_PREFIX "ohRepositoryListClassNames")
 #pragma comment (linker, "/export:" EXPORT_PREFIX "ohRepositoryListObjectIDs")
+#pragma comment (linker, "/export:" EXPORT_PREFIX "ohRepositoryListObjectIDs12")
+#pragma comment (linker, "/export:" EXPORT_PREFIX "ohRepositoryListObjectIDsByClass")
 #pragma comment (linker, "/export:" EXPORT_PREFIX "ohRepositoryLogAllObjects")
 #pragma comment (linker, "/export:" EXPORT_PREFIX "ohRepositoryLogObject")
 #pragma comment (linker, "/export:" EXPORT_PREFIX "ohRepositoryObjectCount")
+#pragma comment (linker, "/export:" EXPORT_PREFIX "ohRepositoryObjectCountByClass")
+#pragma comment (linker, "/export:" EXPORT_PREFIX "ohRepositoryReclaimObjects")
+#pragma comment (linker, "/export:" EXPORT_PREFIX "ohRepositorySetDeferredDestruction")
 #pragma comment (linker, "/export:" EXPORT_PREFIX "rpGroup")
 #pragma comment (linker, "/export:" EXPORT_PREFIX "rpGroupList")
 #pragma comment (linker, "/export:" EXPORT_PREFIX "rpGroupSize")
@@ -50,6 +57,7 @@
 #pragma comment (linker, "/export:" EXPORT_PREFIX "ohObjectCallerKey")
 #pragma comment (linker, "/export:" EXPORT_PREFIX "ohObjectClassName")
 #pragma comment (linker, "/export:" EXPORT_PREFIX "ohObjectCreationTime")
+#pragma comment (linker, "/export:" EXPORT_PREFIX "ohObjectDependentIDs")
 #pragma comment (linker, "/export:" EXPORT_PREFIX "ohObjectExists")
 #pragma comment (linker, "/export:" EXPORT_PREFIX "ohObjectIsOrphan")
 #pragma comment (linker, "/export:" EXPORT_PREFIX "ohObjectIsPermanent")
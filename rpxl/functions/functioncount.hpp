@@ -19,4 +19,4 @@
 // Indicate the number of functions in this Addin.  The value may be used by
 // the Addin to return this information to the user.
 
-#define FUNCTION_COUNT 52
+#define FUNCTION_COUNT 59
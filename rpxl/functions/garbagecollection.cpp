@@ -30,7 +30,6 @@
 
 #define XLL_DEC extern "C"
 #define SET_SESSION_ID
-
 XLL_DEC bool *ohRepositoryCollectGarbage(
         OPER *DeletePermanent,
         OPER *Trigger) {
@@ -75,6 +74,53 @@ XLL_DEC bool *ohRepositoryCollectGarbage(
         return 0;
     }
 
+}
+XLL_DEC long *ohRepositoryCollectGarbageIncremental(
+        long *MaxRanges,
+        OPER *DeletePermanent,
+        OPER *Trigger) {
+
+    // declare a shared pointer to the Function Call object
+
+    boost::shared_ptr<reposit::FunctionCall> functionCall;
+
+    try {
+
+        // instantiate the Function Call object
+
+        functionCall = boost::shared_ptr<reposit::FunctionCall>(
+            new reposit::FunctionCall("ohRepositoryCollectGarbageIncremental"));
+
+        reposit::validateRange(Trigger, "Trigger");
+
+        // initialize the session ID (if enabled)
+
+        SET_SESSION_ID
+
+        // convert input datatypes to C++ datatypes
+
+        bool DeletePermanentCpp = reposit::convert<bool>(
+            reposit::ConvertOper(*DeletePermanent), "DeletePermanent", false);
+
+        // invoke the utility function
+
+        static long returnValue;
+        returnValue = reposit::RepositoryXL::instance().collectGarbageIncremental(
+                *MaxRanges,
+                DeletePermanentCpp);
+
+        // convert and return the return value
+
+        return &returnValue;
+
+    } catch (const std::exception &e) {
+        reposit::RepositoryXL::instance().logError(e.what(), functionCall);
+        return 0;
+    } catch (...) {
+        reposit::RepositoryXL::instance().logError("unkown error type", functionCall);
+        return 0;
+    }
+
 }
 XLL_DEC bool *ohRepositoryDeleteAllObjects(
         OPER *DeletePermanent,
@@ -180,7 +226,7 @@ XLL_DEC OPER *ohRepositoryListObjectIDs(
         // instantiate the Function Call object
 
         functionCall = boost::shared_ptr<reposit::FunctionCall>(
-            new reposit::FunctionCall("ohRepositoryListObjectIDs"));
+            new reposit::FunctionCall("ohRepositoryListObjectIDs", true));
 
         reposit::validateRange(Trigger, "Trigger");
 
@@ -195,7 +241,48 @@ XLL_DEC OPER *ohRepositoryListObjectIDs(
 
         // convert and return the return value
 
-        static OPER xRet;
+        static RPXL_THREAD_LOCAL OPER xRet;
+        reposit::vectorToOper(returnValue, xRet);
+        return &xRet;
+
+    } catch (const std::exception &e) {
+        reposit::RepositoryXL::instance().logError(e.what(), functionCall);
+        return 0;
+    } catch (...) {
+        reposit::RepositoryXL::instance().logError("unkown error type", functionCall);
+        return 0;
+    }
+
+}
+XLL_DEC OPER12 *ohRepositoryListObjectIDs12(
+        char *Regex,
+        OPER *Trigger) {
+
+    // declare a shared pointer to the Function Call object
+
+    boost::shared_ptr<reposit::FunctionCall> functionCall;
+
+    try {
+
+        // instantiate the Function Call object
+
+        functionCall = boost::shared_ptr<reposit::FunctionCall>(
+            new reposit::FunctionCall("ohRepositoryListObjectIDs", true));
+
+        reposit::validateRange(Trigger, "Trigger");
+
+        // initialize the session ID (if enabled)
+
+        SET_SESSION_ID
+
+        // invoke the utility function
+
+        std::vector<std::string> returnValue = reposit::RepositoryXL::instance().listObjectIDs(
+                Regex);
+
+        // convert and return the return value
+
+        static RPXL_THREAD_LOCAL OPER12 xRet;
         reposit::vectorToOper(returnValue, xRet);
         return &xRet;
 
@@ -324,3 +411,90 @@ XLL_DEC long *ohRepositoryObjectCount(
     }
 
 }
+XLL_DEC long *ohRepositoryReclaimObjects(
+        long *MaxObjects,
+        OPER *Trigger) {
+
+    // declare a shared pointer to the Function Call object
+
+    boost::shared_ptr<reposit::FunctionCall> functionCall;
+
+    try {
+
+        // instantiate the Function Call object
+
+        functionCall = boost::shared_ptr<reposit::FunctionCall>(
+            new reposit::FunctionCall("ohRepositoryReclaimObjects"));
+
+        reposit::validateRange(Trigger, "Trigger");
+
+        // initialize the session ID (if enabled)
+
+        SET_SESSION_ID
+
+        RP_REQUIRE(*MaxObjects >= 0, "Invalid value for maximum number of objects: " << *MaxObjects);
+
+        // invoke the utility function
+
+        static long returnValue;
+        returnValue = static_cast<long>(reposit::RepositoryXL::instance().reclaimObjects(
+                static_cast<std::size_t>(*MaxObjects)));
+
+        // convert and return the return value
+
+        return &returnValue;
+
+    } catch (const std::exception &e) {
+        reposit::RepositoryXL::instance().logError(e.what(), functionCall);
+        return 0;
+    } catch (...) {
+        reposit::RepositoryXL::instance().logError("unkown error type", functionCall);
+        return 0;
+    }
+
+}
+XLL_DEC bool *ohRepositorySetDeferredDestruction(
+        OPER *Deferred,
+        OPER *Trigger) {
+
+    // declare a shared pointer to the Function Call object
+
+    boost::shared_ptr<reposit::FunctionCall> functionCall;
+
+    try {
+
+        // instantiate the Function Call object
+
+        functionCall = boost::shared_ptr<reposit::FunctionCall>(
+            new reposit::FunctionCall("ohRepositorySetDeferredDestruction"));
+
+        reposit::validateRange(Trigger, "Trigger");
+
+        // initialize the session ID (if enabled)
+
+        SET_SESSION_ID
+
+        // convert input datatypes to C++ datatypes
+
+        bool DeferredCpp = reposit::convert<bool>(
+            reposit::ConvertOper(*Deferred), "Deferred", false);
+
+        // invoke the utility function
+
+        static bool returnValue = true;
+        reposit::RepositoryXL::instance().setDeferredDestruction(
+                DeferredCpp);
+
+        // convert and return the return value
+
+        return &returnValue;
+
+    } catch (const std::exception &e) {
+        reposit::RepositoryXL::instance().logError(e.what(), functionCall);
+        return 0;
+    } catch (...) {
+        reposit::RepositoryXL::instance().logError("unkown error type", functionCall);
+        return 0;
+    }
+
+}
@@ -70,11 +70,12 @@ XLL_DEC char *rpGroup(
 
         // Construct the Value Object
 
-        boost::shared_ptr<reposit::ValueObject> valueObject(
-            new reposit::ValueObjects::rpGroup(
+        boost::shared_ptr<reposit::ValueObject> valueObject =
+            boost::allocate_shared<reposit::ValueObjects::rpGroup>(
+                reposit::Allocator<reposit::ValueObjects::rpGroup>::type(),
                 ObjectIdStrip,
                 ObjectIdListCpp,
-                PermanentCpp));
+                PermanentCpp);
 
         // Construct the Object
         
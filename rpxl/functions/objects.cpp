@@ -216,6 +216,54 @@ XLL_DEC OPER *ohObjectCreationTime(
         return 0;
     }
 
+}
+XLL_DEC OPER *ohObjectDependentIDs(
+        char *ObjectID,
+        OPER *Transitive,
+        OPER *Trigger) {
+
+    // declare a shared pointer to the Function Call object
+
+    boost::shared_ptr<reposit::FunctionCall> functionCall;
+
+    try {
+
+        // instantiate the Function Call object
+
+        functionCall = boost::shared_ptr<reposit::FunctionCall>(
+            new reposit::FunctionCall("ohObjectDependentIDs", true));
+
+        reposit::validateRange(Trigger, "Trigger");
+
+        // initialize the session ID (if enabled)
+
+        SET_SESSION_ID
+
+        // convert input datatypes to C++ datatypes
+
+        bool TransitiveCpp = reposit::convert<bool>(
+            reposit::ConvertOper(*Transitive), "Transitive", false);
+
+        // invoke the utility function
+
+        std::vector<std::string> returnValue = reposit::RepositoryXL::instance().dependentIDs(
+                ObjectID,
+                TransitiveCpp);
+
+        // convert and return the return value
+
+        static RPXL_THREAD_LOCAL OPER xRet;
+        reposit::vectorToOper(returnValue, xRet);
+        return &xRet;
+
+    } catch (const std::exception &e) {
+        reposit::RepositoryXL::instance().logError(e.what(), functionCall);
+        return 0;
+    } catch (...) {
+        reposit::RepositoryXL::instance().logError("unkown error type", functionCall);
+        return 0;
+    }
+
 }
 XLL_DEC OPER *ohObjectExists(
         OPER *ObjectID,
@@ -230,7 +278,7 @@ XLL_DEC OPER *ohObjectExists(
         // instantiate the Function Call object
 
         functionCall = boost::shared_ptr<reposit::FunctionCall>(
-            new reposit::FunctionCall("ohObjectExists"));
+            new reposit::FunctionCall("ohObjectExists", true));
 
         reposit::validateRange(Trigger, "Trigger");
 
@@ -251,7 +299,7 @@ XLL_DEC OPER *ohObjectExists(
 
         // convert and return the return value
 
-        static OPER xRet;
+        static RPXL_THREAD_LOCAL OPER xRet;
         reposit::vectorToOper(returnValue, xRet);
         return &xRet;
 
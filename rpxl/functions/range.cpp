@@ -68,11 +68,12 @@ XLL_DEC char *rpRange(
 
         // Construct the Value Object
 
-        boost::shared_ptr<reposit::ValueObject> valueObject(
-            new reposit::ValueObjects::rpRange(
+        boost::shared_ptr<reposit::ValueObject> valueObject =
+            boost::allocate_shared<reposit::ValueObjects::rpRange>(
+                reposit::Allocator<reposit::ValueObjects::rpRange>::type(),
                 ObjectIdStrip,
                 ValuesCpp,
-                PermanentCpp));
+                PermanentCpp);
 
         // Construct the Object
         
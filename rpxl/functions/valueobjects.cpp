@@ -91,7 +91,7 @@ XLL_DEC OPER *ohObjectPropertyValues(
         // instantiate the Function Call object
 
         functionCall = boost::shared_ptr<reposit::FunctionCall>(
-            new reposit::FunctionCall("ohObjectPropertyValues"));
+            new reposit::FunctionCall("ohObjectPropertyValues", true));
 
         reposit::validateRange(Trigger, "Trigger");
 
@@ -105,7 +105,7 @@ XLL_DEC OPER *ohObjectPropertyValues(
 
         // loop on the input parameter and populate the return vector
 
-        static XLOPER returnValue;
+        static RPXL_THREAD_LOCAL XLOPER returnValue;
 
         reposit::ohObjectPropertyValuesBind bindObject = 
             boost::bind((reposit::ohObjectPropertyValuesSignature)
@@ -26,6 +26,10 @@
 
 #include <rpxl/repositxl.hpp>
 #include <rpxl/utilities/xlutilities.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/scoped_array.hpp>
+#include <algorithm>
+#include <vector>
 
 // The max number of failed loop iterations to be logged.  This is for
 // a 0-based array and will be displayed to user as ERROR_LIMIT+1
@@ -36,6 +40,8 @@ namespace reposit {
     //! Execute one iteration of the loop function
     template<class LoopFunction, class InputType, class OutputType>
     struct LoopIteration {
+        //! The type of the value written to the output OPER.
+        typedef OutputType ResultType;
         void operator()(
                 LoopFunction &loopFunction, 
                 XLOPER &xIn, 
@@ -45,11 +51,16 @@ namespace reposit {
             OutputType returnItem = loopFunction(inputItem);
             scalarToOper(returnItem, xOut, expandVector);
         }
+        //! Invoke the loop function on an input which has already been converted.
+        static ResultType evaluate(LoopFunction &loopFunction, const InputType &inputItem) {
+            return loopFunction(inputItem);
+        }
     };
 
     //! Partial specialization for LoopIteration where return type is void
     template<class LoopFunction, class InputType>
     struct LoopIteration<LoopFunction, InputType, void> {
+        typedef bool ResultType;
         void operator()(
                 LoopFunction &loopFunction, 
                 XLOPER &xIn, 
@@ -59,6 +70,87 @@ namespace reposit {
             loopFunction(inputItem);
             scalarToOper(true, xOut, expandVector);
         }
+        static ResultType evaluate(LoopFunction &loopFunction, const InputType &inputItem) {
+            loopFunction(inputItem);
+            return true;
+        }
+    };
+
+    //! The input to a loop function.
+    /*! If the input is a list or a reference then it is converted to an array,
+        which is freed by the destructor.
+    */
+    class LoopInput {
+    public:
+        LoopInput(OPER *xIn) : xMulti_(0), excelToFree_(false), xllToFree_(false) {
+            // If the input is an array then take its address & carry on
+            if (xIn->xltype == xltypeMulti) {
+                xMulti_ = xIn;
+            // If the input is a list then call split on it
+            } else if (isList(xIn)) {
+                splitOper(xIn, &xTemp_);
+                xMulti_ = &xTemp_;
+                xllToFree_ = true;
+            // If the input is a scalar then there is nothing to convert
+            } else if (xIn->xltype == xltypeNum
+            ||  xIn->xltype == xltypeBool
+            ||  xIn->xltype == xltypeStr) {
+                ;
+            // Some other input (e.g. a reference) - try to convert to an array
+            } else {
+                Excel(xlCoerce, &xTemp_, 2, xIn, TempInt(xltypeMulti));
+                xMulti_ = &xTemp_;
+                excelToFree_ = true;
+            }
+        }
+        ~LoopInput() {
+            if (excelToFree_) {
+                Excel(xlFree, 0, 1, &xTemp_);
+            } else if (xllToFree_) {
+                freeOper(&xTemp_);
+            }
+        }
+        //! The input as an array, or null if the input is a scalar.
+        OPER *multi() const { return xMulti_; }
+    private:
+        LoopInput(const LoopInput&);
+        LoopInput &operator=(const LoopInput&);
+        OPER xTemp_, *xMulti_;
+        bool excelToFree_;
+        bool xllToFree_;
+    };
+
+    //! Accumulate the error messages of failed iterations of a loop function.
+    class LoopErrors {
+    public:
+        LoopErrors() : errorCount_(0) {}
+        //! Record the failure of the given iteration.
+        void add(int i, const char *what) {
+            if (errorCount_ > ERROR_LIMIT) {
+                // Limit exceeded.  Take no action.  For performance reasons we test
+                // this case first since it's most common on big loop w/many errors
+                ;
+            } else if (errorCount_ < ERROR_LIMIT) {
+                err_ << std::endl << std::endl 
+                    << "iteration #" << i << " - " << what;
+                errorCount_++;
+            } else { // errorCount_ == ERROR_LIMIT
+                err_ << std::endl << std::endl 
+                    << "iteration #" << i << " - " << what
+                    << std::endl << std::endl 
+                    << "Count of failed iterations in looping function hit "
+                    << "limit of " << ERROR_LIMIT + 1 << " - logging discontinued";
+                errorCount_++;
+            }
+        }
+        //! Log the accumulated messages, if any, against the calling cell.
+        void log(const boost::shared_ptr<FunctionCall> &functionCall) {
+            if (errorCount_)
+                RepositoryXL::instance().logError(err_.str(), functionCall);
+        }
+    private:
+        int errorCount_;
+        std::ostringstream err_;
     };
 
     //! Invoke the contained function once for each item in the input vector.
@@ -69,31 +161,14 @@ namespace reposit {
               OPER *xIn, 
               XLOPER &xOut) {
 
-        // FIXME - xTemp may not be cleaned up properly in the event of an exception.
-        OPER xTemp, *xMulti;
-        bool excelToFree = false;
-        bool xllToFree = false;
-
-        // If the input is an array then take its address & carry on
-        if (xIn->xltype == xltypeMulti) {
-            xMulti = xIn;
-        // If the input is a list then call split on it
-        } else if (isList(xIn)) {
-            splitOper(xIn, &xTemp);
-            xMulti = &xTemp;
-            xllToFree = true;
+        LoopInput loopInput(xIn);
+        OPER *xMulti = loopInput.multi();
+
         // If the input is a scalar then just call the function once & return
-        } else if (xIn->xltype == xltypeNum
-        ||  xIn->xltype == xltypeBool
-        ||  xIn->xltype == xltypeStr) {
+        if (!xMulti) {
             LoopIteration<LoopFunction, InputType, OutputType>()(
                 loopFunction, *xIn, xOut, true);
             return;
-        // Some other input (e.g. a reference) - try to convert to an array
-        } else {
-            Excel(xlCoerce, &xTemp, 2, xIn, TempInt(xltypeMulti));
-            xMulti = &xTemp;
-            excelToFree = true;
         }
 
         xOut.val.array.rows = xMulti->val.array.rows;
@@ -102,8 +177,7 @@ namespace reposit {
         xOut.val.array.lparray = new XLOPER[numCells]; 
         xOut.xltype = xltypeMulti | xlbitDLLFree;
 
-        int errorCount = 0;
-        std::ostringstream err;
+        LoopErrors loopErrors;
         LoopIteration<LoopFunction, InputType, OutputType> loopIteration;
         for (int i=0; i<numCells; ++i) {
             try {
@@ -114,36 +188,147 @@ namespace reposit {
             } catch (const std::exception &e) {
                 xOut.val.array.lparray[i].xltype = xltypeErr;
                 xOut.val.array.lparray[i].val.err = xlerrNum;
+                loopErrors.add(i, e.what());
+            }
+        }
 
-                if (errorCount > ERROR_LIMIT) {
-                    // Limit exceeded.  Take no action.  For performance reasons we test
-                    // this case first since it's most common on big loop w/many errors
-                    ;
-                } else if (errorCount < ERROR_LIMIT) {
-                    err << std::endl << std::endl 
-                        << "iteration #" << i << " - " << e.what();
-                    errorCount++;
-                } else { // errorCount == ERROR_LIMIT
-                    err << std::endl << std::endl 
-                        << "iteration #" << i << " - " << e.what()
-                        << std::endl << std::endl 
-                        << "Count of failed iterations in looping function hit "
-                        << "limit of " << ERROR_LIMIT + 1 << " - logging discontinued";
-                    errorCount++;
+        loopErrors.log(functionCall);
+    }
+
+    //! Evaluate a share of the iterations of a parallel loop.
+    /*! Worker threads must not call back into Excel, so the inputs are
+        converted, and the outputs written, by the calling thread.  Each
+        worker writes only to the elements of the vectors which it owns.
+    */
+    template<class LoopFunction, class InputType, class OutputType>
+    class LoopWorker {
+    public:
+        typedef typename LoopIteration<LoopFunction, InputType, OutputType>::ResultType ResultType;
+        LoopWorker(
+            LoopFunction &loopFunction,
+            const std::vector<InputType> &inputs,
+            ResultType *results,
+            std::vector<char> &failed,
+            std::vector<std::string> &errors,
+            int begin,
+            int end)
+            : loopFunction_(loopFunction), inputs_(inputs), results_(results),
+              failed_(failed), errors_(errors), begin_(begin), end_(end) {}
+        void operator()() {
+            for (int i=begin_; i<end_; ++i) {
+                if (failed_[i])
+                    continue;
+                try {
+                    results_[i] = LoopIteration<LoopFunction, InputType, OutputType>::evaluate(
+                        loopFunction_, inputs_[i]);
+                } catch (const std::exception &e) {
+                    failed_[i] = true;
+                    errors_[i] = e.what();
+                } catch (...) {
+                    failed_[i] = true;
+                    errors_[i] = "unknown error type";
                 }
             }
         }
+    private:
+        LoopFunction &loopFunction_;
+        const std::vector<InputType> &inputs_;
+        // An array rather than a vector, because concurrent writes to
+        // distinct elements of std::vector<bool> are not safe.
+        ResultType *results_;
+        std::vector<char> &failed_;
+        std::vector<std::string> &errors_;
+        int begin_, end_;
+    };
 
-        if (errorCount)
-            RepositoryXL::instance().logError(err.str(), functionCall);
+    //! Invoke the contained function for the items in the input vector on several threads.
+    /*! Equivalent to loop(), but for use only with loop functions which are
+        thread safe, and which do not call back into Excel.  The iterations are
+        divided between threadCount threads, by default one per processor.
+        Errors are logged as by loop(), in order of iteration.
+    */
+    template<class LoopFunction, class InputType, class OutputType>
+    void loopParallel(
+              const boost::shared_ptr<FunctionCall> &functionCall,
+              LoopFunction &loopFunction, 
+              OPER *xIn, 
+              XLOPER &xOut,
+              unsigned int threadCount = 0) {
 
-        // Free memory
-        if (excelToFree) {
-            Excel(xlFree, 0, 1, &xTemp);
-        } else if (xllToFree) {
-            freeOper(&xTemp);
+        typedef LoopWorker<LoopFunction, InputType, OutputType> Worker;
+        typedef typename Worker::ResultType ResultType;
+
+        if (threadCount == 0)
+            threadCount = boost::thread::hardware_concurrency();
+        if (threadCount < 2) {
+            loop<LoopFunction, InputType, OutputType>(functionCall, loopFunction, xIn, xOut);
+            return;
+        }
+
+        LoopInput loopInput(xIn);
+        OPER *xMulti = loopInput.multi();
+
+        // If the input is a scalar then just call the function once & return
+        if (!xMulti) {
+            LoopIteration<LoopFunction, InputType, OutputType>()(
+                loopFunction, *xIn, xOut, true);
+            return;
+        }
+
+        int numCells = xMulti->val.array.rows * xMulti->val.array.columns;
+
+        // Convert the inputs on this thread.
+        std::vector<InputType> inputs(numCells);
+        boost::scoped_array<ResultType> results(new ResultType[numCells]);
+        std::vector<char> failed(numCells, false);
+        std::vector<std::string> errors(numCells);
+        for (int i=0; i<numCells; ++i) {
+            try {
+                inputs[i] = reposit::convert<InputType>(ConvertOper(xMulti->val.array.lparray[i]));
+            } catch (const std::exception &e) {
+                failed[i] = true;
+                errors[i] = e.what();
+            }
+        }
+
+        // Evaluate the loop function in contiguous slices, one per thread.
+        int slices = std::min<int>(threadCount, numCells);
+        int sliceSize = (numCells + slices - 1) / slices;
+        boost::thread_group threads;
+        try {
+            for (int begin=0; begin<numCells; begin+=sliceSize) {
+                threads.create_thread(Worker(loopFunction, inputs, results.get(), failed, errors,
+                    begin, std::min(begin + sliceSize, numCells)));
+            }
+        } catch (...) {
+            // The threads already started refer to the local vectors.
+            threads.join_all();
+            throw;
+        }
+        threads.join_all();
+
+        // Write the outputs on this thread.
+        xOut.val.array.rows = xMulti->val.array.rows;
+        xOut.val.array.columns = xMulti->val.array.columns;
+        xOut.val.array.lparray = new XLOPER[numCells]; 
+        xOut.xltype = xltypeMulti | xlbitDLLFree;
+
+        LoopErrors loopErrors;
+        for (int i=0; i<numCells; ++i) {
+            if (!failed[i]) {
+                try {
+                    scalarToOper(results[i], xOut.val.array.lparray[i], false);
+                    continue;
+                } catch (const std::exception &e) {
+                    errors[i] = e.what();
+                }
+            }
+            xOut.val.array.lparray[i].xltype = xltypeErr;
+            xOut.val.array.lparray[i].val.err = xlerrNum;
+            loopErrors.add(i, errors[i].c_str());
         }
 
+        loopErrors.log(functionCall);
     }
 
 }
@@ -29,11 +29,11 @@ namespace reposit {
         const boost::shared_ptr<Object> &object,
         const boost::shared_ptr<CallingRange> &callingRange)
             : id_(id), ObjectWrapper(object), callingRange_(callingRange) {
-        idFull_ = callingRange_->updateID(id_);
+        callingRange_->updateID(id_, idFull_);
     };
 
     ObjectWrapperXL::~ObjectWrapperXL() {
-        callingRange_->unregisterObject(id_);
+        callingRange_->unregisterObject(id_, this);
     }
 
     void  ObjectWrapperXL::dump(std::ostream& out) {
@@ -47,7 +47,7 @@ namespace reposit {
 
     void ObjectWrapperXL::reset(boost::shared_ptr<Object> object) {
         ObjectWrapper::reset(object);
-        idFull_ = callingRange_->updateID(id_);
+        callingRange_->updateID(id_, idFull_);
     }
 
     std::string ObjectWrapperXL::callerKey() const {
@@ -59,7 +59,7 @@ namespace reposit {
     }
 
     void ObjectWrapperXL::resetCaller(boost::shared_ptr<CallingRange> callingRange) {
-        callingRange_->unregisterObject(id_);
+        callingRange_->unregisterObject(id_, this);
         callingRange_ = callingRange;
     }
 
@@ -21,87 +21,122 @@
 #include <rpxl/configuration.hpp>
 #include <rp/exception.hpp>
 #include <rp/utilities.hpp>
-#include <boost/lexical_cast.hpp>
 
 namespace reposit {
 
-    boost::regex RangeReference::regexStandard_;
-    boost::regex RangeReference::regexSpecial_;
-    bool RangeReference::regexesInitialized_ = false;
+    namespace {
+
+        // Excel supports at most 1048576 rows and 16384 columns.
+        const int MAX_COORDINATE = 1048576;
+
+        // Read the digits at the given offset into an int, advance the offset
+        // past the digits and return true if there was at least one digit.
+        bool parseNumber(const std::string &s, std::string::size_type &i, int &value) {
+            std::string::size_type start = i;
+            value = 0;
+            while (i < s.length() && s[i] >= '0' && s[i] <= '9') {
+                value = value * 10 + (s[i] - '0');
+                if (value > MAX_COORDINATE)
+                    return false;
+                ++i;
+            }
+            return i > start;
+        }
+
+        // Read a reference to a single cell e.g. R1C1.
+        bool parseCell(const std::string &s, std::string::size_type &i, int &row, int &col) {
+            if (i >= s.length() || s[i] != Configuration::instance().rowCharacter())
+                return false;
+            if (!parseNumber(s, ++i, row))
+                return false;
+            if (i >= s.length() || s[i] != Configuration::instance().colCharacter())
+                return false;
+            return parseNumber(s, ++i, col);
+        }
+    }
 
     RangeReference::RangeReference(const std::string &address)
         : address_(address) {
 
-        if (!regexesInitialized_) initializeRegexes();
-
-        RP_REQUIRE(initStandard() || initSpecial(),
+        RP_REQUIRE(parse(),
             "The string '" << address << "' is not a valid range reference");
     }
 
-    void RangeReference::initializeRegexes() {
+    bool RangeReference::parse() {
 
-        std::ostringstream strStandard, strSpecial;
-        strStandard << "=?'?.*\\[([\\.\\w\\s-]+)(?:\\.XLS)?\\]([\\w\\s]+)'?!" 
-            << Configuration::instance().rowCharacter() << "(\\d*)" 
-            << Configuration::instance().colCharacter() << "(\\d*)(?::" 
-            << Configuration::instance().rowCharacter() << "(\\d*)" 
-            << Configuration::instance().colCharacter() << "(\\d*))?";
-        strSpecial << "=?'?([\\w\\s]+)(?:\\.XLS)'?!" 
-            << Configuration::instance().rowCharacter() << "(\\d*)" 
-            << Configuration::instance().colCharacter() << "(\\d*)(?::" 
-            << Configuration::instance().rowCharacter() << "(\\d*)" 
-            << Configuration::instance().colCharacter() << "(\\d*))?";
+        // The cell reference follows the last '!'.  Neither book nor sheet
+        // names may contain '!' unless quoted, and a quoted name is followed
+        // by the closing quote and then '!'.
+        std::string::size_type bang = address_.rfind('!');
+        if (bang == std::string::npos)
+            return false;
 
-        regexStandard_ = strStandard.str();
-        regexSpecial_ = strSpecial.str();
+        std::string::size_type begin = 0, end = bang;
+        if (begin < end && address_[begin] == '=')
+            ++begin;
+        if (begin < end && address_[begin] == '\'') {
+            if (end - begin < 2 || address_[end - 1] != '\'')
+                return false;
+            ++begin;
+            --end;
+        }
 
-        regexesInitialized_ = true;
+        return parseName(begin, end) && parseCells(bang + 1);
     }
 
-    bool RangeReference::initStandard() {
-        // try to handle the usual case where book name != sheet name
+    bool RangeReference::parseName(std::string::size_type begin, std::string::size_type end) {
 
-        boost::smatch m; 
-        if (!boost::regex_match(address_, m, regexStandard_))
+        if (begin >= end)
             return false;
 
-        bookName_ = m[1];
-        sheetName_ = m[2];
-        rowStartNum_ = boost::lexical_cast<int>(m[3]);
-        colStartNum_ = boost::lexical_cast<int>(m[4]);
-        if (m[5].matched) {
-            multicell_ = true;
-            rowEndNum_ = boost::lexical_cast<int>(m[5]);
-            colEndNum_ = boost::lexical_cast<int>(m[6]);
+        // A doubled single quote inside a quoted name represents one quote.
+        std::string name(address_, begin, end - begin);
+        for (std::string::size_type i = name.find('\''); i != std::string::npos; i = name.find('\'', i + 1)) {
+            if (i + 1 < name.length() && name[i + 1] == '\'')
+                name.erase(i, 1);
+        }
+
+        // Strip any filesystem path.  The path precedes the opening bracket
+        // of the book name, and may itself contain brackets.
+        std::string::size_type close = name.rfind(']');
+        std::string::size_type separator = name.find_last_of("\\/", close);
+        std::string::size_type start = separator == std::string::npos ? 0 : separator + 1;
+
+        if (close != std::string::npos) {
+            // The usual case - [book]sheet.  Sheet names may not contain brackets.
+            std::string::size_type open = name.find('[', start);
+            if (open == std::string::npos || open >= close || close + 1 == name.length())
+                return false;
+            bookName_.assign(name, open + 1, close - open - 1);
+            sheetName_.assign(name, close + 1, std::string::npos);
         } else {
-            multicell_ = false;
-            rowEndNum_ = -1;
-            colEndNum_ = -1;
+            // The special case of a book containing a single sheet with the same
+            // name as the book - book.xls, in which the extension is dropped.
+            std::string::size_type dot = name.rfind('.');
+            if (dot == std::string::npos || dot <= start)
+                return false;
+            bookName_.assign(name, start, dot - start);
+            sheetName_ = bookName_;
         }
-        return true;
+        return !bookName_.empty();
     }
 
-    bool RangeReference::initSpecial() {
-        // try to handle special case of book containing single sheet w/same name
+    bool RangeReference::parseCells(std::string::size_type begin) {
 
-        boost::smatch m; 
-        if (!boost::regex_match(address_, m, regexSpecial_))
+        std::string::size_type i = begin;
+        if (!parseCell(address_, i, rowStartNum_, colStartNum_))
             return false;
 
-        bookName_ = m[1];
-        sheetName_ = m[1];
-        rowStartNum_ = boost::lexical_cast<int>(m[2]);
-        colStartNum_ = boost::lexical_cast<int>(m[3]);
-        if (m[4].matched) {
+        if (i < address_.length() && address_[i] == ':') {
             multicell_ = true;
-            rowEndNum_ = boost::lexical_cast<int>(m[4]);
-            colEndNum_ = boost::lexical_cast<int>(m[5]);
+            if (!parseCell(address_, ++i, rowEndNum_, colEndNum_))
+                return false;
         } else {
             multicell_ = false;
             rowEndNum_ = -1;
             colEndNum_ = -1;
         }
-        return true;
+        return i == address_.length();
     }
 
     bool RangeReference::contains(const RangeReference &r) const {
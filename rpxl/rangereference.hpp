@@ -22,7 +22,6 @@
 */
 
 #include <rpxl/rpxldefines.hpp>
-#include <boost/regex.hpp>
 #include <string>
 
 namespace reposit {
@@ -76,6 +75,13 @@ namespace reposit {
             "'same name.xls'!R1C1"
         \endcode
 
+        Sheet names may contain any character permitted by Excel, including
+        parentheses, and a single quote within a quoted name is doubled:
+        \code
+            "'[Book1.xls]1M (2)'!R4C1"
+            "'[Book1.xls]Bob''s Sheet'!R4C1"
+        \endcode
+
         In all cases, the cell reference, represented above as R1C1, may also
         be given as R1C1:R9C9 i.e. a range consisting of multiple cells, in
         which case the RangeReference constructor sets multicell_ to true.
@@ -87,15 +93,8 @@ namespace reposit {
         //@{
         //! Constructor - initialize the RangeReference object.
         /*! Parse the input string and store its component tokens in separate
-            variables e.g. bookName_, sheetName_, etc.
-
-            \bug This constructor fails for the following value of address:<br>
-                  <tt>"'[GBP_MARKET_AND_TRADES.XLSX]1M (2)'!R4C1"</tt><br>
-            The bug probably affects all worksheets whose name contains
-            parentheses.  The effect of the bug is that if a function on that
-            worksheet fails, the function returns \c #NUM as usual, but no error
-            message is associated with the calling cell, and
-            \c ohRangeRetrieveError() does not work for that worksheet.
+            variables e.g. bookName_, sheetName_, etc.  The string is parsed in
+            a single pass, without recourse to regular expressions.
         */
         RangeReference(const std::string &address);
         //@}
@@ -117,6 +116,24 @@ namespace reposit {
         bool contains(const RangeReference&) const;
         //@}
 
+        //! \name Inspectors
+        //@{
+        //! The name of the workbook.
+        const std::string &bookName() const { return bookName_; }
+        //! The name of the worksheet.
+        const std::string &sheetName() const { return sheetName_; }
+        //! Whether the range consists of more than one cell.
+        bool multicell() const { return multicell_; }
+        //! The first row of the range.
+        int rowStart() const { return rowStartNum_; }
+        //! The first column of the range.
+        int colStart() const { return colStartNum_; }
+        //! The last row of the range, the same as rowStart() for a single cell.
+        int rowEnd() const { return multicell_ ? rowEndNum_ : rowStartNum_; }
+        //! The last column of the range, the same as colStart() for a single cell.
+        int colEnd() const { return multicell_ ? colEndNum_ : colStartNum_; }
+        //@}
+
         //! \name Error Messages
         //@{
         //! Assign an error message to this range.
@@ -128,9 +145,9 @@ namespace reposit {
         //@}
 
     private:
-        static void initializeRegexes();
-        bool initStandard();
-        bool initSpecial();
+        bool parse();
+        bool parseName(std::string::size_type begin, std::string::size_type end);
+        bool parseCells(std::string::size_type begin);
 
         std::string address_;
         std::string bookName_;
@@ -141,9 +158,6 @@ namespace reposit {
         int rowEndNum_;
         int colEndNum_;
         std::string errorMessage_;
-        static boost::regex regexStandard_;
-        static boost::regex regexSpecial_;
-        static bool regexesInitialized_;
     };
 
     std::ostream &operator<<(std::ostream&, const RangeReference&);
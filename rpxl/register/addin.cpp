@@ -19,6 +19,7 @@
 
 #include <xlsdk/xlsdkdefines.hpp>
 #include <rpxl/repositxl.hpp>
+#include <rpxl/callingrange.hpp>
 #include <rpxl/register/register_all.hpp>
 #include <rpxl/functions/export.hpp>
 #include <rpxl/conversions/all.hpp>
@@ -34,6 +35,72 @@ reposit::EnumClassRegistry enumClassRegistry;
 // Instantiate the Enumerated Pair Registry
 reposit::EnumPairRegistry enumPairRegistry;
 
+// Command invoked by Excel at the end of each calculation cycle, which
+// creates and deletes the hidden names queued by class CallingRange.
+DLLEXPORT int rpFlushNames() {
+
+    try {
+        reposit::CallingRange::flushNames();
+    } catch (...) {
+    }
+    return 1;
+}
+
+namespace {
+
+    // Register rpFlushNames() as the handler for the end of calculation.  The
+    // events are supported from Excel 2010.  If the registration fails then
+    // calling ranges are named immediately.
+    void registerFlushNames(const XLOPER &xDll) {
+
+        try {
+
+            Excel(xlfRegister, 0, 6, &xDll,
+                TempStrNoSize("\x0C""rpFlushNames"),
+                TempStrNoSize("\x01""J"),
+                TempStrNoSize("\x0C""rpFlushNames"),
+                TempStrNoSize("\x00"""),
+                TempStrNoSize("\x01""2"));
+
+            XLOPER xEnded, xCanceled;
+            Excel(xlEventRegister, &xEnded, 2,
+                TempStrNoSize("\x0C""rpFlushNames"), TempInt(xleventCalculationEnded));
+            Excel(xlEventRegister, &xCanceled, 2,
+                TempStrNoSize("\x0C""rpFlushNames"), TempInt(xleventCalculationCanceled));
+
+            reposit::CallingRange::setDeferNames(
+                xEnded.xltype == xltypeBool && xEnded.val.xbool
+                && xCanceled.xltype == xltypeBool && xCanceled.val.xbool);
+
+        } catch (...) {
+            reposit::CallingRange::setDeferNames(false);
+        }
+    }
+
+    void unregisterFlushNames(const XLOPER &xDll) {
+
+        if (!reposit::CallingRange::deferNames())
+            return;
+
+        // Issue any outstanding calls to xlfSetName.
+        reposit::CallingRange::setDeferNames(false);
+
+        try {
+
+            Excel(xlEventRegister, 0, 2, TempNil(), TempInt(xleventCalculationEnded));
+            Excel(xlEventRegister, 0, 2, TempNil(), TempInt(xleventCalculationCanceled));
+
+            XLOPER xlRegID;
+            Excel4(xlfRegisterId, &xlRegID, 2, &xDll,
+                TempStrNoSize("\x0C""rpFlushNames"));
+            Excel4(xlfUnregister, 0, 1, &xlRegID);
+
+        } catch (...) {
+        }
+    }
+
+}
+
 DLLEXPORT int xlAutoOpen() {
 
     static XLOPER xDll;
@@ -44,6 +111,7 @@ DLLEXPORT int xlAutoOpen() {
 
         reposit::Configuration::instance().init();
         registerOhFunctions(xDll);
+        registerFlushNames(xDll);
 
         Excel(xlFree, 0, 1, &xDll);
         return 1;
@@ -75,11 +143,16 @@ DLLEXPORT int xlAutoClose() {
         // Get the DLL name.
         Excel(xlGetName, &xDll, 0);
         // Unregister the addin functions.
+        unregisterFlushNames(xDll);
         unregisterOhFunctions(xDll);
-        // Clear the state of the Repository.
+        // Clear the state of the Repository.  Objects awaiting deferred
+        // destruction must be destroyed before the addin is unloaded.
+        reposit::RepositoryXL::instance().setDeferredDestruction(false);
         reposit::RepositoryXL::instance().clear();
         // Release the DLL name.
         Excel(xlFree, 0, 1, &xDll);
+        // Return the temporary memory of xlsdk to the heap.
+        ReleaseTempMemory();
 
         return 1;
 
@@ -105,6 +178,12 @@ DLLEXPORT void xlAutoFree(XLOPER *px) {
 
 }
 
+DLLEXPORT void xlAutoFree12(XLOPER12 *px) {
+
+    freeOper(px);
+
+}
+
 DLLEXPORT XLOPER *xlAddInManagerInfo(XLOPER *xlAction) {
 
     XLOPER xlReturn;
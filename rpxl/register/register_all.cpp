@@ -25,6 +25,7 @@ extern void registerLogging(const XLOPER&);
 extern void registerObjects(const XLOPER&);
 extern void registerOhutils(const XLOPER&);
 extern void registerRange(const XLOPER&);
+extern void registerRepository(const XLOPER&);
 extern void registerSerialization(const XLOPER&);
 extern void registerValueobjects(const XLOPER&);
 
@@ -35,6 +36,7 @@ extern void unregisterLogging(const XLOPER&);
 extern void unregisterObjects(const XLOPER&);
 extern void unregisterOhutils(const XLOPER&);
 extern void unregisterRange(const XLOPER&);
+extern void unregisterRepository(const XLOPER&);
 extern void unregisterSerialization(const XLOPER&);
 extern void unregisterValueobjects(const XLOPER&);
 
@@ -47,6 +49,7 @@ void registerOhFunctions(const XLOPER &xDll) {
         registerObjects(xDll);
         registerOhutils(xDll);
         registerRange(xDll);
+        registerRepository(xDll);
         registerSerialization(xDll);
         registerValueobjects(xDll);
 
@@ -61,6 +64,7 @@ void unregisterOhFunctions(const XLOPER &xDll) {
         unregisterObjects(xDll);
         unregisterOhutils(xDll);
         unregisterRange(xDll);
+        unregisterRepository(xDll);
         unregisterSerialization(xDll);
         unregisterValueobjects(xDll);
 
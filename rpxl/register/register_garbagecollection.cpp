@@ -17,6 +17,7 @@
 */
 
 #include <xlsdk/xlsdkdefines.hpp>
+#include <rpxl/rpxldefines.hpp>
 
 // register functions in category Garbagecollection with Excel
 
@@ -45,6 +46,30 @@ void registerGarbagecollection(const XLOPER &xDll) {
             TempStrNoSize("\x35""also delete permanent objects. Default value = false."),
             TempStrNoSize("\x1D""dependency tracking trigger  "));
 
+        Excel(xlfRegister, 0, 13, &xDll,
+            // function code name
+            TempStrNoSize("\x25""ohRepositoryCollectGarbageIncremental"),
+            // parameter codes
+            TempStrNoSize("\x05""NNPP#"),
+            // function display name
+            TempStrNoSize("\x25""ohRepositoryCollectGarbageIncremental"),
+            // comma-delimited list of parameter names
+            TempStrNoSize("\x21""MaxRanges,DeletePermanent,Trigger"),
+            // function type (0 = hidden, 1 = worksheet)
+            TempStrNoSize("\x01""1"),
+            // function category
+            TempStrNoSize("\x07""reposit"),
+            // shortcut text (command macros only)
+            TempStrNoSize("\x00"""),
+            // path to help file
+            TempStrNoSize("\x00"""),
+            // function description
+            TempStrNoSize("\x64""delete orphaned objects from a bounded number of calling ranges, returns #/ranges remaining in pass."),
+            // parameter descriptions
+            TempStrNoSize("\x2A""maximum number of calling ranges to check."),
+            TempStrNoSize("\x35""also delete permanent objects. Default value = false."),
+            TempStrNoSize("\x1D""dependency tracking trigger  "));
+
         Excel(xlfRegister, 0, 12, &xDll,
             // function code name
             TempStrNoSize("\x1C""ohRepositoryDeleteAllObjects"),
@@ -91,11 +116,17 @@ void registerGarbagecollection(const XLOPER &xDll) {
             TempStrNoSize("\x1B""ID of object to be deleted."),
             TempStrNoSize("\x1D""dependency tracking trigger  "));
 
+        // Excel 2007 and later call the XLOPER12 entry point, which
+        // is not limited to the Excel 97 grid size.
         Excel(xlfRegister, 0, 12, &xDll,
             // function code name
-            TempStrNoSize("\x19""ohRepositoryListObjectIDs"),
+            XLCallVer() >= 0x0C00
+                ? TempStrNoSize("\x1B""ohRepositoryListObjectIDs12")
+                : TempStrNoSize("\x19""ohRepositoryListObjectIDs"),
             // parameter codes
-            TempStrNoSize("\x04""PCP#"),
+            XLCallVer() >= 0x0C00
+                ? TempStrNoSize("\x04""QCP" RPXL_READER_CODE)
+                : TempStrNoSize("\x04""PCP" RPXL_READER_CODE),
             // function display name
             TempStrNoSize("\x19""ohRepositoryListObjectIDs"),
             // comma-delimited list of parameter names
@@ -181,6 +212,52 @@ void registerGarbagecollection(const XLOPER &xDll) {
             // parameter descriptions
             TempStrNoSize("\x1D""dependency tracking trigger  "));
 
+        Excel(xlfRegister, 0, 12, &xDll,
+            // function code name
+            TempStrNoSize("\x1A""ohRepositoryReclaimObjects"),
+            // parameter codes
+            TempStrNoSize("\x04""NNP#"),
+            // function display name
+            TempStrNoSize("\x1A""ohRepositoryReclaimObjects"),
+            // comma-delimited list of parameter names
+            TempStrNoSize("\x12""MaxObjects,Trigger"),
+            // function type (0 = hidden, 1 = worksheet)
+            TempStrNoSize("\x01""1"),
+            // function category
+            TempStrNoSize("\x07""reposit"),
+            // shortcut text (command macros only)
+            TempStrNoSize("\x00"""),
+            // path to help file
+            TempStrNoSize("\x00"""),
+            // function description
+            TempStrNoSize("\x5A""destroy a bounded number of deleted objects, returns #/objects still awaiting destruction."),
+            // parameter descriptions
+            TempStrNoSize("\x3D""maximum number of objects to destroy, or zero to destroy all."),
+            TempStrNoSize("\x1D""dependency tracking trigger  "));
+
+        Excel(xlfRegister, 0, 12, &xDll,
+            // function code name
+            TempStrNoSize("\x22""ohRepositorySetDeferredDestruction"),
+            // parameter codes
+            TempStrNoSize("\x04""LPP#"),
+            // function display name
+            TempStrNoSize("\x22""ohRepositorySetDeferredDestruction"),
+            // comma-delimited list of parameter names
+            TempStrNoSize("\x10""Deferred,Trigger"),
+            // function type (0 = hidden, 1 = worksheet)
+            TempStrNoSize("\x01""1"),
+            // function category
+            TempStrNoSize("\x07""reposit"),
+            // shortcut text (command macros only)
+            TempStrNoSize("\x00"""),
+            // path to help file
+            TempStrNoSize("\x00"""),
+            // function description
+            TempStrNoSize("\x44""queue deleted objects for destruction by ohRepositoryReclaimObjects."),
+            // parameter descriptions
+            TempStrNoSize("\x58""true to queue deleted objects, false to destroy them immediately. Default value = false."),
+            TempStrNoSize("\x1D""dependency tracking trigger  "));
+
 
 
 }
@@ -222,6 +299,34 @@ void unregisterGarbagecollection(const XLOPER &xDll) {
             TempStrNoSize("\x1A""ohRepositoryCollectGarbage"));
         Excel4(xlfUnregister, 0, 1, &xlRegID);
 
+        Excel(xlfRegister, 0, 13, &xDll,
+            // function code name
+            TempStrNoSize("\x25""ohRepositoryCollectGarbageIncremental"),
+            // parameter codes
+            TempStrNoSize("\x05""NNPP#"),
+            // function display name
+            TempStrNoSize("\x25""ohRepositoryCollectGarbageIncremental"),
+            // comma-delimited list of parameter names
+            TempStrNoSize("\x21""MaxRanges,DeletePermanent,Trigger"),
+            // function type (0 = hidden, 1 = worksheet)
+            TempStrNoSize("\x01""0"),
+            // function category
+            TempStrNoSize("\x07""reposit"),
+            // shortcut text (command macros only)
+            TempStrNoSize("\x00"""),
+            // path to help file
+            TempStrNoSize("\x00"""),
+            // function description
+            TempStrNoSize("\x64""delete orphaned objects from a bounded number of calling ranges, returns #/ranges remaining in pass."),
+            // parameter descriptions
+            TempStrNoSize("\x2A""maximum number of calling ranges to check."),
+            TempStrNoSize("\x35""also delete permanent objects. Default value = false."),
+            TempStrNoSize("\x1D""dependency tracking trigger  "));
+
+        Excel4(xlfRegisterId, &xlRegID, 2, &xDll,
+            TempStrNoSize("\x25""ohRepositoryCollectGarbageIncremental"));
+        Excel4(xlfUnregister, 0, 1, &xlRegID);
+
         Excel(xlfRegister, 0, 12, &xDll,
             // function code name
             TempStrNoSize("\x1C""ohRepositoryDeleteAllObjects"),
@@ -276,11 +381,17 @@ void unregisterGarbagecollection(const XLOPER &xDll) {
             TempStrNoSize("\x18""ohRepositoryDeleteObject"));
         Excel4(xlfUnregister, 0, 1, &xlRegID);
 
+        // Excel 2007 and later call the XLOPER12 entry point, which
+        // is not limited to the Excel 97 grid size.
         Excel(xlfRegister, 0, 12, &xDll,
             // function code name
-            TempStrNoSize("\x19""ohRepositoryListObjectIDs"),
+            XLCallVer() >= 0x0C00
+                ? TempStrNoSize("\x1B""ohRepositoryListObjectIDs12")
+                : TempStrNoSize("\x19""ohRepositoryListObjectIDs"),
             // parameter codes
-            TempStrNoSize("\x04""PCP#"),
+            XLCallVer() >= 0x0C00
+                ? TempStrNoSize("\x04""QCP" RPXL_READER_CODE)
+                : TempStrNoSize("\x04""PCP" RPXL_READER_CODE),
             // function display name
             TempStrNoSize("\x19""ohRepositoryListObjectIDs"),
             // comma-delimited list of parameter names
@@ -300,7 +411,9 @@ void unregisterGarbagecollection(const XLOPER &xDll) {
             TempStrNoSize("\x1D""dependency tracking trigger  "));
 
         Excel4(xlfRegisterId, &xlRegID, 2, &xDll,
-            TempStrNoSize("\x19""ohRepositoryListObjectIDs"));
+            XLCallVer() >= 0x0C00
+                ? TempStrNoSize("\x1B""ohRepositoryListObjectIDs12")
+                : TempStrNoSize("\x19""ohRepositoryListObjectIDs"));
         Excel4(xlfUnregister, 0, 1, &xlRegID);
 
         Excel(xlfRegister, 0, 11, &xDll,
@@ -382,6 +495,60 @@ void unregisterGarbagecollection(const XLOPER &xDll) {
             TempStrNoSize("\x17""ohRepositoryObjectCount"));
         Excel4(xlfUnregister, 0, 1, &xlRegID);
 
+        Excel(xlfRegister, 0, 12, &xDll,
+            // function code name
+            TempStrNoSize("\x1A""ohRepositoryReclaimObjects"),
+            // parameter codes
+            TempStrNoSize("\x04""NNP#"),
+            // function display name
+            TempStrNoSize("\x1A""ohRepositoryReclaimObjects"),
+            // comma-delimited list of parameter names
+            TempStrNoSize("\x12""MaxObjects,Trigger"),
+            // function type (0 = hidden, 1 = worksheet)
+            TempStrNoSize("\x01""0"),
+            // function category
+            TempStrNoSize("\x07""reposit"),
+            // shortcut text (command macros only)
+            TempStrNoSize("\x00"""),
+            // path to help file
+            TempStrNoSize("\x00"""),
+            // function description
+            TempStrNoSize("\x5A""destroy a bounded number of deleted objects, returns #/objects still awaiting destruction."),
+            // parameter descriptions
+            TempStrNoSize("\x3D""maximum number of objects to destroy, or zero to destroy all."),
+            TempStrNoSize("\x1D""dependency tracking trigger  "));
+
+        Excel4(xlfRegisterId, &xlRegID, 2, &xDll,
+            TempStrNoSize("\x1A""ohRepositoryReclaimObjects"));
+        Excel4(xlfUnregister, 0, 1, &xlRegID);
+
+        Excel(xlfRegister, 0, 12, &xDll,
+            // function code name
+            TempStrNoSize("\x22""ohRepositorySetDeferredDestruction"),
+            // parameter codes
+            TempStrNoSize("\x04""LPP#"),
+            // function display name
+            TempStrNoSize("\x22""ohRepositorySetDeferredDestruction"),
+            // comma-delimited list of parameter names
+            TempStrNoSize("\x10""Deferred,Trigger"),
+            // function type (0 = hidden, 1 = worksheet)
+            TempStrNoSize("\x01""0"),
+            // function category
+            TempStrNoSize("\x07""reposit"),
+            // shortcut text (command macros only)
+            TempStrNoSize("\x00"""),
+            // path to help file
+            TempStrNoSize("\x00"""),
+            // function description
+            TempStrNoSize("\x44""queue deleted objects for destruction by ohRepositoryReclaimObjects."),
+            // parameter descriptions
+            TempStrNoSize("\x58""true to queue deleted objects, false to destroy them immediately. Default value = false."),
+            TempStrNoSize("\x1D""dependency tracking trigger  "));
+
+        Excel4(xlfRegisterId, &xlRegID, 2, &xDll,
+            TempStrNoSize("\x22""ohRepositorySetDeferredDestruction"));
+        Excel4(xlfUnregister, 0, 1, &xlRegID);
+
 
 
 }
@@ -17,6 +17,7 @@
 */
 
 #include <xlsdk/xlsdkdefines.hpp>
+#include <rpxl/rpxldefines.hpp>
 
 // register functions in category Objects with Excel
 
@@ -114,11 +115,35 @@ void registerObjects(const XLOPER &xDll) {
             TempStrNoSize("\x0A""object ID."),
             TempStrNoSize("\x1D""dependency tracking trigger  "));
 
+        Excel(xlfRegister, 0, 13, &xDll,
+            // function code name
+            TempStrNoSize("\x14""ohObjectDependentIDs"),
+            // parameter codes
+            TempStrNoSize("\x05""PCPP" RPXL_READER_CODE),
+            // function display name
+            TempStrNoSize("\x14""ohObjectDependentIDs"),
+            // comma-delimited list of parameter names
+            TempStrNoSize("\x1B""ObjectID,Transitive,Trigger"),
+            // function type (0 = hidden, 1 = worksheet)
+            TempStrNoSize("\x01""1"),
+            // function category
+            TempStrNoSize("\x07""reposit"),
+            // shortcut text (command macros only)
+            TempStrNoSize("\x00"""),
+            // path to help file
+            TempStrNoSize("\x00"""),
+            // function description
+            TempStrNoSize("\x3D""list the IDs of the objects which depend on the given object."),
+            // parameter descriptions
+            TempStrNoSize("\x0A""object ID."),
+            TempStrNoSize("\x42""also list the dependents of the dependents. Default value = false."),
+            TempStrNoSize("\x1D""dependency tracking trigger  "));
+
         Excel(xlfRegister, 0, 12, &xDll,
             // function code name
             TempStrNoSize("\x0E""ohObjectExists"),
             // parameter codes
-            TempStrNoSize("\x04""PPP#"),
+            TempStrNoSize("\x04""PPP" RPXL_READER_CODE),
             // function display name
             TempStrNoSize("\x0E""ohObjectExists"),
             // comma-delimited list of parameter names
@@ -374,11 +399,39 @@ void unregisterObjects(const XLOPER &xDll) {
             TempStrNoSize("\x14""ohObjectCreationTime"));
         Excel4(xlfUnregister, 0, 1, &xlRegID);
 
+        Excel(xlfRegister, 0, 13, &xDll,
+            // function code name
+            TempStrNoSize("\x14""ohObjectDependentIDs"),
+            // parameter codes
+            TempStrNoSize("\x05""PCPP" RPXL_READER_CODE),
+            // function display name
+            TempStrNoSize("\x14""ohObjectDependentIDs"),
+            // comma-delimited list of parameter names
+            TempStrNoSize("\x1B""ObjectID,Transitive,Trigger"),
+            // function type (0 = hidden, 1 = worksheet)
+            TempStrNoSize("\x01""0"),
+            // function category
+            TempStrNoSize("\x07""reposit"),
+            // shortcut text (command macros only)
+            TempStrNoSize("\x00"""),
+            // path to help file
+            TempStrNoSize("\x00"""),
+            // function description
+            TempStrNoSize("\x3D""list the IDs of the objects which depend on the given object."),
+            // parameter descriptions
+            TempStrNoSize("\x0A""object ID."),
+            TempStrNoSize("\x42""also list the dependents of the dependents. Default value = false."),
+            TempStrNoSize("\x1D""dependency tracking trigger  "));
+
+        Excel4(xlfRegisterId, &xlRegID, 2, &xDll,
+            TempStrNoSize("\x14""ohObjectDependentIDs"));
+        Excel4(xlfUnregister, 0, 1, &xlRegID);
+
         Excel(xlfRegister, 0, 12, &xDll,
             // function code name
             TempStrNoSize("\x0E""ohObjectExists"),
             // parameter codes
-            TempStrNoSize("\x04""PPP#"),
+            TempStrNoSize("\x04""PPP" RPXL_READER_CODE),
             // function display name
             TempStrNoSize("\x0E""ohObjectExists"),
             // comma-delimited list of parameter names
@@ -0,0 +1,193 @@
+
+/*  
+ Copyright (C) 2004, 2005, 2006 Eric Ehlers
+ 
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include <xlsdk/xlsdkdefines.hpp>
+#include <rpxl/rpxldefines.hpp>
+
+// register functions in category Repository with Excel
+
+void registerRepository(const XLOPER &xDll) {
+
+        Excel(xlfRegister, 0, 11, &xDll,
+            // function code name
+            TempStrNoSize("\x1A""ohRepositoryListClassNames"),
+            // parameter codes
+            TempStrNoSize("\x03""PP" RPXL_READER_CODE),
+            // function display name
+            TempStrNoSize("\x1A""ohRepositoryListClassNames"),
+            // comma-delimited list of parameter names
+            TempStrNoSize("\x07""Trigger"),
+            // function type (0 = hidden, 1 = worksheet)
+            TempStrNoSize("\x01""1"),
+            // function category
+            TempStrNoSize("\x07""reposit"),
+            // shortcut text (command macros only)
+            TempStrNoSize("\x00"""),
+            // path to help file
+            TempStrNoSize("\x00"""),
+            // function description
+            TempStrNoSize("\x32""list the class names of the objects in repository."),
+            // parameter descriptions
+            TempStrNoSize("\x1D""dependency tracking trigger  "));
+
+        Excel(xlfRegister, 0, 13, &xDll,
+            // function code name
+            TempStrNoSize("\x20""ohRepositoryListObjectIDsByClass"),
+            // parameter codes
+            TempStrNoSize("\x05""PCCP" RPXL_READER_CODE),
+            // function display name
+            TempStrNoSize("\x20""ohRepositoryListObjectIDsByClass"),
+            // comma-delimited list of parameter names
+            TempStrNoSize("\x17""ClassName,Regex,Trigger"),
+            // function type (0 = hidden, 1 = worksheet)
+            TempStrNoSize("\x01""1"),
+            // function category
+            TempStrNoSize("\x07""reposit"),
+            // shortcut text (command macros only)
+            TempStrNoSize("\x00"""),
+            // path to help file
+            TempStrNoSize("\x00"""),
+            // function description
+            TempStrNoSize("\x3A""list the IDs of objects of the given class matching regex."),
+            // parameter descriptions
+            TempStrNoSize("\x27""class name of the objects to be listed."),
+            TempStrNoSize("\x3A""optional matching pattern in UNIX format (wildcard is .*)."),
+            TempStrNoSize("\x1D""dependency tracking trigger  "));
+
+        Excel(xlfRegister, 0, 12, &xDll,
+            // function code name
+            TempStrNoSize("\x1E""ohRepositoryObjectCountByClass"),
+            // parameter codes
+            TempStrNoSize("\x04""NCP" RPXL_READER_CODE),
+            // function display name
+            TempStrNoSize("\x1E""ohRepositoryObjectCountByClass"),
+            // comma-delimited list of parameter names
+            TempStrNoSize("\x11""ClassName,Trigger"),
+            // function type (0 = hidden, 1 = worksheet)
+            TempStrNoSize("\x01""1"),
+            // function category
+            TempStrNoSize("\x07""reposit"),
+            // shortcut text (command macros only)
+            TempStrNoSize("\x00"""),
+            // path to help file
+            TempStrNoSize("\x00"""),
+            // function description
+            TempStrNoSize("\x2B""#/objects of the given class in repository."),
+            // parameter descriptions
+            TempStrNoSize("\x28""class name of the objects to be counted."),
+            TempStrNoSize("\x1D""dependency tracking trigger  "));
+
+
+
+}
+
+// unregister functions in category Repository with Excel
+
+void unregisterRepository(const XLOPER &xDll) {
+
+    XLOPER xlRegID;
+
+    // Unregister each function.  Due to a bug in Excel's C API this is a
+    // two-step process.  Thanks to Laurent Longre for discovering the
+    // workaround implemented here.
+
+        Excel(xlfRegister, 0, 11, &xDll,
+            // function code name
+            TempStrNoSize("\x1A""ohRepositoryListClassNames"),
+            // parameter codes
+            TempStrNoSize("\x03""PP" RPXL_READER_CODE),
+            // function display name
+            TempStrNoSize("\x1A""ohRepositoryListClassNames"),
+            // comma-delimited list of parameter names
+            TempStrNoSize("\x07""Trigger"),
+            // function type (0 = hidden, 1 = worksheet)
+            TempStrNoSize("\x01""0"),
+            // function category
+            TempStrNoSize("\x07""reposit"),
+            // shortcut text (command macros only)
+            TempStrNoSize("\x00"""),
+            // path to help file
+            TempStrNoSize("\x00"""),
+            // function description
+            TempStrNoSize("\x32""list the class names of the objects in repository."),
+            // parameter descriptions
+            TempStrNoSize("\x1D""dependency tracking trigger  "));
+
+        Excel4(xlfRegisterId, &xlRegID, 2, &xDll,
+            TempStrNoSize("\x1A""ohRepositoryListClassNames"));
+        Excel4(xlfUnregister, 0, 1, &xlRegID);
+
+        Excel(xlfRegister, 0, 13, &xDll,
+            // function code name
+            TempStrNoSize("\x20""ohRepositoryListObjectIDsByClass"),
+            // parameter codes
+            TempStrNoSize("\x05""PCCP" RPXL_READER_CODE),
+            // function display name
+            TempStrNoSize("\x20""ohRepositoryListObjectIDsByClass"),
+            // comma-delimited list of parameter names
+            TempStrNoSize("\x17""ClassName,Regex,Trigger"),
+            // function type (0 = hidden, 1 = worksheet)
+            TempStrNoSize("\x01""0"),
+            // function category
+            TempStrNoSize("\x07""reposit"),
+            // shortcut text (command macros only)
+            TempStrNoSize("\x00"""),
+            // path to help file
+            TempStrNoSize("\x00"""),
+            // function description
+            TempStrNoSize("\x3A""list the IDs of objects of the given class matching regex."),
+            // parameter descriptions
+            TempStrNoSize("\x27""class name of the objects to be listed."),
+            TempStrNoSize("\x3A""optional matching pattern in UNIX format (wildcard is .*)."),
+            TempStrNoSize("\x1D""dependency tracking trigger  "));
+
+        Excel4(xlfRegisterId, &xlRegID, 2, &xDll,
+            TempStrNoSize("\x20""ohRepositoryListObjectIDsByClass"));
+        Excel4(xlfUnregister, 0, 1, &xlRegID);
+
+        Excel(xlfRegister, 0, 12, &xDll,
+            // function code name
+            TempStrNoSize("\x1E""ohRepositoryObjectCountByClass"),
+            // parameter codes
+            TempStrNoSize("\x04""NCP" RPXL_READER_CODE),
+            // function display name
+            TempStrNoSize("\x1E""ohRepositoryObjectCountByClass"),
+            // comma-delimited list of parameter names
+            TempStrNoSize("\x11""ClassName,Trigger"),
+            // function type (0 = hidden, 1 = worksheet)
+            TempStrNoSize("\x01""0"),
+            // function category
+            TempStrNoSize("\x07""reposit"),
+            // shortcut text (command macros only)
+            TempStrNoSize("\x00"""),
+            // path to help file
+            TempStrNoSize("\x00"""),
+            // function description
+            TempStrNoSize("\x2B""#/objects of the given class in repository."),
+            // parameter descriptions
+            TempStrNoSize("\x28""class name of the objects to be counted."),
+            TempStrNoSize("\x1D""dependency tracking trigger  "));
+
+        Excel4(xlfRegisterId, &xlRegID, 2, &xDll,
+            TempStrNoSize("\x1E""ohRepositoryObjectCountByClass"));
+        Excel4(xlfUnregister, 0, 1, &xlRegID);
+
+
+
+}
+
@@ -17,6 +17,7 @@
 */
 
 #include <xlsdk/xlsdkdefines.hpp>
+#include <rpxl/rpxldefines.hpp>
 
 // register functions in category Valueobjects with Excel
 
@@ -49,7 +50,7 @@ void registerValueobjects(const XLOPER &xDll) {
             // function code name
             TempStrNoSize("\x16""ohObjectPropertyValues"),
             // parameter codes
-            TempStrNoSize("\x05""PCPP#"),
+            TempStrNoSize("\x05""PCPP" RPXL_READER_CODE),
             // function display name
             TempStrNoSize("\x16""ohObjectPropertyValues"),
             // comma-delimited list of parameter names
@@ -114,7 +115,7 @@ void unregisterValueobjects(const XLOPER &xDll) {
             // function code name
             TempStrNoSize("\x16""ohObjectPropertyValues"),
             // parameter codes
-            TempStrNoSize("\x05""PCPP#"),
+            TempStrNoSize("\x05""PCPP" RPXL_READER_CODE),
             // function display name
             TempStrNoSize("\x16""ohObjectPropertyValues"),
             // comma-delimited list of parameter names
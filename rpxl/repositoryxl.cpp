@@ -27,6 +27,8 @@
 #include <rpxl/rangereference.hpp>
 #include <rpxl/convert_oper.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/next_prior.hpp>
+#include <boost/thread/mutex.hpp>
 /* Use BOOST_MSVC instead of _MSC_VER since some other vendors (Metrowerks,
 for example) also #define _MSC_VER
 */
@@ -35,9 +37,13 @@ for example) also #define _MSC_VER
 #  include <xlsdk/auto_link.hpp>
 #  undef BOOST_LIB_DIAGNOSTIC
 #endif
+#include <algorithm>
 #include <iomanip>
+#include <map>
+#include <set>
 #include <sstream>
 #include <string>
+#include <vector>
 
 using boost::shared_ptr;
 using std::string;
@@ -45,7 +51,7 @@ using std::endl;
 
 namespace reposit {
 
-    // Below are three structures which must be declared as static variables rather than
+    // Below are structures which must be declared as static variables rather than
     // class members because std::map cannot be exported across DLL boundaries.
 
     // The object map declared in the cpp file for the base Repository class.
@@ -55,10 +61,229 @@ namespace reposit {
     typedef std::map<string, shared_ptr<RangeReference> > ErrorMessageMap;
     ErrorMessageMap errorMessageMap_;
 
-    // Excel cell ranges in which objects have been constructed,
-    // keyed by a unique ID which is assigned to each range.
-    typedef std::map<string, shared_ptr<CallingRange> > RangeMap;
-    RangeMap callingRanges_;
+    // The identities of the calling ranges which have entries in errorMessageMap_,
+    // mapped to their keys in errorMessageMap_, allowing clearError() to dispense
+    // with xlfReftext.  Only ranges whose identity is known to FunctionCall are
+    // recorded here, a given cell always receives the same type of reference from
+    // xlfCaller.
+    typedef std::map<CallerId, string> ErrorCallerMap;
+    ErrorCallerMap errorCallers_;
+
+    // Error messages logged by read only functions, keyed by the identity of the
+    // calling range.  A function called thread safe may not call xlfReftext, so
+    // these are moved to errorMessageMap_ by the next call to retrieveError().
+    typedef std::map<CallerId, string> PendingErrorMap;
+    PendingErrorMap pendingErrors_;
+
+    // Read only functions may run concurrently, holding shared access to the
+    // Repository, and on completion each updates the error messages of its
+    // calling range.  This mutex serializes those updates.  Other accesses to
+    // the error messages are made under exclusive access and need not lock it.
+    boost::mutex errorMutex_;
+
+    // A spatial index of the ranges in errorMessageMap_, used by retrieveError()
+    // to find the range containing a given selection.  The ranges are grouped
+    // by book and sheet, then by their first column, then by their first row.
+    // The calling ranges of distinct formulas do not overlap, so the ranges
+    // which start in a given column are disjoint, and the only one of them
+    // which can contain the top left cell of the selection is the last to
+    // start at or above it.  Only the columns no further than the width of
+    // the widest range to the left of the selection are searched, so a
+    // lookup costs one logarithmic search per column.  The widths are held
+    // in a multiset so that the bound shrinks as errors are cleared.
+    namespace {
+
+        struct SheetErrors {
+            typedef std::multimap<int, shared_ptr<RangeReference> > RowMap;
+            typedef std::map<int, RowMap> ColumnMap;
+            ColumnMap columns;
+            std::multiset<int> widths;
+        };
+        typedef std::map<std::pair<string, string>, SheetErrors> ErrorIndex;
+        ErrorIndex errorIndex_;
+
+        int width(const RangeReference &rangeReference) {
+            return rangeReference.colEnd() - rangeReference.colStart() + 1;
+        }
+
+        void indexError(const shared_ptr<RangeReference> &rangeReference) {
+            SheetErrors &sheetErrors = errorIndex_[
+                std::make_pair(rangeReference->bookName(), rangeReference->sheetName())];
+            sheetErrors.columns[rangeReference->colStart()].insert(
+                std::make_pair(rangeReference->rowStart(), rangeReference));
+            sheetErrors.widths.insert(width(*rangeReference));
+        }
+
+        void unindexError(const shared_ptr<RangeReference> &rangeReference) {
+            ErrorIndex::iterator s = errorIndex_.find(
+                std::make_pair(rangeReference->bookName(), rangeReference->sheetName()));
+            if (s == errorIndex_.end())
+                return;
+            SheetErrors &sheetErrors = s->second;
+            SheetErrors::ColumnMap::iterator c =
+                sheetErrors.columns.find(rangeReference->colStart());
+            if (c == sheetErrors.columns.end())
+                return;
+            std::pair<SheetErrors::RowMap::iterator, SheetErrors::RowMap::iterator> r =
+                c->second.equal_range(rangeReference->rowStart());
+            for (SheetErrors::RowMap::iterator i = r.first; i != r.second; ++i) {
+                if (i->second == rangeReference) {
+                    c->second.erase(i);
+                    sheetErrors.widths.erase(sheetErrors.widths.find(width(*rangeReference)));
+                    break;
+                }
+            }
+            if (c->second.empty())
+                sheetErrors.columns.erase(c);
+            if (sheetErrors.columns.empty())
+                errorIndex_.erase(s);
+        }
+
+        shared_ptr<RangeReference> findError(const RangeReference &selection) {
+            ErrorIndex::const_iterator s = errorIndex_.find(
+                std::make_pair(selection.bookName(), selection.sheetName()));
+            if (s == errorIndex_.end())
+                return shared_ptr<RangeReference>();
+            const SheetErrors &sheetErrors = s->second;
+
+            SheetErrors::ColumnMap::const_iterator c = sheetErrors.columns.lower_bound(
+                selection.colStart() - *sheetErrors.widths.rbegin() + 1);
+            SheetErrors::ColumnMap::const_iterator end =
+                sheetErrors.columns.upper_bound(selection.colStart());
+            for (; c != end; ++c) {
+                SheetErrors::RowMap::const_iterator i =
+                    c->second.upper_bound(selection.rowStart());
+                if (i == c->second.begin())
+                    continue;
+                // Ranges logged by an earlier formula may share the top left
+                // cell of the current one.
+                int rowStart = (--i)->first;
+                for (;; --i) {
+                    if (i->second->contains(selection))
+                        return i->second;
+                    if (i == c->second.begin() || boost::prior(i)->first != rowStart)
+                        break;
+                }
+            }
+            return shared_ptr<RangeReference>();
+        }
+
+        // Associate the given message with the range having the given reference
+        // text, and return the key of the range in errorMessageMap_.
+        string recordError(const string &refStr, const string &cellMessage) {
+            string refStrUpper = boost::algorithm::to_upper_copy(refStr);
+            ErrorMessageMap::const_iterator i = errorMessageMap_.find(refStrUpper);
+            if (i == errorMessageMap_.end()) {
+                shared_ptr<RangeReference> rangeReference(new RangeReference(refStrUpper));
+                rangeReference->setErrorMessage(cellMessage);
+                errorMessageMap_[refStrUpper] = rangeReference;
+                indexError(rangeReference);
+            } else {
+                i->second->setErrorMessage(cellMessage);
+            }
+            return refStrUpper;
+        }
+
+        void eraseError(const string &refStrUpper) {
+            ErrorMessageMap::iterator i = errorMessageMap_.find(refStrUpper);
+            if (i != errorMessageMap_.end()) {
+                unindexError(i->second);
+                errorMessageMap_.erase(i);
+            }
+        }
+
+        // Move the errors of read only functions to errorMessageMap_, now that
+        // the text of the reference of each calling range can be retrieved.
+        void resolvePendingErrors() {
+            boost::mutex::scoped_lock lock(errorMutex_);
+            while (!pendingErrors_.empty()) {
+                PendingErrorMap::iterator i = pendingErrors_.begin();
+                CallerId callerId = i->first;
+                string cellMessage = i->second;
+                pendingErrors_.erase(i);
+
+                XLMREF xMref;
+                xMref.count = 1;
+                xMref.reftbl[0] = callerId.ref;
+                XLOPER xRef;
+                xRef.xltype = xltypeRef;
+                xRef.val.mref.idSheet = callerId.idSheet;
+                xRef.val.mref.lpmref = &xMref;
+                // The error of a range on a sheet which has since been
+                // deleted has no reference text, and is dropped.
+                try {
+                    Xloper xRefText;
+                    Excel(xlfReftext, &xRefText, 1, &xRef);
+                    string refStr = ConvertOper(xRefText());
+                    errorCallers_[callerId] = recordError(refStr, cellMessage);
+                } catch(...) {}
+            }
+        }
+
+    }
+
+    // Excel cell ranges in which objects have been constructed, indexed by
+    // the number encoded in the unique key which is assigned to each range,
+    // see CallingRange::parseKey().  Keys are reused, so the vector remains
+    // dense.  Empty slots hold null pointers.
+    typedef std::vector<shared_ptr<CallingRange> > RangeVector;
+    RangeVector callingRanges_;
+
+    // The calling range shared by all objects constructed from VBA.
+    shared_ptr<CallingRange> vbaRange_;
+
+    // The index of the calling range at which collectGarbageIncremental()
+    // resumes.  Zero at the start of a pass.
+    std::size_t garbageCursor_ = 0;
+
+    // The number of calling ranges in callingRanges_, and the number of those
+    // below garbageCursor_, so that collectGarbageIncremental() can count the
+    // ranges remaining in the pass without visiting them.
+    std::size_t rangeCount_ = 0;
+    std::size_t rangesChecked_ = 0;
+
+    namespace {
+
+        void addCallingRange(const shared_ptr<CallingRange> &callingRange) {
+            std::size_t index = callingRange->keyIndex();
+            if (index >= callingRanges_.size())
+                callingRanges_.resize(index + 1);
+            if (!callingRanges_[index]) {
+                ++rangeCount_;
+                if (index < garbageCursor_)
+                    ++rangesChecked_;
+            }
+            callingRanges_[index] = callingRange;
+        }
+
+        void removeCallingRange(std::size_t index) {
+            callingRanges_[index].reset();
+            --rangeCount_;
+            if (index < garbageCursor_)
+                --rangesChecked_;
+        }
+
+        // Delete the objects orphaned in the given calling range, if the range
+        // is no longer valid.  Return true if the calling range may be deleted.
+        bool collectCallingRange(const shared_ptr<CallingRange> &callingRange, bool deletePermanent) {
+            if (callingRange->valid())
+                return false;
+            callingRange->clearResidentObjects(deletePermanent);
+            return callingRange->empty();
+        }
+
+        // Orders the positions of a batch passed to storeObjects() by the IDs
+        // at those positions, in ObjectMap order.
+        struct IDIndexLess {
+            IDIndexLess(const std::vector<string> &objectIDs) : objectIDs_(objectIDs) {}
+            bool operator()(std::size_t lhs, std::size_t rhs) const {
+                return less_(objectIDs_[lhs], objectIDs_[rhs]);
+            }
+            const std::vector<string> &objectIDs_;
+            my_iless less_;
+        };
+
+    }
 
     RepositoryXL &RepositoryXL::instance() {
         if (instance_) {
@@ -69,9 +294,17 @@ namespace reposit {
     }
 
     void RepositoryXL::clear() {
-        objectMap_.clear();
+        deleteAllObjects(true);
         errorMessageMap_.clear();
+        errorCallers_.clear();
+        pendingErrors_.clear();
+        errorIndex_.clear();
         callingRanges_.clear();
+        vbaRange_.reset();
+        garbageCursor_ = 0;
+        rangeCount_ = 0;
+        rangesChecked_ = 0;
+        CallingRange::flushNames();
     }
 
     string RepositoryXL::storeObject(
@@ -85,13 +318,100 @@ namespace reposit {
             if (objectIDRaw.empty() && valueObject)
                 valueObject->setProperty("OBJECTID", objectID);
 
+            shared_ptr<ObjectWrapperXL> objectWrapperXL =
+                insertObject(objectID, object, callingRange, overwrite);
+            registerObserver(objectWrapperXL);
+            return objectWrapperXL->idFull();
+    }
+
+    std::vector<string> RepositoryXL::storeObjects(
+        const std::vector<StoreItem> &items,
+        bool overwrite) {
+
+            shared_ptr<CallingRange> callingRange = getCallingRange();
+
+            std::vector<string> objectIDs;
+            objectIDs.reserve(items.size());
+            for (std::vector<StoreItem>::const_iterator i = items.begin(); i != items.end(); ++i)
+                objectIDs.push_back(callingRange->initializeID(i->objectID));
+
+            // Sort the positions of the batch into ObjectMap order, as in the
+            // base class.  The sort is stable so that where an ID occurs more
+            // than once, the last occurrence wins.  stored[i] is the position of
+            // the item which is stored for the ID at position i.
+            std::vector<std::size_t> sorted(items.size());
+            for (std::size_t i = 0; i < sorted.size(); ++i)
+                sorted[i] = i;
+            IDIndexLess less(objectIDs);
+            std::stable_sort(sorted.begin(), sorted.end(), less);
+
+            std::vector<std::size_t> stored(items.size());
+            for (std::size_t i = 0; i < sorted.size(); ) {
+                std::size_t j = i + 1;
+                while (j < sorted.size() && !less(sorted[i], sorted[j]))
+                    ++j;
+                RP_REQUIRE(j == i + 1 || overwrite, "Cannot store object with ID '" <<
+                           objectIDs[sorted[i]] << "' because that ID occurs more than once in the list");
+                for (; i < j; ++i)
+                    stored[sorted[i]] = sorted[j - 1];
+            }
+
+            // Validate the whole batch before storing anything.
+            if (!overwrite) {
+                for (std::vector<string>::const_iterator i = objectIDs.begin(); i != objectIDs.end(); ++i) {
+                    ObjectMap::const_iterator result = objectMap_.find(*i);
+                    if (result != objectMap_.end()) {
+                        shared_ptr<ObjectWrapperXL> objectWrapperXL =
+                            boost::static_pointer_cast<ObjectWrapperXL>(result->second);
+                        RP_REQUIRE(objectWrapperXL->callerKey() == callingRange->key(),
+                            "Cannot create object with ID '" << *i <<
+                            "' in cell " << callingRange->addressString() <<
+                            " because an object with that ID already resides in cell " <<
+                            objectWrapperXL->callerAddress());
+                    }
+                }
+            }
+
+            std::set<string, my_iless> batchIDs(objectIDs.begin(), objectIDs.end());
+            for (std::vector<StoreItem>::size_type i = 0; i < items.size(); ++i) {
+                if (stored[i] == i)
+                    requirePrecedents(objectIDs[i], items[i].object, batchIDs);
+            }
+
+            std::vector<shared_ptr<ObjectWrapperXL> > wrappers(items.size());
+            for (std::vector<StoreItem>::size_type i = 0; i < items.size(); ++i) {
+                if (stored[i] != i)
+                    continue;
+                if (items[i].objectID.empty() && items[i].valueObject)
+                    items[i].valueObject->setProperty("OBJECTID", objectIDs[i]);
+                wrappers[i] = insertObject(objectIDs[i], items[i].object, callingRange, overwrite);
+            }
+
+            for (std::vector<shared_ptr<ObjectWrapperXL> >::const_iterator i = wrappers.begin();
+                i != wrappers.end(); ++i) {
+                if (*i)
+                    registerObserver(*i);
+            }
+
+            std::vector<string> ret;
+            ret.reserve(items.size());
+            for (std::vector<StoreItem>::size_type i = 0; i < items.size(); ++i)
+                ret.push_back(wrappers[stored[i]]->idFull());
+            return ret;
+    }
+
+    shared_ptr<ObjectWrapperXL> RepositoryXL::insertObject(
+        const string &objectID,
+        const shared_ptr<Object> &object,
+        const shared_ptr<CallingRange> &callingRange,
+        bool overwrite) {
+
             shared_ptr<ObjectWrapperXL> objectWrapperXL;
-            ObjectMap::const_iterator result = objectMap_.find(objectID);
-            if (result == objectMap_.end()) {
-                objectWrapperXL = shared_ptr<ObjectWrapperXL> (
-                    new ObjectWrapperXL(objectID, object, callingRange));
-                objectMap_[objectID] = objectWrapperXL;
-                callingRange->registerObject(objectID, objectWrapperXL);
+            ObjectMap::iterator result;
+            if (!lookupObject(objectID, result)) {
+                objectWrapperXL = boost::allocate_shared<ObjectWrapperXL>(
+                    Allocator<ObjectWrapperXL>::type(), objectID, object, callingRange);
+                result = objectMap_.insert(result, std::make_pair(objectID, objectWrapperXL));
             } else {
                 objectWrapperXL = boost::static_pointer_cast<ObjectWrapperXL>(result->second);
                 if (objectWrapperXL->callerKey() != callingRange->key()) {
@@ -100,32 +420,60 @@ namespace reposit {
                         " because an object with that ID already resides in cell " <<
                         objectWrapperXL->callerAddress());
                     objectWrapperXL->resetCaller(callingRange);
-                    callingRange->registerObject(objectID, objectWrapperXL);
                 }
+                unindexObject(result);
                 objectWrapperXL->reset(object);
             }
+            indexObject(result);
+            // Register the object with its calling range even if it was already
+            // resident there, because the new Object may differ in permanence.
+            callingRange->registerObject(objectID, objectWrapperXL);
+            return objectWrapperXL;
+    }
 
-            registerObserver(objectWrapperXL);
-            return objectWrapperXL->idFull();
+    bool RepositoryXL::objectUnchanged(
+        const string &objectID,
+        const boost::shared_ptr<ValueObject> &valueObject) {
+
+            ObjectMap::const_iterator result = objectMap_.find(objectID);
+            if (result == objectMap_.end())
+                return false;
+            shared_ptr<ObjectWrapperXL> objectWrapperXL =
+                boost::static_pointer_cast<ObjectWrapperXL>(result->second);
+            shared_ptr<CallingRange> callingRange = getCallingRange(false);
+            return callingRange
+                && objectWrapperXL->callerKey() == callingRange->key()
+                && objectWrapperXL->identical(valueObject);
+    }
+
+    void RepositoryXL::deleteResidentObject(
+        const string &objectID,
+        const ObjectWrapperXL *objectWrapperXL) {
+
+            ObjectMap::iterator result;
+            if (lookupObject(objectID, result) && result->second.get() == objectWrapperXL)
+                eraseObject(result);
     }
 
     void RepositoryXL::setError(
         const string &message,
         const shared_ptr<FunctionCall> &functionCall) {
 
-            std::ostringstream logMessage, cellMessage;
+            std::ostringstream cellMessage;
             cellMessage << functionCall->functionName() << " - " << message;
 
-            string refStr = functionCall->refStr();
-            string refStrUpper = boost::algorithm::to_upper_copy(refStr);
-            ErrorMessageMap::const_iterator i = errorMessageMap_.find(refStrUpper);
-            if (i == errorMessageMap_.end()) {
-                shared_ptr<RangeReference> rangeReference(new RangeReference(refStrUpper));
-                rangeReference->setErrorMessage(cellMessage.str());
-                errorMessageMap_[refStrUpper] = rangeReference;
-            } else {
-                i->second->setErrorMessage(cellMessage.str());
+            CallerId callerId;
+            bool hasCallerId = functionCall->callerId(callerId);
+            if (hasCallerId && functionCall->readOnly()) {
+                // The function may have been called thread safe, so the text of
+                // the reference is left to resolvePendingErrors().
+                pendingErrors_[callerId] = cellMessage.str();
+                return;
             }
+
+            string refStrUpper = recordError(functionCall->refStr(), cellMessage.str());
+            if (hasCallerId)
+                errorCallers_[callerId] = refStrUpper;
     }
 
     void RepositoryXL::logError(
@@ -136,13 +484,17 @@ namespace reposit {
 
             try {
 
+                boost::mutex::scoped_lock lock(errorMutex_);
                 if (functionCall) {
 
                     functionCall->setError();
                     std::ostringstream fullMessage;
                     if (functionCall->callerType() == CallerType::Cell) {
                         setError(message, functionCall);
-                        fullMessage << functionCall->addressString() << " - ";
+                        // The address is retrieved with xlfGetCell, which a
+                        // function called thread safe may not call.
+                        if (!functionCall->readOnly())
+                            fullMessage << functionCall->addressString() << " - ";
                     } else if (functionCall->callerType() == CallerType::VBA || functionCall->callerType() == CallerType::Menu) {
                         vbaError_ = message;
                         fullMessage << "VBA - ";
@@ -162,6 +514,8 @@ namespace reposit {
 
         RP_REQUIRE(xRangeRef->xltype == xltypeRef || xRangeRef->xltype == xltypeSRef,
             "Input parameter is not a range reference.");
+        resolvePendingErrors();
+
         Xloper xRangeText;
         Excel(xlfReftext, &xRangeText, 1, xRangeRef);
         string refStr = ConvertOper(xRangeText());
@@ -172,60 +526,124 @@ namespace reposit {
             return i->second->errorMessage();
 
         RangeReference selectionReference(refStrUpper);
-        for (i = errorMessageMap_.begin(); i != errorMessageMap_.end(); ++i) {
-            if (i->second->contains(selectionReference))
-                return i->second->errorMessage();
-        }
+        shared_ptr<RangeReference> rangeReference = findError(selectionReference);
+        if (rangeReference)
+            return rangeReference->errorMessage();
 
         return "";
     }
 
     void RepositoryXL::clearError() {
-        string refStr = FunctionCall::instance().refStr();
-        errorMessageMap_.erase(boost::algorithm::to_upper_copy(refStr));
+
+        // This function is called by the destructor of FunctionCall and must not throw.
+
+        try {
+
+            boost::mutex::scoped_lock lock(errorMutex_);
+            if (errorMessageMap_.empty() && pendingErrors_.empty())
+                return;
+            FunctionCall &functionCall = FunctionCall::instance();
+            CallerId callerId;
+            if (functionCall.callerId(callerId)) {
+                // The error of a range with a known identity is found without
+                // callbacks, so that thread safe functions may clear it too.
+                pendingErrors_.erase(callerId);
+                ErrorCallerMap::iterator i = errorCallers_.find(callerId);
+                if (i != errorCallers_.end()) {
+                    eraseError(i->second);
+                    errorCallers_.erase(i);
+                }
+                return;
+            }
+#if defined(RPXL_ENABLE_THREAD_SAFE)
+            // A thread safe function may not call xlfReftext, and cannot have
+            // logged an error without the identity of its caller.
+            if (functionCall.readOnly())
+                return;
+#endif
+            if (errorMessageMap_.empty())
+                return;
+            // If this throws then the error remains, to be cleared by a later
+            // call which is not thread safe.
+            eraseError(boost::algorithm::to_upper_copy(functionCall.refStr()));
+
+        } catch(...) {}
     }
 
     void RepositoryXL::collectGarbage(const bool &deletePermanent) {
 
-        RangeMap::iterator i = callingRanges_.begin();
-        while (i != callingRanges_.end()) {
-            shared_ptr<CallingRange> callingRange = i->second;
-            if (callingRange->valid()) {
-                ++i;
-            } else {
-                callingRange->clearResidentObjects(deletePermanent);
-                if (callingRange->empty())
-                    callingRanges_.erase(i++);
-                else
-                    ++i;
-            }
+        for (std::size_t i = 0; i < callingRanges_.size(); ++i) {
+            if (callingRanges_[i] && collectCallingRange(callingRanges_[i], deletePermanent))
+                removeCallingRange(i);
+        }
+    }
+
+    int RepositoryXL::collectGarbageIncremental(int maxRanges, const bool &deletePermanent) {
+
+        RP_REQUIRE(maxRanges > 0, "Invalid value for maximum number of calling ranges: " << maxRanges);
+
+        // Resume from the index rather than from an iterator, so that calling
+        // ranges may be created or deleted between calls.
+        std::size_t i = garbageCursor_;
+        for (int checked = 0; checked < maxRanges && i < callingRanges_.size(); ++i) {
+            if (!callingRanges_[i])
+                continue;
+            if (collectCallingRange(callingRanges_[i], deletePermanent))
+                removeCallingRange(i);
+            else
+                ++rangesChecked_;
+            ++checked;
         }
+
+        garbageCursor_ = i;
+        int remaining = static_cast<int>(rangeCount_ - rangesChecked_);
+        if (!remaining) {
+            garbageCursor_ = 0;
+            rangesChecked_ = 0;
+        }
+        return remaining;
     }
 
-    shared_ptr<CallingRange> RepositoryXL::getCallingRange() {
-        string callerName = FunctionCall::instance().callerName();
+    shared_ptr<CallingRange> RepositoryXL::getCallingRange(bool create) {
+        // Find the calling range by the identity of the caller, which avoids
+        // converting the caller's reference to text, and which works for a
+        // range created earlier in this calculation cycle whose name may not
+        // yet have been assigned.  Otherwise look up the name of the caller.
+        string callerName;
+        CallerId callerId;
+        bool identified = FunctionCall::instance().callerId(callerId);
+        if (identified && CallingRange::callerKey(callerId, callerName)) {
+            std::size_t index;
+            if (CallingRange::parseKey(callerName, index)
+                && index < callingRanges_.size() && callingRanges_[index])
+                return callingRanges_[index];
+        }
+        callerName = FunctionCall::instance().callerName();
         if (callerName == "VBA") {
             // Called from VBA - check whether the corresponding calling range
             // object exists and create it if not.
-            RangeMap::const_iterator i = callingRanges_.find(callerName);
-            if (i == callingRanges_.end()) {
-                shared_ptr<CallingRange> callingRange(new CallingRange);
-                callingRanges_[callingRange->key()] = callingRange;
-                return callingRange;
-            } else {
-                return i->second;
-            }
+            if (!vbaRange_ && create)
+                vbaRange_.reset(new CallingRange);
+            return vbaRange_;
             // Called from a worksheet formula
         } else if (callerName.empty()) {
             // Calling range not yet named - create a new CallingRange object
+            if (!create)
+                return shared_ptr<CallingRange>();
             shared_ptr<CallingRange> callingRange(new CallingRange);
-            callingRanges_[callingRange->key()] = callingRange;
+            addCallingRange(callingRange);
             return callingRange;
         } else {
             // Calling range already named - return associated CallingRange object
-            RangeMap::const_iterator i = callingRanges_.find(callerName);
-            RP_REQUIRE(i != callingRanges_.end(), "No calling range named " << callerName);
-            return i->second;
+            std::size_t index;
+            bool found = CallingRange::parseKey(callerName, index)
+                && index < callingRanges_.size() && callingRanges_[index];
+            if (!found && !create)
+                return shared_ptr<CallingRange>();
+            RP_REQUIRE(found, "No calling range named " << callerName);
+            if (identified)
+                callingRanges_[index]->identifyCaller(callerId);
+            return callingRanges_[index];
         }
     }
 
@@ -233,13 +651,21 @@ namespace reposit {
         Repository::dump(out);
 
         out << endl << "calling ranges:";
-        if (callingRanges_.empty()) {
+        bool empty = !vbaRange_;
+        for (RangeVector::const_iterator i = callingRanges_.begin();
+            empty && i != callingRanges_.end(); ++i) {
+                empty = !*i;
+        }
+        if (empty) {
             out << " none." << endl;
         } else {
             out << endl << endl;
-            for (RangeMap::const_iterator i = callingRanges_.begin();
+            if (vbaRange_)
+                out << vbaRange_;
+            for (RangeVector::const_iterator i = callingRanges_.begin();
                 i != callingRanges_.end(); ++i) {
-                    out << i->second;
+                    if (*i)
+                        out << *i;
             }
         }
 
@@ -260,12 +686,12 @@ namespace reposit {
     std::vector<string> RepositoryXL::callerAddress(const std::vector<string> &objectList) {
 
         std::vector<string> ret;
+        string buffer;
 
         for (std::vector<string>::const_iterator i = objectList.begin();
             i != objectList.end(); ++i) {
-                string idStrip = CallingRange::getStub(*i);
                 const shared_ptr<ObjectWrapperXL>& objectWrapperXL = boost::static_pointer_cast<ObjectWrapperXL>(
-                    getObjectWrapper(idStrip));
+                    getObjectWrapper(formatID(*i, buffer)));
                 ret.push_back(objectWrapperXL->callerAddress());
         }
 
@@ -275,12 +701,12 @@ namespace reposit {
     std::vector<string> RepositoryXL::callerKey(const std::vector<string> &objectList) {
 
         std::vector<string> ret;
+        string buffer;
 
         for (std::vector<string>::const_iterator i = objectList.begin();
             i != objectList.end(); ++i) {
-                string idStrip = CallingRange::getStub(*i);
                 const shared_ptr<ObjectWrapperXL>& objectWrapperXL = boost::static_pointer_cast<ObjectWrapperXL>(
-                    getObjectWrapper(idStrip));
+                    getObjectWrapper(formatID(*i, buffer)));
                 ret.push_back(objectWrapperXL->callerKey());
         }
 
@@ -289,11 +715,12 @@ namespace reposit {
 
     std::vector<bool> RepositoryXL::isOrphan(const std::vector<string> &objectList){
         std::vector<bool> ret;
+        string buffer;
 
         for (std::vector<string>::const_iterator i = objectList.begin();
             i != objectList.end(); ++i) {
                 shared_ptr<ObjectWrapperXL> objectWrapperXL;
-                ObjectMap::const_iterator result = objectMap_.find(CallingRange::getStub(*i));
+                ObjectMap::const_iterator result = objectMap_.find(formatID(*i, buffer));
                 if (result != objectMap_.end()) {
 
                     objectWrapperXL = boost::static_pointer_cast<ObjectWrapperXL>(result->second);
@@ -311,12 +738,13 @@ namespace reposit {
     std::vector<string>
     RepositoryXL::updateCounter(const std::vector<string> &objectList) {
         std::vector<string> ret;
+        string buffer;
 
         for (std::vector<string>::const_iterator i = objectList.begin();
             i != objectList.end(); ++i) {
 
                 shared_ptr<ObjectWrapperXL> objectWrapperXL;
-                ObjectMap::const_iterator result = objectMap_.find(CallingRange::getStub(*i));
+                ObjectMap::const_iterator result = objectMap_.find(formatID(*i, buffer));
                 if (result != objectMap_.end()) {
 
                     objectWrapperXL = boost::static_pointer_cast<ObjectWrapperXL>(result->second);
@@ -332,9 +760,13 @@ namespace reposit {
 
     }
 
-    string RepositoryXL::formatID(const string &objectID){
+    const string &RepositoryXL::formatID(const string &objectID, string &buffer){
 
-        return CallingRange::getStub(objectID);
+        string::size_type length = CallingRange::stubLength(objectID);
+        if (length == objectID.length())
+            return objectID;
+        buffer.assign(objectID, 0, length);
+        return buffer;
     }
 
 }
@@ -63,6 +63,33 @@ namespace reposit {
                                         const boost::shared_ptr<Object> &obj,
                                         bool overwrite = false,
                                         boost::shared_ptr<ValueObject> valueObject = boost::shared_ptr<ValueObject>());
+        //! Wrapper for the storeObjects function in the base class.
+        /*! Each Object is associated with the calling range as for storeObject().
+            The check that no object in another cell is overwritten is performed
+            for the whole batch before any Object is stored.  As in the base
+            class, if an ID occurs more than once in the batch then an exception
+            is thrown, unless overwrite is true in which case only the last
+            Object with that ID is stored.  Likewise each precedent must be
+            either in the batch or already in the Repository.
+            Returns the full IDs of the stored Objects, in the same order as the batch.
+        */
+        virtual std::vector<std::string> storeObjects(const std::vector<StoreItem> &items,
+                                                      bool overwrite = false);
+        //! Wrapper for the objectUnchanged function in the base class.
+        /*! An Object which resides in a cell other than the calling cell is never
+            considered unchanged, so that storeObject() may transfer it to the
+            calling cell.  This function has no side effects in Excel, if the
+            calling cell has no CallingRange yet then it returns false without
+            creating one.
+        */
+        virtual bool objectUnchanged(const std::string &objectID,
+                                     const boost::shared_ptr<ValueObject> &valueObject);
+        //! Delete the Object with the given ID if it is held by the given ObjectWrapperXL.
+        /*! Called by CallingRange when deleting the objects resident in a range.
+            Take no action if the ID is not present, or if it has been reused
+            by another object since the given object was deleted.
+        */
+        void deleteResidentObject(const std::string &objectID, const ObjectWrapperXL *objectWrapperXL);
         //@}
 
         //! \name Error Messages
@@ -79,12 +106,19 @@ namespace reposit {
         void logError(const std::string &message,
                       const boost::shared_ptr<FunctionCall> &functionCall);
         //! Retrieve the error associated with the given range.
+        /*! Errors logged by thread safe functions are first indexed by the
+            address of their calling range.
+        */
         std::string retrieveError(const XLOPER *range);
         //! Retrieve the error associated with VBA.
         std::string vbaError() { return vbaError_; }
         //! Clear any error associated with VBA.
         void clearVbaError() { vbaError_ = ""; }
         //! Clear any error associated with the current range.
+        /*! Does not throw.  An error logged with the identity of its calling
+            range is cleared by that identity, without any callback into Excel,
+            so that a function called thread safe can also clear it.
+        */
         void clearError();
         //@}
 
@@ -105,6 +139,18 @@ namespace reposit {
             collected as well.
         */
         void collectGarbage(const bool &deletePermanent = false);
+        //! Check a bounded number of calling ranges and delete the objects orphaned there.
+        /*! Each calling range is validated by callbacks to Excel, so that
+            collectGarbage() can be slow on workbooks with many object cells.
+            This function checks at most maxRanges calling ranges, resuming
+            where the previous call left off, so that a full pass may be spread
+            over several calls e.g. from a VBA Application.OnTime handler.
+
+            Returns the number of calling ranges remaining to be checked in the
+            current pass, or zero if the pass is complete, in which case the
+            next call starts a new pass.
+        */
+        int collectGarbageIncremental(int maxRanges, const bool &deletePermanent = false);
         //@}
 
         //! \name Calling Ranges
@@ -125,15 +171,24 @@ namespace reposit {
 
     protected:
          // Convert Excel-format Object IDs into the format recognized by the base Repository class
-        virtual std::string formatID(const std::string &objectID);
+        virtual const std::string &formatID(const std::string &objectID, std::string &buffer);
 
     private:
+        // Store the Object and associate it with the calling range, without
+        // registering it as an Observer of its precedents.
+        boost::shared_ptr<ObjectWrapperXL> insertObject(
+            const std::string &objectID,
+            const boost::shared_ptr<Object> &object,
+            const boost::shared_ptr<CallingRange> &callingRange,
+            bool overwrite);
         // Associate the given error message to the active cell.
         void setError(
             const std::string &message,
             const boost::shared_ptr<FunctionCall> &functionCall);
         // Retrieve a reference to the CallingRange object associated to the active cell.
-        boost::shared_ptr<CallingRange> getCallingRange();
+        // If there is none then create it, or if create is false return a null pointer
+        // without naming the cell.
+        boost::shared_ptr<CallingRange> getCallingRange(bool create = true);
         // Error associated with VBA
         std::string vbaError_;
     };
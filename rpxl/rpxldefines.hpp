@@ -20,5 +20,32 @@
 #ifndef rpxl_defines_hpp
 #define rpxl_defines_hpp
 
+//! Storage class for variables of which each thread holds its own copy.
+/*! Only POD types may be declared thread local.  Under MSVC, thread local
+    variables in a DLL loaded by LoadLibrary, as an XLL is, require Windows
+    Vista or later.
+*/
+#if defined(_MSC_VER)
+#define RPXL_THREAD_LOCAL __declspec(thread)
+#else
+#define RPXL_THREAD_LOCAL __thread
+#endif
+
+//! Trailing parameter code of functions which only query the Repository.
+/*! By default these functions are registered with Excel as macro sheet
+    equivalents (#), like all other functions.  Define RPXL_ENABLE_THREAD_SAFE
+    to register them instead as thread safe ($), so that Excel may call them
+    concurrently during multithreaded recalculation.  The two codes are
+    mutually exclusive, so that a thread safe function which fails cannot
+    retrieve the address of its calling cell.  Its error is recorded against
+    the identity of the calling range and indexed by the next call to
+    RepositoryXL::retrieveError(), and the error log omits the address.
+*/
+#if defined(RPXL_ENABLE_THREAD_SAFE)
+#define RPXL_READER_CODE "$"
+#else
+#define RPXL_READER_CODE "#"
+#endif
+
 #endif
 
@@ -22,20 +22,63 @@
 #include <rpxl/conversions/vectortooper.hpp>
 #include <rpxl/convert_oper.hpp>
 
+namespace {
+
+    // The number of additional elements with which to extend an array of T
+    // so that it has room for the given number of bytes.
+    template <class T>
+    std::size_t extraElements(std::size_t bytes) {
+        return (bytes + sizeof(T) - 1) / sizeof(T);
+    }
+
+    // Free the elements of an array OPER.  An element owns its string only if
+    // the string was allocated by scalarToOper() and flagged xlbitDLLFree.
+    // The strings written by allocateOperArray() callers lie within the array
+    // itself, are not flagged, and are released with it.
+    template <class T>
+    void freeOperArray(T *px) {
+        std::size_t size = px->val.array.rows * px->val.array.columns;
+        for (std::size_t i=0; i<size; ++i) {
+            if (px->val.array.lparray[i].xltype == (xltypeStr | xlbitDLLFree)
+                && px->val.array.lparray[i].val.str)
+                delete [] px->val.array.lparray[i].val.str;
+        }
+        delete [] px->val.array.lparray;
+    }
+
+}
+
+DLL_API char *allocateOperArray(OPER &xArray, std::size_t stringBytes) {
+    // Allocate the string storage as additional elements of the array, so that
+    // the block is released by the same delete [] as any other array.
+    std::size_t size = xArray.val.array.rows * xArray.val.array.columns;
+    xArray.val.array.lparray = new OPER[size + extraElements<OPER>(stringBytes)];
+    xArray.xltype = xltypeMulti | xlbitDLLFree;
+    return reinterpret_cast<char*>(xArray.val.array.lparray + size);
+}
+
+DLL_API XCHAR *allocateOperArray(OPER12 &xArray, std::size_t stringChars) {
+    std::size_t size = xArray.val.array.rows * xArray.val.array.columns;
+    xArray.val.array.lparray = new OPER12[size + extraElements<OPER12>(stringChars * sizeof(XCHAR))];
+    xArray.xltype = xltypeMulti | xlbitDLLFree;
+    return reinterpret_cast<XCHAR*>(xArray.val.array.lparray + size);
+}
+
 DLL_API void freeOper(XLOPER *px) {
     if ((px->xltype == (xltypeStr | xlbitDLLFree))              // If this is a string allocated by the DLL
         && px->val.str) {                                       // .And if the pointer is not null...
         delete [] px->val.str;                                  // ..Then delete the pointer and return.
     } else if ((px->xltype == (xltypeMulti | xlbitDLLFree))     // If this is an array allocated by the DLL
         && px->val.array.lparray) {                             // .And if the pointer is not null...
-        int size = px->val.array.rows * px->val.array.columns;
-        for (int i=0; i<size; ++i) {                            // ..Then iterate through the array...
-            if (px->val.array.lparray[i].xltype & xltypeStr     // ...If this element is a string...
-                &&  px->val.array.lparray[i].val.str) {         // ....And if the pointer is not null...
-                delete [] px->val.array.lparray[i].val.str;     // .....Then delete the string...
-            }
-        }
-        delete [] px->val.array.lparray;                        // ..Now delete the array and return.
+        freeOperArray(px);                                      // ..Then delete its strings and the array.
+    }
+}
+
+DLL_API void freeOper(XLOPER12 *px) {
+    if ((px->xltype == (xltypeStr | xlbitDLLFree)) && px->val.str) {
+        delete [] px->val.str;
+    } else if ((px->xltype == (xltypeMulti | xlbitDLLFree)) && px->val.array.lparray) {
+        freeOperArray(px);
     }
 }
 
@@ -56,3 +99,8 @@ DLL_API void splitOper(const OPER *xFrom, OPER *xTo) {
     reposit::vectorToOper(vec, *xTo);
 }
 
+DLL_API void splitOper(const OPER12 *xFrom, OPER12 *xTo) {
+    std::string text = reposit::ConvertOper12(*xFrom);
+    std::vector<std::string> vec = reposit::split(text, ",;", false);
+    reposit::vectorToOper(vec, *xTo);
+}
@@ -26,10 +26,32 @@
 
 #include <rp/rpdefines.hpp>
 #include <xlsdk/xlsdkdefines.hpp>
+#include <cstddef>
 
 //! Free any memory associated with the XLOPER.
 DLL_API void freeOper(XLOPER *px);
 
+//! Free any memory associated with the XLOPER12.
+DLL_API void freeOper(XLOPER12 *px);
+
+//! Allocate the elements of an array OPER, and storage for their strings, in a single block.
+/*! The caller sets the dimensions of the array before calling this function,
+    which sets the xltypeMulti and xlbitDLLFree bits.  The block holds the
+    elements followed by stringBytes bytes, the address of which is returned,
+    for the byte-counted strings of the elements.  The block is itself an
+    array of OPERs, so freeOper() releases it with the same delete [] as any
+    other array.  The elements' strings must not be allocated separately, and
+    their type must be xltypeStr without xlbitDLLFree, which marks a string
+    that freeOper() deletes individually.
+*/
+DLL_API char *allocateOperArray(OPER &xArray, std::size_t stringBytes);
+
+//! Allocate the elements of an array OPER12, and storage for their strings, in a single block.
+/*! As for the OPER overload, the block holds the elements followed by
+    stringChars wide characters, the address of which is returned.
+*/
+DLL_API XCHAR *allocateOperArray(OPER12 &xArray, std::size_t stringChars);
+
 //! Determine whether the input value comprises a list.
 /*! Returns true if the input value is a string containing
     one or more ',' or ';' characters.  Returns false otherwise.
@@ -43,5 +65,8 @@ DLL_API bool isList(const OPER *xValue);
 */
 DLL_API void splitOper(const OPER *xFrom, OPER *xTo);
 
+//! Convert a delimited list in an OPER12 into a vector.
+DLL_API void splitOper(const OPER12 *xFrom, OPER12 *xTo);
+
 #endif
 
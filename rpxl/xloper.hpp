@@ -67,6 +67,36 @@ namespace reposit {
         XLOPER xloper_;
     };
 
+    //! Perform RAII for Excel's XLOPER12 datatype.
+    /*! The counterpart of class Xloper for values returned by Excel12.
+    */
+    class DLL_API Xloper12 {
+    public:
+
+        //! \name Structors
+        //@{
+        //! Constructor - initialize the type of the underling XLOPER12 to zero.
+        Xloper12() { xloper_.xltype = 0; }
+        //! Destructor - call xlFree on the XLOPER12, if memory has been allocated.
+        ~Xloper12() {
+            if (xloper_.xltype)
+                Excel12f(xlFree, 0, 1, &xloper_);
+        }
+        //@}
+
+        //! \name Inspectors
+        //@{
+        //! operator& - return the address of the underlying XLOPER12.
+        XLOPER12 *operator&() { return &xloper_; }
+        //! operator-> - return the address of the underlying XLOPER12.
+        const XLOPER12 *operator->() const { return &xloper_; }
+        //! operator() - return a const reference to the underlying XLOPER12.
+        const XLOPER12 &operator()() const { return xloper_; }
+        //@}
+    private:
+        XLOPER12 xloper_;
+    };
+
 }
 
 #endif
@@ -0,0 +1,257 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "callingrange.hpp"
+#include "excelutilities.hpp"
+#include <rpxl/callingrange.hpp>
+#include <rpxl/functioncall.hpp>
+#include <rpxl/convert_oper.hpp>
+#include <xlsdk/xlsdkdefines.hpp>
+#include <boost/lexical_cast.hpp>
+
+using namespace RepositTest;
+using namespace boost::unit_test_framework;
+using reposit::CallingRange;
+
+namespace {
+
+    std::string callerKey(const std::string &objectID) {
+        return reposit::RepositoryXL::instance().callerKey(ids(objectID))[0];
+    }
+
+    // Delete the given cell and the objects which reside in it.
+    void deleteCell(ExcelEmulator &excel, int row, int col) {
+        excel.deleteRange(1, row, col);
+        reposit::RepositoryXL::instance().collectGarbage();
+    }
+
+}
+
+void CallingRangeTest::testUpdateID() {
+
+    BOOST_TEST_MESSAGE("Testing the update count in full object IDs...");
+
+    ExcelEnvironment environment;
+
+    {
+        ExcelEmulator::Call call(1, 0, 0);
+        reposit::FunctionCall functionCall("test");
+        CallingRange callingRange;
+
+        BOOST_CHECK_EQUAL(callingRange.updateID("my_object"), "my_object#0000");
+        BOOST_CHECK_EQUAL(callingRange.getUpdateCount(), "0000");
+
+        // The overload writing to an existing string replaces its contents.
+        std::string idFull("a_much_longer_previous_value#1234");
+        callingRange.updateID("my_object", idFull);
+        BOOST_CHECK_EQUAL(idFull, "my_object#0001");
+        BOOST_CHECK_EQUAL(callingRange.updateCount(), "0002");
+        BOOST_CHECK_EQUAL(callingRange.getUpdateCount(), "0002");
+
+        // The count has four digits and wraps around to zero.
+        for (int i = 3; i < 9999; ++i)
+            callingRange.updateID("x", idFull);
+        BOOST_CHECK_EQUAL(idFull, "x#9998");
+        BOOST_CHECK_EQUAL(callingRange.updateID("x"), "x#9999");
+        BOOST_CHECK_EQUAL(callingRange.updateID("x"), "x#0000");
+        BOOST_CHECK_EQUAL(callingRange.updateID("x"), "x#0001");
+    }
+
+    {
+        // An object constructed from VBA has no update count.
+        ExcelEmulator::Call call;
+        reposit::FunctionCall functionCall("test");
+        CallingRange callingRange;
+        std::string idFull("previous#0000");
+        callingRange.updateID("my_object", idFull);
+        BOOST_CHECK_EQUAL(idFull, "my_object");
+        BOOST_CHECK_EQUAL(callingRange.updateID("my_object"), "my_object");
+    }
+
+    // The count is incremented each time the cell stores its object.
+    BOOST_CHECK_EQUAL(callNode(1, 1, 0, "a"), "a#0000");
+    BOOST_CHECK_EQUAL(callNode(1, 1, 0, "a"), "a#0001");
+    BOOST_CHECK_EQUAL(callNode(1, 1, 0, "b"), "b#0002");
+}
+
+void CallingRangeTest::testStub() {
+
+    BOOST_TEST_MESSAGE("Testing the conversion of full object IDs to normal IDs...");
+
+    ExcelEnvironment environment;
+
+    const char *cases[][2] = {
+        { "my_object#0001", "my_object" },
+        { "my_object", "my_object" },
+        { "#0001", "" },
+        { "a#b#0001", "a#b" },
+        { "a#001", "a#001" },
+        { "a#00001", "a#00001" },
+        { "a0001", "a0001" },
+        { "", "" } };
+    for (std::size_t i = 0; i < sizeof(cases)/sizeof(cases[0]); ++i) {
+        BOOST_CHECK_EQUAL(CallingRange::getStub(cases[i][0]), cases[i][1]);
+        BOOST_CHECK_EQUAL(CallingRange::stubLength(cases[i][0]), std::string(cases[i][1]).length());
+    }
+
+    // Strings passed to addin functions are converted to normal IDs.
+    ExcelEmulator::Call call(1, 0, 0);
+    BOOST_CHECK_EQUAL(static_cast<std::string>(
+        reposit::ConvertOper(*TempStrStl("my_object#0123"))), "my_object");
+    BOOST_CHECK_EQUAL(static_cast<std::string>(
+        reposit::ConvertOper(*TempStrStl("my_object"))), "my_object");
+
+    // Full IDs are accepted wherever the Repository looks up an object.
+    callNode(1, 5, 0, "a");
+    std::string idFull = callNode(1, 5, 0, "a");
+    BOOST_CHECK_EQUAL(idFull, "a#0001");
+    BOOST_CHECK_EQUAL(reposit::RepositoryXL::instance().callerAddress(ids(idFull))[0],
+                      "[Book1]Sheet1!R6C1");
+    BOOST_CHECK(reposit::RepositoryXL::instance().objectExists(ids(idFull))[0]);
+}
+
+void CallingRangeTest::testKeys() {
+
+    BOOST_TEST_MESSAGE("Testing the allocation of calling range keys...");
+
+    std::size_t index;
+    BOOST_CHECK_EQUAL(CallingRange::keyWidth(), 8);
+    BOOST_CHECK(CallingRange::parseKey("_0000001f", index));
+    BOOST_CHECK_EQUAL(index, 31u);
+    BOOST_CHECK(CallingRange::parseKey("_FFFFFFFF", index));
+    BOOST_CHECK_EQUAL(index, 0xFFFFFFFFUL);
+    const char *invalid[] = { "", "VBA", "_1f", "0000001f", "x0000001f", "_0000001g", "_00000001f" };
+    for (std::size_t i = 0; i < sizeof(invalid)/sizeof(invalid[0]); ++i)
+        BOOST_CHECK_MESSAGE(!CallingRange::parseKey(invalid[i], index), invalid[i]);
+
+    ExcelEnvironment environment;
+    ExcelEmulator &excel = environment.excel();
+
+    // The key of a deleted range is reused by the next new range.
+    callNode(1, 0, 0, "a");
+    std::string key = callerKey("a");
+    BOOST_REQUIRE(CallingRange::parseKey(key, index));
+    deleteCell(excel, 0, 0);
+    callNode(1, 5, 0, "b");
+    BOOST_CHECK_EQUAL(callerKey("b"), key);
+    BOOST_CHECK_EQUAL(excel.nameReference(key), "[Book1]Sheet1!R6C1");
+
+    // The ID of an anonymous object is not reused with its key, so a stale
+    // reference to the ID fails instead of finding an unrelated object.
+    std::string stale = CallingRange::getStub(callNode(1, 1, 0, ""));
+    std::string keyAnon = callerKey(stale);
+    BOOST_CHECK_EQUAL(stale, "obj" + keyAnon);
+    deleteCell(excel, 1, 0);
+    BOOST_CHECK(!reposit::RepositoryXL::instance().objectExists(ids(stale))[0]);
+    std::string anon = CallingRange::getStub(callNode(1, 2, 0, ""));
+    BOOST_CHECK_EQUAL(callerKey(anon), keyAnon);
+    BOOST_CHECK_EQUAL(anon, stale + "_1");
+    BOOST_CHECK(!reposit::RepositoryXL::instance().objectExists(ids(stale))[0]);
+    BOOST_CHECK(reposit::RepositoryXL::instance().objectExists(ids(anon))[0]);
+    deleteCell(excel, 2, 0);
+
+    // So the keys do not grow however many ranges come and go.
+    callNode(1, 6, 0, "c");
+    std::string keyC = callerKey("c");
+    int newKeys = 0;
+    for (int i = 0; i < 2000; ++i) {
+        deleteCell(excel, 6 + i, 0);
+        callNode(1, 7 + i, 0, "c");
+        if (callerKey("c") != keyC)
+            ++newKeys;
+    }
+    BOOST_CHECK_EQUAL(newKeys, 0);
+    BOOST_CHECK_EQUAL(excel.nameCount(), 2u);
+
+    // With deferred naming, the key of a deleted range is not reused until
+    // its name has been deleted.
+    CallingRange::setDeferNames(true);
+    deleteCell(excel, 2006, 0);
+    callNode(1, 3000, 0, "d");
+    std::string keyD = callerKey("d");
+    BOOST_CHECK(keyD != keyC);
+    BOOST_CHECK_EQUAL(excel.nameReference(keyD), "");
+    // The pending name identifies the range until it is created.
+    BOOST_CHECK_EQUAL(callNode(1, 3000, 0, "d"), "d#0001");
+    CallingRange::flushNames();
+    BOOST_CHECK_EQUAL(excel.nameReference(keyD), "[Book1]Sheet1!R3001C1");
+    callNode(1, 3001, 0, "e");
+    BOOST_CHECK_EQUAL(callerKey("e"), keyC);
+    CallingRange::setDeferNames(false);
+}
+
+void CallingRangeTest::testDeferredNames() {
+
+    BOOST_TEST_MESSAGE("Testing the deferred naming of calling ranges...");
+
+    ExcelEnvironment environment;
+    ExcelEmulator &excel = environment.excel();
+    const int N = 10;
+
+    // Each new range is named as it is constructed.
+    excel.reset();
+    for (int i = 0; i < N; ++i)
+        callNode(1, i, 0, "a" + boost::lexical_cast<std::string>(i));
+    BOOST_CHECK_EQUAL(excel.calls(xlfSetName), N);
+
+    // With deferred naming no name is created during the calculation.
+    CallingRange::setDeferNames(true);
+    excel.reset();
+    for (int i = 0; i < N; ++i)
+        callNode(1, 100 + i, 0, "b" + boost::lexical_cast<std::string>(i));
+    BOOST_CHECK_EQUAL(excel.calls(xlfSetName), 0);
+    BOOST_CHECK_EQUAL(excel.nameCount(), static_cast<std::size_t>(N));
+
+    // Until the names are flushed the ranges are found in pendingNames_,
+    // without looking up the name of the caller.
+    {
+        ExcelEmulator::Call call(1, 100, 0);
+        reposit::FunctionCall functionCall("test");
+        reposit::CallerId callerId;
+        BOOST_REQUIRE(functionCall.callerId(callerId));
+        std::string key;
+        BOOST_CHECK(CallingRange::pendingName(callerId, key));
+        BOOST_CHECK_EQUAL(key, callerKey("b0"));
+    }
+    excel.reset();
+    for (int i = 0; i < N; ++i)
+        BOOST_CHECK_EQUAL(callNode(1, 100 + i, 0, "b" + boost::lexical_cast<std::string>(i)),
+                          "b" + boost::lexical_cast<std::string>(i) + "#0001");
+    BOOST_CHECK_EQUAL(excel.calls(xlfSetName), 0);
+    BOOST_CHECK_EQUAL(excel.calls(xlfGetDef), 0);
+
+    // The names are then created together, once for each range however
+    // often it was recalculated.
+    CallingRange::flushNames();
+    BOOST_CHECK_EQUAL(excel.calls(xlfSetName), N);
+    BOOST_CHECK_EQUAL(excel.nameCount(), static_cast<std::size_t>(2 * N));
+    BOOST_CHECK_EQUAL(excel.nameReference(callerKey("b0")), "[Book1]Sheet1!R101C1");
+    BOOST_CHECK_EQUAL(callNode(1, 100, 0, "b0"), "b0#0002");
+    CallingRange::setDeferNames(false);
+}
+
+test_suite* CallingRangeTest::suite() {
+    test_suite* suite = BOOST_TEST_SUITE("CallingRange tests");
+    suite->add(BOOST_TEST_CASE(&CallingRangeTest::testUpdateID));
+    suite->add(BOOST_TEST_CASE(&CallingRangeTest::testStub));
+    suite->add(BOOST_TEST_CASE(&CallingRangeTest::testKeys));
+    suite->add(BOOST_TEST_CASE(&CallingRangeTest::testDeferredNames));
+    return suite;
+}
+
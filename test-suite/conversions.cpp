@@ -0,0 +1,344 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "conversions.hpp"
+#include "excelutilities.hpp"
+#include <rpxl/convert_oper.hpp>
+#include <rpxl/conversions/vectortooper.hpp>
+#include <rpxl/conversions/matrixtooper.hpp>
+#include <rpxl/conversions/opertovector.hpp>
+#include <rpxl/conversions/opertomatrix.hpp>
+#include <rpxl/utilities/xlutilities.hpp>
+#include <rp/property.hpp>
+#include <boost/lexical_cast.hpp>
+#include <algorithm>
+
+using namespace RepositTest;
+using namespace boost::unit_test_framework;
+
+namespace {
+
+    std::string element(const OPER &xArray, int i) {
+        return reposit::ConvertOper(xArray.val.array.lparray[i]);
+    }
+
+    std::string element(const OPER12 &xArray, int i) {
+        return reposit::ConvertOper12(xArray.val.array.lparray[i]);
+    }
+
+    // An array OPER referring to the given elements.
+    OPER multi(std::vector<OPER> &elements, int rows, int cols) {
+        OPER xMulti;
+        xMulti.xltype = xltypeMulti;
+        xMulti.val.array.rows = rows;
+        xMulti.val.array.columns = cols;
+        xMulti.val.array.lparray = &elements[0];
+        return xMulti;
+    }
+
+    OPER number(double value) {
+        OPER xNum;
+        xNum.xltype = xltypeNum;
+        xNum.val.num = value;
+        return xNum;
+    }
+
+}
+
+void ConversionsTest::testStringArrays() {
+
+    BOOST_TEST_MESSAGE("Testing the return of arrays of strings...");
+
+    ExcelEnvironment environment;
+
+    std::vector<std::string> v;
+    v.push_back("abc");
+    v.push_back("");
+    v.push_back(std::string(300, 'x'));
+
+    {
+        // A column caller receives a column, with the strings packed into
+        // the array, unflagged, and truncated to the maximum length.
+        ExcelEmulator::Call call(1, 0, 0, 3, 1);
+        reposit::FunctionCall functionCall("test");
+        OPER xVector;
+        reposit::vectorToOper(v, xVector);
+        BOOST_REQUIRE(xVector.xltype == (xltypeMulti | xlbitDLLFree));
+        BOOST_CHECK_EQUAL(xVector.val.array.rows, 3);
+        BOOST_CHECK_EQUAL(xVector.val.array.columns, 1);
+        BOOST_CHECK(xVector.val.array.lparray[0].xltype == xltypeStr);
+        BOOST_CHECK_EQUAL(element(xVector, 0), "abc");
+        BOOST_CHECK_EQUAL(element(xVector, 1), "");
+        BOOST_CHECK_EQUAL(element(xVector, 2), std::string(XL_MAX_STR_LEN - 1, 'x'));
+        freeOper(&xVector);
+
+        OPER12 xVector12;
+        reposit::vectorToOper(v, xVector12);
+        BOOST_REQUIRE(xVector12.xltype == (xltypeMulti | xlbitDLLFree));
+        BOOST_CHECK(xVector12.val.array.lparray[2].xltype == xltypeStr);
+        BOOST_CHECK_EQUAL(element(xVector12, 0), "abc");
+        BOOST_CHECK_EQUAL(element(xVector12, 2), std::string(300, 'x'));
+        freeOper(&xVector12);
+
+        // An empty vector is returned as #N/A.
+        reposit::vectorToOper(std::vector<std::string>(), xVector);
+        BOOST_CHECK(xVector.xltype == xltypeErr && xVector.val.err == xlerrNA);
+    }
+
+    {
+        ExcelEmulator::Call call(1, 0, 0, 1, 3);
+        reposit::FunctionCall functionCall("test");
+        OPER xVector;
+        reposit::vectorToOper(v, xVector);
+        BOOST_CHECK_EQUAL(xVector.val.array.rows, 1);
+        BOOST_CHECK_EQUAL(xVector.val.array.columns, 3);
+        freeOper(&xVector);
+    }
+
+    {
+        ExcelEmulator::Call call(1, 0, 0, 2, 3);
+        reposit::FunctionCall functionCall("test");
+        std::vector<std::vector<std::string> > vv(2, v);
+        vv[1][0] = "def";
+        OPER xMatrix;
+        reposit::matrixToOper(vv, xMatrix);
+        BOOST_REQUIRE(xMatrix.xltype == (xltypeMulti | xlbitDLLFree));
+        BOOST_CHECK_EQUAL(xMatrix.val.array.rows, 2);
+        BOOST_CHECK_EQUAL(xMatrix.val.array.columns, 3);
+        BOOST_CHECK_EQUAL(element(xMatrix, 0), "abc");
+        BOOST_CHECK_EQUAL(element(xMatrix, 3), "def");
+        freeOper(&xMatrix);
+
+        vv[1].pop_back();
+        BOOST_CHECK_THROW(reposit::matrixToOper(vv, xMatrix), std::exception);
+    }
+
+    {
+        // Arrays of other types own the strings of their elements, which
+        // freeOper() releases individually.
+        ExcelEmulator::Call call(1, 0, 0, 3, 1);
+        reposit::FunctionCall functionCall("test");
+        std::vector<reposit::property_t> p;
+        p.push_back(std::string("abc"));
+        p.push_back(1.5);
+        p.push_back(std::string("def"));
+        OPER xVector;
+        reposit::vectorToOper(p, xVector);
+        BOOST_REQUIRE(xVector.xltype == (xltypeMulti | xlbitDLLFree));
+        BOOST_CHECK(xVector.val.array.lparray[0].xltype == (xltypeStr | xlbitDLLFree));
+        BOOST_CHECK_EQUAL(element(xVector, 2), "def");
+        BOOST_CHECK_EQUAL(xVector.val.array.lparray[1].val.num, 1.5);
+        freeOper(&xVector);
+    }
+}
+
+void ConversionsTest::testNumericArrays() {
+
+    BOOST_TEST_MESSAGE("Testing the conversion of numeric arrays...");
+
+    ExcelEnvironment environment;
+    ExcelEmulator &excel = environment.excel();
+
+    std::vector<OPER> elements;
+    for (int i = 0; i < 6; ++i)
+        elements.push_back(number(i * 1.5));
+    OPER xMulti = multi(elements, 2, 3);
+
+    // Arrays and scalars are converted without calling back into Excel, and
+    // the conversion agrees with that of the elements one at a time.
+    excel.reset();
+    std::vector<double> v = reposit::operToVector<double>(xMulti, "v");
+    std::vector<long> l = reposit::operToVector<long>(xMulti, "l");
+    std::vector<std::vector<double> > m = reposit::operToMatrix<double>(xMulti, "m");
+    OPER xScalar = number(2.5);
+    std::vector<double> s = reposit::operToVector<double>(xScalar, "s");
+    std::vector<std::vector<double> > sm = reposit::operToMatrix<double>(xScalar, "sm");
+    BOOST_CHECK_EQUAL(excel.calls(xlCoerce), 0);
+
+    BOOST_REQUIRE_EQUAL(v.size(), 6u);
+    BOOST_REQUIRE_EQUAL(l.size(), 6u);
+    for (int i = 0; i < 6; ++i) {
+        reposit::ConvertOper element(elements[i]);
+        BOOST_CHECK_EQUAL(v[i], reposit::convert<double>(element));
+        BOOST_CHECK_EQUAL(l[i], reposit::convert<long>(element));
+    }
+    BOOST_REQUIRE_EQUAL(m.size(), 2u);
+    BOOST_REQUIRE_EQUAL(m[1].size(), 3u);
+    BOOST_CHECK_EQUAL(m[1][0], 4.5);
+    BOOST_CHECK_EQUAL(m[1][2], 7.5);
+    BOOST_REQUIRE(s.size() == 1 && sm.size() == 1 && sm[0].size() == 1);
+    BOOST_CHECK_EQUAL(s[0], 2.5);
+    BOOST_CHECK_EQUAL(sm[0][0], 2.5);
+
+    // A boolean element takes the slow path, a string is an error.
+    elements[1].xltype = xltypeBool;
+    elements[1].val.xbool = 1;
+    v = reposit::operToVector<double>(xMulti, "v");
+    BOOST_CHECK_EQUAL(v[1], reposit::convert<double>(reposit::ConvertOper(elements[1])));
+    static char text[] = "\003abc";
+    elements[1].xltype = xltypeStr;
+    elements[1].val.str = text;
+    BOOST_CHECK_THROW(reposit::operToMatrix<double>(xMulti, "m"), std::exception);
+
+    // A reference is coerced by Excel.
+    for (int i = 0; i < 2; ++i)
+        for (int j = 0; j < 3; ++j)
+            excel.setCell(1, 10 + i, 20 + j, i * 10.0 + j);
+    XLMREF xMref;
+    xMref.count = 1;
+    xMref.reftbl[0].rwFirst = 10;
+    xMref.reftbl[0].rwLast = 11;
+    xMref.reftbl[0].colFirst = 20;
+    xMref.reftbl[0].colLast = 22;
+    OPER xRef;
+    xRef.xltype = xltypeRef;
+    xRef.val.mref.idSheet = 1;
+    xRef.val.mref.lpmref = &xMref;
+    excel.reset();
+    m = reposit::operToMatrix<double>(xRef, "m");
+    BOOST_CHECK_EQUAL(excel.calls(xlCoerce), 1);
+    BOOST_REQUIRE(m.size() == 2 && m[1].size() == 3);
+    BOOST_CHECK_EQUAL(m[1][2], 12.0);
+
+    // An FP is read row by row.
+    std::vector<char> buffer(sizeof(FP) + 5 * sizeof(double));
+    FP *fp = reinterpret_cast<FP*>(&buffer[0]);
+    fp->rows = 3;
+    fp->columns = 2;
+    for (int i = 0; i < 6; ++i)
+        fp->array[i] = i;
+    m = reposit::fpToMatrix<double>(*fp);
+    BOOST_REQUIRE(m.size() == 3 && m[2].size() == 2);
+    BOOST_CHECK_EQUAL(m[0][1], 1.0);
+    BOOST_CHECK_EQUAL(m[2][0], 4.0);
+}
+
+void ConversionsTest::testTempMemory() {
+
+    BOOST_TEST_MESSAGE("Testing the temporary memory of the Excel framework...");
+
+    // Temporary values of any size may be allocated, beyond the static block.
+    FreeAllTempMemory();
+    std::string s(3000, 'x');
+    for (int i = 0; i < 100; ++i) {
+        LPXLOPER xStr = TempStrStl(s);
+        BOOST_REQUIRE(xStr->val.str[0] == (char)255);
+    }
+    BOOST_CHECK(TempMemoryHighWater() > 100 * 255);
+    BOOST_CHECK(TempMemoryReserved() > MEMORYSIZE);
+
+    // Once freed, the memory is retained up to the limit, and reused.
+    std::vector<char> big(100000, 'x');
+    LPSTR lpMemory = GetTempMemory(100000);
+    std::copy(big.begin(), big.end(), lpMemory);
+    FreeAllTempMemory();
+    int reserved = TempMemoryReserved();
+    BOOST_CHECK(reserved <= MEMORYSIZE + MAXRETAINEDMEMORY);
+    GetTempMemory(10000);
+    FreeAllTempMemory();
+    BOOST_CHECK_EQUAL(TempMemoryReserved(), reserved);
+
+    // When the addin is unloaded, all of it is returned.
+    GetTempMemory(5000);
+    ReleaseTempMemory();
+    BOOST_CHECK_EQUAL(TempMemoryReserved(), MEMORYSIZE);
+    BOOST_CHECK(GetTempMemory(5000) != 0);
+    FreeAllTempMemory();
+}
+
+void ConversionsTest::testLargeGrid() {
+
+    BOOST_TEST_MESSAGE("Testing the conversion of values beyond the Excel 97 grid...");
+
+    ExcelEnvironment environment;
+
+    // A column longer than 65536 rows, and a matrix wider than 256 columns.
+    const int N = 100000;
+    std::vector<OPER12> elements(N);
+    for (int i = 0; i < N; ++i) {
+        elements[i].xltype = xltypeNum;
+        elements[i].val.num = i;
+    }
+    OPER12 xColumn;
+    xColumn.xltype = xltypeMulti;
+    xColumn.val.array.rows = N;
+    xColumn.val.array.columns = 1;
+    xColumn.val.array.lparray = &elements[0];
+    std::vector<double> v = reposit::operToVector<double>(xColumn, "v");
+    BOOST_REQUIRE_EQUAL(v.size(), std::size_t(N));
+    BOOST_CHECK_EQUAL(v[N - 1], N - 1.0);
+
+    OPER12 xMatrix = xColumn;
+    xMatrix.val.array.rows = 200;
+    xMatrix.val.array.columns = 500;
+    std::vector<std::vector<long> > m = reposit::operToMatrix<long>(xMatrix, "m");
+    BOOST_REQUIRE(m.size() == 200 && m[199].size() == 500);
+    BOOST_CHECK_EQUAL(m[1][300], 800);
+    BOOST_CHECK_EQUAL(m[199][499], N - 1);
+
+    // Strings longer than 255 characters, up to the limit of an XLOPER12.
+    OPER12 xString;
+    reposit::scalarToOper(std::string(1000, 'y'), xString);
+    BOOST_CHECK_EQUAL(reposit::convert<std::string>(reposit::ConvertOper12(xString)),
+                      std::string(1000, 'y'));
+    freeOper(&xString);
+    reposit::scalarToOper(std::string(40000, 'y'), xString);
+    BOOST_CHECK_EQUAL(xString.val.str[0], XL_MAX_STR_LEN12 - 1);
+    freeOper(&xString);
+
+    // A column of strings returned to a caller beyond row 65536.
+    std::vector<std::string> ids(N);
+    for (int i = 0; i < N; ++i)
+        ids[i] = boost::lexical_cast<std::string>(i);
+    {
+        ExcelEmulator::Call call(1, 0, 0, N, 1);
+        reposit::FunctionCall functionCall("test");
+        OPER12 xVector;
+        reposit::vectorToOper(ids, xVector);
+        BOOST_REQUIRE(xVector.xltype == (xltypeMulti | xlbitDLLFree));
+        BOOST_CHECK_EQUAL(xVector.val.array.rows, N);
+        BOOST_CHECK_EQUAL(element(xVector, N - 1), ids[N - 1]);
+        freeOper(&xVector);
+    }
+
+    // A list in a single string is split.
+    {
+        ExcelEmulator::Call call(1, 0, 0);
+        reposit::FunctionCall functionCall("test");
+        std::vector<XCHAR> list(1, 5);
+        std::string text("1,2,3");
+        list.insert(list.end(), text.begin(), text.end());
+        OPER12 xList;
+        xList.xltype = xltypeStr;
+        xList.val.str = &list[0];
+        v = reposit::operToVector<double>(xList, "list");
+        BOOST_REQUIRE_EQUAL(v.size(), 3u);
+        BOOST_CHECK_EQUAL(v[2], 3.0);
+    }
+}
+
+test_suite* ConversionsTest::suite() {
+    test_suite* suite = BOOST_TEST_SUITE("Conversion tests");
+    suite->add(BOOST_TEST_CASE(&ConversionsTest::testStringArrays));
+    suite->add(BOOST_TEST_CASE(&ConversionsTest::testNumericArrays));
+    suite->add(BOOST_TEST_CASE(&ConversionsTest::testTempMemory));
+    suite->add(BOOST_TEST_CASE(&ConversionsTest::testLargeGrid));
+    return suite;
+}
+
@@ -0,0 +1,131 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "excelutilities.hpp"
+#include <rpxl/configuration.hpp>
+#include <rpxl/functioncall.hpp>
+#include <rpxl/objectwrapperxl.hpp>
+#include <rpxl/conversions/validations.hpp>
+#include <xlsdk/xlsdkdefines.hpp>
+#include <vector>
+
+namespace RepositTest {
+
+    ExcelEnvironment::ExcelEnvironment() {
+        reposit::Configuration::instance().init();
+        repository_.clear();
+    }
+
+    ExcelEnvironment::~ExcelEnvironment() {
+        repository_.setDeferredDestruction(false);
+        repository_.clear();
+    }
+
+    char *xlNode(char *objectID, long *value, char *precedents, bool *permanent) {
+
+        boost::shared_ptr<reposit::FunctionCall> functionCall;
+
+        try {
+
+            functionCall = boost::shared_ptr<reposit::FunctionCall>
+                (new reposit::FunctionCall("xlNode"));
+
+            boost::shared_ptr<reposit::ValueObject> valueObject(
+                new NodeValueObject(objectID, *value, ids(precedents), *permanent));
+
+            boost::shared_ptr<reposit::Object> object = createNode(valueObject);
+
+            std::string returnValue =
+                reposit::RepositoryXL::instance().storeObject(objectID, object, false, valueObject);
+
+            static char ret[XL_MAX_STR_LEN];
+            reposit::stringToChar(returnValue, ret);
+            return ret;
+
+        } catch (const std::exception &e) {
+
+            reposit::RepositoryXL::instance().logError(e.what(), functionCall);
+            return 0;
+
+        }
+    }
+
+    double *xlNodeTotal(char *objectID) {
+
+        boost::shared_ptr<reposit::FunctionCall> functionCall;
+
+        try {
+
+            functionCall = boost::shared_ptr<reposit::FunctionCall>
+                (new reposit::FunctionCall("xlNodeTotal", true));
+
+            RP_GET_OBJECT(node, objectID, NodeObject)
+
+            static double ret;
+            ret = node->total();
+            return &ret;
+
+        } catch (const std::exception &e) {
+
+            reposit::RepositoryXL::instance().logError(e.what(), functionCall);
+            return 0;
+
+        }
+    }
+
+    std::string callNode(IDSHEET sheet, int row, int col,
+                         const std::string &objectID,
+                         long value,
+                         const std::string &precedents,
+                         bool permanent) {
+
+        ExcelEmulator::Call call(sheet, row, col);
+        std::vector<char> id(objectID.begin(), objectID.end());
+        id.push_back(0);
+        std::vector<char> list(precedents.begin(), precedents.end());
+        list.push_back(0);
+        char *ret = xlNode(&id[0], &value, &list[0], &permanent);
+        return ret ? ret : "";
+    }
+
+    bool callNodeTotal(IDSHEET sheet, int row, int col, int rows, int cols,
+                       const std::string &objectID, bool threadSafe) {
+
+        ExcelEmulator::Call call(sheet, row, col, rows, cols, threadSafe);
+        std::vector<char> id(objectID.begin(), objectID.end());
+        id.push_back(0);
+        return xlNodeTotal(&id[0]) != 0;
+    }
+
+    std::string retrieveError(IDSHEET sheet, int row, int col, int rows, int cols) {
+        XLMREF xMref;
+        xMref.count = 1;
+        xMref.reftbl[0].rwFirst = row;
+        xMref.reftbl[0].rwLast = row + rows - 1;
+        xMref.reftbl[0].colFirst = col;
+        xMref.reftbl[0].colLast = col + cols - 1;
+        XLOPER xRef;
+        xRef.xltype = xltypeRef;
+        xRef.val.mref.idSheet = sheet;
+        xRef.val.mref.lpmref = &xMref;
+        return reposit::RepositoryXL::instance().retrieveError(&xRef);
+    }
+
+}
+
@@ -0,0 +1,72 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file
+    \brief Fixtures for testing rpxl against the Excel emulator
+*/
+
+#ifndef reposit_test_excelutilities_hpp
+#define reposit_test_excelutilities_hpp
+
+#include "utilities.hpp"
+#include "xlemulator/xlemulator.hpp"
+#include <rpxl/repositoryxl.hpp>
+
+namespace RepositTest {
+
+    //! The global objects required by RepositoryXL, in an emulated Excel session.
+    /*! Instantiate one of these at the start of each test.  The destructor
+        clears the RepositoryXL before shutting down the emulator.
+    */
+    class ExcelEnvironment {
+    public:
+        ExcelEnvironment();
+        ~ExcelEnvironment();
+        ExcelEmulator &excel() { return excel_; }
+    private:
+        ExcelEmulator excel_;
+        reposit::RepositoryXL repository_;
+        reposit::ProcessorFactory processorFactory_;
+        SerializationFactory serializationFactory_;
+    };
+
+    //! Worksheet function constructing a Node, in the style of the generated addin functions.
+    /*! The precedents are given as a comma delimited list.  Returns the full
+        ID of the Node, or 0 if an error was logged against the caller.
+    */
+    char *xlNode(char *objectID, long *value, char *precedents, bool *permanent);
+    //! Worksheet function returning the total of a Node, read only.
+    double *xlNodeTotal(char *objectID);
+
+    //! Invoke xlNode() from the given cell, return the full ID or an empty string on error.
+    std::string callNode(IDSHEET sheet, int row, int col,
+                         const std::string &objectID,
+                         long value = 0,
+                         const std::string &precedents = "",
+                         bool permanent = false);
+    //! Invoke xlNodeTotal() from the given range, return true if it succeeded.
+    bool callNodeTotal(IDSHEET sheet, int row, int col, int rows, int cols,
+                       const std::string &objectID, bool threadSafe = false);
+    //! The error message which RepositoryXL returns for the given range.
+    std::string retrieveError(IDSHEET sheet, int row, int col, int rows = 1, int cols = 1);
+
+}
+
+#endif
+
@@ -0,0 +1,203 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "loop.hpp"
+#include "excelutilities.hpp"
+#include <rpxl/loop.hpp>
+#include <sstream>
+
+using namespace RepositTest;
+using namespace boost::unit_test_framework;
+
+namespace {
+
+    // A thread safe loop function, failing for zero.
+    struct Reciprocal {
+        double operator()(const double &x) {
+            if (x == 0)
+                RP_FAIL("division by zero");
+            return 1 / x;
+        }
+    };
+
+    // A loop function without a return value, failing for negative numbers.
+    struct Validate {
+        void operator()(const double &x) {
+            RP_REQUIRE(x >= 0, "negative value " << x);
+        }
+    };
+
+    // An array of numbers in the cycle -1, 0, 1, ..., 11, with a string in
+    // every 17th element, so that some iterations fail in conversion and some
+    // in evaluation.
+    class Input {
+    public:
+        Input(int rows, int cols) : values_(rows * cols) {
+            static char text[] = "\003abc";
+            for (int i = 0; i < rows * cols; ++i) {
+                if (i % 17 == 5) {
+                    values_[i].xltype = xltypeStr;
+                    values_[i].val.str = text;
+                } else {
+                    values_[i].xltype = xltypeNum;
+                    values_[i].val.num = i % 13 - 1;
+                }
+            }
+            xMulti_.xltype = xltypeMulti;
+            xMulti_.val.array.rows = rows;
+            xMulti_.val.array.columns = cols;
+            xMulti_.val.array.lparray = &values_[0];
+        }
+        OPER *operator()() { return &xMulti_; }
+    private:
+        std::vector<OPER> values_;
+        OPER xMulti_;
+    };
+
+    // Invoke the given loop from a range in column col, return the output
+    // and the error logged against the range.
+    template<class LoopFunction, class OutputType>
+    std::string callLoop(int col, Input &input, XLOPER &xOut, unsigned int threadCount) {
+        int rows = input()->val.array.rows;
+        int cols = input()->val.array.columns;
+        {
+            ExcelEmulator::Call call(1, 0, col, rows, cols);
+            boost::shared_ptr<reposit::FunctionCall> functionCall(
+                new reposit::FunctionCall("loop", true));
+            LoopFunction loopFunction;
+            if (threadCount == 1)
+                reposit::loop<LoopFunction, double, OutputType>(
+                    functionCall, loopFunction, input(), xOut);
+            else
+                reposit::loopParallel<LoopFunction, double, OutputType>(
+                    functionCall, loopFunction, input(), xOut, threadCount);
+        }
+        return retrieveError(1, 0, col, rows, cols);
+    }
+
+    void checkEqual(const XLOPER &xSerial, const XLOPER &xParallel) {
+        BOOST_REQUIRE(xParallel.xltype == xSerial.xltype);
+        BOOST_REQUIRE(xParallel.val.array.rows == xSerial.val.array.rows);
+        BOOST_REQUIRE(xParallel.val.array.columns == xSerial.val.array.columns);
+        int numCells = xSerial.val.array.rows * xSerial.val.array.columns;
+        for (int i = 0; i < numCells; ++i) {
+            const XLOPER &s = xSerial.val.array.lparray[i];
+            const XLOPER &p = xParallel.val.array.lparray[i];
+            BOOST_REQUIRE(p.xltype == s.xltype);
+            if (s.xltype == xltypeNum)
+                BOOST_CHECK_EQUAL(p.val.num, s.val.num);
+            else if (s.xltype == xltypeBool)
+                BOOST_CHECK_EQUAL(p.val.xbool, s.val.xbool);
+            else
+                BOOST_CHECK_EQUAL(p.val.err, s.val.err);
+        }
+    }
+
+}
+
+void LoopTest::testParallel() {
+
+    BOOST_TEST_MESSAGE("Testing the parallel evaluation of loop functions...");
+
+    ExcelEnvironment environment;
+
+    // Fewer failures than the limit, so that each is logged.
+    Input small(4, 3);
+    XLOPER xSerial, xParallel;
+    std::string serialError = callLoop<Reciprocal, double>(0, small, xSerial, 1);
+    std::string parallelError = callLoop<Reciprocal, double>(5, small, xParallel, 4);
+    checkEqual(xSerial, xParallel);
+    BOOST_CHECK_EQUAL(parallelError, serialError);
+    BOOST_CHECK(serialError.find("iteration #1 - division by zero") != std::string::npos);
+    BOOST_CHECK(serialError.find("iteration #5 - ") != std::string::npos);
+    BOOST_CHECK(xSerial.val.array.lparray[0].xltype == xltypeNum);
+    BOOST_CHECK_EQUAL(xSerial.val.array.lparray[0].val.num, -1.0);
+    BOOST_CHECK(xSerial.val.array.lparray[1].xltype == xltypeErr);
+    BOOST_CHECK_EQUAL(xSerial.val.array.lparray[1].val.err, xlerrNum);
+    freeOper(&xSerial);
+    freeOper(&xParallel);
+
+    // Failures across the slices of every thread, more than the limit, and
+    // more threads than cells in the last case.
+    Input large(60, 5);
+    serialError = callLoop<Reciprocal, double>(0, large, xSerial, 1);
+    BOOST_CHECK(serialError.find("logging discontinued") != std::string::npos);
+    unsigned int threadCounts[] = { 2, 3, 7, 500 };
+    for (std::size_t i = 0; i < sizeof(threadCounts) / sizeof(unsigned int); ++i) {
+        parallelError = callLoop<Reciprocal, double>(5, large, xParallel, threadCounts[i]);
+        checkEqual(xSerial, xParallel);
+        BOOST_CHECK_EQUAL(parallelError, serialError);
+        freeOper(&xParallel);
+    }
+    freeOper(&xSerial);
+
+    // A loop function returning void, for which a successful iteration returns TRUE.
+    serialError = callLoop<Validate, void>(0, large, xSerial, 1);
+    parallelError = callLoop<Validate, void>(5, large, xParallel, 4);
+    checkEqual(xSerial, xParallel);
+    BOOST_CHECK_EQUAL(parallelError, serialError);
+    BOOST_CHECK(xParallel.val.array.lparray[1].xltype == xltypeBool);
+    BOOST_CHECK(xParallel.val.array.lparray[0].xltype == xltypeErr);
+    freeOper(&xSerial);
+    freeOper(&xParallel);
+}
+
+void LoopTest::testScalar() {
+
+    BOOST_TEST_MESSAGE("Testing the parallel loop with a scalar input...");
+
+    ExcelEnvironment environment;
+    ExcelEmulator::Call call(1, 0, 0);
+    boost::shared_ptr<reposit::FunctionCall> functionCall(
+        new reposit::FunctionCall("loop", true));
+    Reciprocal reciprocal;
+
+    // A scalar is evaluated once on the calling thread, and a failure
+    // propagates to the caller rather than being logged per iteration.
+    OPER xIn;
+    xIn.xltype = xltypeNum;
+    xIn.val.num = 4;
+    XLOPER xOut;
+    reposit::loopParallel<Reciprocal, double, double>(functionCall, reciprocal, &xIn, xOut, 4);
+    BOOST_REQUIRE(xOut.xltype == xltypeNum);
+    BOOST_CHECK_EQUAL(xOut.val.num, 0.25);
+
+    xIn.val.num = 0;
+    BOOST_CHECK_THROW(
+        (reposit::loopParallel<Reciprocal, double, double>(functionCall, reciprocal, &xIn, xOut, 4)),
+        std::exception);
+
+    // A list is split into an array.
+    static char list[] = "\0051,2,4";
+    xIn.xltype = xltypeStr;
+    xIn.val.str = list;
+    reposit::loopParallel<Reciprocal, double, double>(functionCall, reciprocal, &xIn, xOut, 2);
+    BOOST_REQUIRE(xOut.xltype == (xltypeMulti | xlbitDLLFree));
+    BOOST_REQUIRE_EQUAL(xOut.val.array.rows * xOut.val.array.columns, 3);
+    BOOST_CHECK_EQUAL(xOut.val.array.lparray[2].val.num, 0.25);
+    freeOper(&xOut);
+}
+
+test_suite* LoopTest::suite() {
+    test_suite* suite = BOOST_TEST_SUITE("Loop tests");
+    suite->add(BOOST_TEST_CASE(&LoopTest::testParallel));
+    suite->add(BOOST_TEST_CASE(&LoopTest::testScalar));
+    return suite;
+}
+
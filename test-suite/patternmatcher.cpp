@@ -0,0 +1,202 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "patternmatcher.hpp"
+#include <rp/patternmatcher.hpp>
+#include <boost/regex.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using reposit::PatternMatcher;
+using namespace boost::unit_test_framework;
+
+namespace {
+
+    // Compare the result of the PatternMatcher with that of boost::regex,
+    // which reposit used before the introduction of PatternMatcher.
+    void checkPattern(const std::string &pattern, const std::vector<std::string> &values) {
+        boost::regex r(pattern, boost::regex::perl | boost::regex::icase);
+        PatternMatcher matcher(pattern);
+        for (std::vector<std::string>::const_iterator i = values.begin(); i != values.end(); ++i) {
+            bool expected = boost::regex_match(*i, r);
+            bool calculated = matcher.matches(*i);
+            if (calculated != expected)
+                BOOST_ERROR("pattern '" << pattern << "' applied to '" << *i << "'"
+                    << (matcher.simple() ? " as a glob" : " as a regex")
+                    << "\n    expected:   " << expected
+                    << "\n    calculated: " << calculated);
+        }
+    }
+
+    std::string randomString(const char *alphabet, std::size_t maxLength) {
+        std::size_t size = std::strlen(alphabet);
+        std::size_t length = std::rand() % (maxLength + 1);
+        std::string ret;
+        for (std::size_t i = 0; i < length; ++i)
+            ret += alphabet[std::rand() % size];
+        return ret;
+    }
+
+}
+
+void PatternMatcherTest::testSimplePatterns() {
+
+    BOOST_TEST_MESSAGE("Testing that common patterns are compiled to globs...");
+
+    const char *simple[] = { "EUR_.*", ".*\\.xml", "a.b", "a.+", ".*swap.*",
+                             "a\\-b", "\\(x\\)", "x\\.y\\.z" };
+    for (std::size_t i = 0; i < sizeof(simple)/sizeof(const char*); ++i) {
+        if (!PatternMatcher(simple[i]).simple())
+            BOOST_ERROR("pattern '" << simple[i] << "' not compiled to a glob");
+    }
+
+    const char *complex[] = { "a*", "a.?", "[ab]", "^a", "a|b", "(a)", "\\d+",
+                              "a{2}", ".*?", "a\\.?" };
+    for (std::size_t i = 0; i < sizeof(complex)/sizeof(const char*); ++i) {
+        if (PatternMatcher(complex[i]).simple())
+            BOOST_ERROR("pattern '" << complex[i] << "' wrongly compiled to a glob");
+    }
+
+    PatternMatcher matcher("eur_.*");
+    BOOST_CHECK(matcher.matches("EUR_SWAP"));
+    BOOST_CHECK(matcher.matches("eur_"));
+    BOOST_CHECK(!matcher.matches("USD_SWAP"));
+    BOOST_CHECK_EQUAL(matcher.prefix(), "EUR_");
+    BOOST_CHECK(PatternMatcher(".*").matchesAll());
+}
+
+void PatternMatcherTest::testEscapes() {
+
+    BOOST_TEST_MESSAGE("Testing that escapes with a special meaning use boost::regex...");
+
+    // Word boundaries and buffer anchors must not be taken as literals.
+    const char *patterns[] = { "\\<abc", "abc\\>", "\\`abc", "abc\\'", "\\Aabc",
+                               "\\babc", "a\\wc", "\\Qa.c\\E" };
+    const char *values[] = { "abc", "<abc", "abc>", "`abc", "abc'", "a.c", "ABC" };
+    std::vector<std::string> valueList(values, values + sizeof(values)/sizeof(const char*));
+    for (std::size_t i = 0; i < sizeof(patterns)/sizeof(const char*); ++i) {
+        if (PatternMatcher(patterns[i]).simple())
+            BOOST_ERROR("pattern '" << patterns[i] << "' wrongly compiled to a glob");
+        checkPattern(patterns[i], valueList);
+    }
+
+    BOOST_CHECK(PatternMatcher("\\<abc").matches("abc"));
+}
+
+void PatternMatcherTest::testEmptyPattern() {
+
+    BOOST_TEST_MESSAGE("Testing that an empty pattern matches only an empty string...");
+
+    PatternMatcher matcher("");
+    BOOST_CHECK(!matcher.matchesAll());
+    BOOST_CHECK(!matcher.matches("account.xml"));
+    std::vector<std::string> values;
+    values.push_back("");
+    values.push_back("account.xml");
+    checkPattern("", values);
+}
+
+void PatternMatcherTest::testAgainstRegex() {
+
+    BOOST_TEST_MESSAGE("Testing PatternMatcher against boost::regex on random patterns...");
+
+    const char *patternAlphabet = "aB.*+?\\<>`'-_{}()[]|^$1d";
+    const char *valueAlphabet = "abAB-_.<>`'1d";
+
+    std::srand(42);
+    std::vector<std::string> values;
+    for (int i = 0; i < 200; ++i)
+        values.push_back(randomString(valueAlphabet, 6));
+
+    int globs = 0;
+    for (int i = 0; i < 20000; ++i) {
+        std::string pattern = randomString(patternAlphabet, 6);
+        bool valid = true;
+        try {
+            boost::regex(pattern, boost::regex::perl | boost::regex::icase);
+        } catch (const std::exception&) {
+            valid = false;
+        }
+        if (!valid) {
+            BOOST_CHECK_THROW(PatternMatcher matcher(pattern), std::exception);
+            continue;
+        }
+        if (PatternMatcher(pattern).simple())
+            ++globs;
+        checkPattern(pattern, values);
+    }
+
+    // Make sure that the comparison exercised the glob path.
+    BOOST_CHECK(globs > 1000);
+}
+
+void PatternMatcherTest::testPrefix() {
+
+    BOOST_TEST_MESSAGE("Testing the literal prefix of a pattern...");
+
+    const char *patterns[][2] = {
+        { "EUR_SWAP_.*", "EUR_SWAP_" }, { "eur.*", "EUR" }, { "abc", "ABC" },
+        { "EUR\\.X.*", "EUR.X" }, { "EUR.5Y", "EUR" }, { ".*SWAP", "" },
+        { "", "" }, { "EUR_(SWAP|FRA)", "" }, { "EURX*", "" } };
+    for (std::size_t i = 0; i < sizeof(patterns)/sizeof(patterns[0]); ++i)
+        BOOST_CHECK_EQUAL(PatternMatcher(patterns[i][0]).prefix(), patterns[i][1]);
+    BOOST_CHECK(!PatternMatcher("EUR.*").matchesAll());
+    BOOST_CHECK(!PatternMatcher(".+").matchesAll());
+
+    // Every string which matches a pattern begins with its prefix.
+    const char *patternAlphabet = "aB.*+\\-_";
+    const char *valueAlphabet = "abAB-_";
+
+    std::srand(42);
+    std::vector<std::string> values;
+    for (int i = 0; i < 200; ++i)
+        values.push_back(randomString(valueAlphabet, 6));
+
+    for (int i = 0; i < 2000; ++i) {
+        std::string pattern = randomString(patternAlphabet, 6);
+        try {
+            boost::regex(pattern, boost::regex::perl | boost::regex::icase);
+        } catch (const std::exception&) {
+            continue;
+        }
+        PatternMatcher matcher(pattern);
+        const std::string prefix = matcher.prefix();
+        for (std::vector<std::string>::const_iterator j = values.begin(); j != values.end(); ++j) {
+            std::string value(*j);
+            std::transform(value.begin(), value.end(), value.begin(), ::toupper);
+            if (matcher.matches(*j) && value.compare(0, prefix.length(), prefix) != 0)
+                BOOST_ERROR("pattern '" << pattern << "' matches '" << *j
+                    << "' which does not begin with '" << prefix << "'");
+        }
+    }
+}
+
+test_suite* PatternMatcherTest::suite() {
+    test_suite* suite = BOOST_TEST_SUITE("PatternMatcher tests");
+    suite->add(BOOST_TEST_CASE(&PatternMatcherTest::testSimplePatterns));
+    suite->add(BOOST_TEST_CASE(&PatternMatcherTest::testEscapes));
+    suite->add(BOOST_TEST_CASE(&PatternMatcherTest::testEmptyPattern));
+    suite->add(BOOST_TEST_CASE(&PatternMatcherTest::testAgainstRegex));
+    suite->add(BOOST_TEST_CASE(&PatternMatcherTest::testPrefix));
+    return suite;
+}
+
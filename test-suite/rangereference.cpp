@@ -0,0 +1,192 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "rangereference.hpp"
+#include "excelutilities.hpp"
+#include <rpxl/rangereference.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/regex.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+using namespace RepositTest;
+using namespace boost::unit_test_framework;
+using reposit::RangeReference;
+
+namespace {
+
+    void checkReference(const std::string &address, const std::string &bookName,
+                        const std::string &sheetName, int rowStart, int colStart,
+                        int rowEnd, int colEnd) {
+        RangeReference r(address);
+        BOOST_CHECK_MESSAGE(r.bookName() == bookName,
+            address << ": book '" << r.bookName() << "' expected '" << bookName << "'");
+        BOOST_CHECK_MESSAGE(r.sheetName() == sheetName,
+            address << ": sheet '" << r.sheetName() << "' expected '" << sheetName << "'");
+        BOOST_CHECK_MESSAGE(r.rowStart() == rowStart && r.colStart() == colStart
+            && r.rowEnd() == rowEnd && r.colEnd() == colEnd,
+            address << ": parsed R" << r.rowStart() << "C" << r.colStart()
+            << ":R" << r.rowEnd() << "C" << r.colEnd());
+        BOOST_CHECK_EQUAL(r.multicell(), rowEnd != rowStart || colEnd != colStart);
+    }
+
+    // The regular expressions with which RangeReference parsed references
+    // before the introduction of the hand-written parser.
+    const boost::regex regexStandard(
+        "=?'?.*\\[([\\.\\w\\s-]+)(?:\\.XLS)?\\]([\\w\\s]+)'?!R(\\d*)C(\\d*)(?::R(\\d*)C(\\d*))?");
+    const boost::regex regexSpecial(
+        "=?'?([\\w\\s]+)(?:\\.XLS)'?!R(\\d*)C(\\d*)(?::R(\\d*)C(\\d*))?");
+
+    std::string randomString(const char *alphabet, std::size_t minLength, std::size_t maxLength) {
+        std::size_t size = std::strlen(alphabet);
+        std::size_t length = minLength + std::rand() % (maxLength - minLength + 1);
+        std::string ret;
+        for (std::size_t i = 0; i < length; ++i)
+            ret += alphabet[std::rand() % size];
+        return ret;
+    }
+
+    std::string randomCell() {
+        std::ostringstream s;
+        s << "R" << 1 + std::rand() % 1048576 << "C" << 1 + std::rand() % 16384;
+        return s.str();
+    }
+
+}
+
+void RangeReferenceTest::testFormats() {
+
+    BOOST_TEST_MESSAGE("Testing RangeReference on the formats returned by Excel...");
+
+    ExcelEnvironment environment;
+
+    checkReference("[Book1.xls]Sheet1!R1C1", "Book1.xls", "Sheet1", 1, 1, 1, 1);
+    checkReference("=[Book1.xls]Sheet1!R1C1", "Book1.xls", "Sheet1", 1, 1, 1, 1);
+    checkReference("'[Bo ok1.xls]Sheet1'!R1C1", "Bo ok1.xls", "Sheet1", 1, 1, 1, 1);
+    checkReference("'[Bo.ok1.xls]Sheet1'!R1C1", "Bo.ok1.xls", "Sheet1", 1, 1, 1, 1);
+    checkReference("[Book1]Sheet1!R1C1", "Book1", "Sheet1", 1, 1, 1, 1);
+    checkReference("[Book1]Sheet1!R2C3:R20C30", "Book1", "Sheet1", 2, 3, 20, 30);
+    checkReference("='C:\\path\\to\\[Book1.xls]Sheet1'!R1C1", "Book1.xls", "Sheet1", 1, 1, 1, 1);
+    checkReference("='C:\\pa[th]\\to\\[Book1.xls]Sheet1'!R1C1", "Book1.xls", "Sheet1", 1, 1, 1, 1);
+    checkReference("same_name.xls!R1C1", "same_name", "same_name", 1, 1, 1, 1);
+    checkReference("'same name.xls'!R1C1:R2C2", "same name", "same name", 1, 1, 2, 2);
+    checkReference("'[Book1.xls]1M (2)'!R4C1", "Book1.xls", "1M (2)", 4, 1, 4, 1);
+    checkReference("'[Book1.xls]Bob''s Sheet'!R4C1", "Book1.xls", "Bob's Sheet", 4, 1, 4, 1);
+    checkReference("'[Book1.xls]Sheet!1'!R4C1", "Book1.xls", "Sheet!1", 4, 1, 4, 1);
+    checkReference("[Book1]Sheet1!R1048576C16384", "Book1", "Sheet1", 1048576, 16384, 1048576, 16384);
+}
+
+void RangeReferenceTest::testInvalid() {
+
+    BOOST_TEST_MESSAGE("Testing that RangeReference rejects invalid references...");
+
+    ExcelEnvironment environment;
+
+    const char *invalid[] = { "", "R1C1", "!R1C1", "=!R1C1", "[Book1]Sheet1!",
+                              "[Book1]Sheet1!R1", "[Book1]Sheet1!C1", "[Book1]Sheet1!RC1",
+                              "[Book1]Sheet1!R1C", "[Book1]Sheet1!R1C1:", "[Book1]Sheet1!R1C1:R2",
+                              "[Book1]Sheet1!R1C1x", "[Book1]Sheet1!r1c1", "[Book1]!R1C1",
+                              "[]Sheet1!R1C1", "Book1]Sheet1!R1C1", "'[Book1]Sheet1!R1C1",
+                              "''!R1C1", "Sheet1!R1C1", ".xls!R1C1",
+                              "[Book1]Sheet1!R99999999999C1" };
+    for (std::size_t i = 0; i < sizeof(invalid)/sizeof(const char*); ++i)
+        BOOST_CHECK_THROW(RangeReference r(invalid[i]), std::exception);
+}
+
+void RangeReferenceTest::testContains() {
+
+    BOOST_TEST_MESSAGE("Testing RangeReference comparisons...");
+
+    ExcelEnvironment environment;
+
+    RangeReference range("[Book1]Sheet1!R2C2:R4C5");
+    BOOST_CHECK(range.contains(RangeReference("[Book1]Sheet1!R2C2")));
+    BOOST_CHECK(range.contains(RangeReference("[Book1]Sheet1!R4C5")));
+    BOOST_CHECK(range.contains(RangeReference("[Book1]Sheet1!R3C3:R4C5")));
+    BOOST_CHECK(range.contains(RangeReference("=[Book1]Sheet1!R2C2:R4C5")));
+    BOOST_CHECK(!range.contains(RangeReference("[Book1]Sheet1!R1C2")));
+    BOOST_CHECK(!range.contains(RangeReference("[Book1]Sheet1!R4C6")));
+    BOOST_CHECK(!range.contains(RangeReference("[Book1]Sheet1!R2C2:R5C5")));
+    BOOST_CHECK(!range.contains(RangeReference("[Book1]Sheet2!R2C2")));
+    BOOST_CHECK(!range.contains(RangeReference("[Book2]Sheet1!R2C2")));
+
+    RangeReference cell("[Book1]Sheet1!R2C2");
+    BOOST_CHECK(cell.contains(RangeReference("'[Book1]Sheet1'!R2C2")));
+    BOOST_CHECK(!cell.contains(RangeReference("[Book1]Sheet1!R2C3")));
+    BOOST_CHECK(!cell.contains(range));
+
+    BOOST_CHECK(RangeReference("=[Book1]Sheet1!R2C2:R4C5") == range);
+    BOOST_CHECK(!(RangeReference("[Book1]Sheet1!R2C2:R4C4") == range));
+}
+
+void RangeReferenceTest::testAgainstRegex() {
+
+    BOOST_TEST_MESSAGE("Testing RangeReference against the regular expressions it replaced...");
+
+    ExcelEnvironment environment;
+
+    // Generate the references which the regular expressions supported, in
+    // upper case as RepositoryXL passes them, and compare the results.
+    std::srand(42);
+    int compared = 0;
+    for (int i = 0; i < 20000; ++i) {
+        bool special = std::rand() % 4 == 0;
+        std::string name, address;
+        if (special) {
+            name = randomString("ABCXYZ019_ ", 1, 12) + ".XLS";
+        } else {
+            name = (std::rand() % 2 ? randomString("C:\\PATH", 0, 8) : std::string())
+                + "[" + randomString("ABCXYZ019_ .-", 1, 12) + (std::rand() % 2 ? ".XLS" : "")
+                + "]" + randomString("ABCXYZ019_ ", 1, 12);
+        }
+        if (name.find_first_of(" .") != std::string::npos)
+            name = "'" + name + "'";
+        address = (std::rand() % 2 ? "=" : "") + name + "!" + randomCell();
+        if (std::rand() % 2)
+            address += ":" + randomCell();
+
+        boost::smatch m;
+        if (!boost::regex_match(address, m, special ? regexSpecial : regexStandard))
+            continue;
+        std::size_t offset = special ? 0 : 1;
+        std::string bookName = m[1];
+        std::string sheetName = special ? bookName : std::string(m[2]);
+        int rowStart = boost::lexical_cast<int>(m[2 + offset]);
+        int colStart = boost::lexical_cast<int>(m[3 + offset]);
+        int rowEnd = m[4 + offset].matched ? boost::lexical_cast<int>(m[4 + offset]) : rowStart;
+        int colEnd = m[5 + offset].matched ? boost::lexical_cast<int>(m[5 + offset]) : colStart;
+        BOOST_REQUIRE_NO_THROW(RangeReference r(address));
+        checkReference(address, bookName, sheetName, rowStart, colStart, rowEnd, colEnd);
+        ++compared;
+    }
+
+    // Make sure that most of the generated references were compared.
+    BOOST_CHECK(compared > 15000);
+}
+
+test_suite* RangeReferenceTest::suite() {
+    test_suite* suite = BOOST_TEST_SUITE("RangeReference tests");
+    suite->add(BOOST_TEST_CASE(&RangeReferenceTest::testFormats));
+    suite->add(BOOST_TEST_CASE(&RangeReferenceTest::testInvalid));
+    suite->add(BOOST_TEST_CASE(&RangeReferenceTest::testContains));
+    suite->add(BOOST_TEST_CASE(&RangeReferenceTest::testAgainstRegex));
+    return suite;
+}
+
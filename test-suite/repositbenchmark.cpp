@@ -0,0 +1,853 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*  Micro-benchmarks of the operations whose performance reposit relies on.
+
+    Usage: repositbenchmark [name ...]
+
+    With no arguments every benchmark is run, otherwise only those named.
+    Each benchmark reports the time per operation of the current code and,
+    where there is one, of the naive alternative which it replaced.
+*/
+
+#include "excelutilities.hpp"
+#include "utilities.hpp"
+#include <rp/patternmatcher.hpp>
+#include <rp/objectwrapper.hpp>
+#include <rpxl/callingrange.hpp>
+#include <rpxl/functioncall.hpp>
+#include <rpxl/rangereference.hpp>
+#include <rpxl/conversions/vectortooper.hpp>
+#include <rpxl/conversions/opertomatrix.hpp>
+#include <rpxl/loop.hpp>
+#include <rpxl/utilities/xlutilities.hpp>
+#include <boost/regex.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <cstring>
+
+using namespace RepositTest;
+
+namespace {
+
+    // Wall clock time elapsed since construction.
+    class Timer {
+    public:
+        Timer() : start_(boost::posix_time::microsec_clock::universal_time()) {}
+        double elapsed() const {
+            return (boost::posix_time::microsec_clock::universal_time()
+                - start_).total_microseconds() / 1.0e6;
+        }
+    private:
+        boost::posix_time::ptime start_;
+    };
+
+    // Discard the output written to std::cout during the lifetime of this
+    // object, i.e. the error messages logged when built without Boost.Log.
+    class Silence {
+    public:
+        Silence() : buffer_(std::cout.rdbuf(stream_.rdbuf())) {}
+        ~Silence() { std::cout.rdbuf(buffer_); }
+    private:
+        std::ostringstream stream_;
+        std::streambuf *buffer_;
+    };
+
+    void report(const std::string &description, std::size_t operations, double seconds) {
+        std::cout << "    " << std::left << std::setw(48) << description
+                  << std::right << std::setw(10) << operations << " ops "
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(10) << seconds * 1.0e6 / operations << " us/op"
+                  << std::endl;
+    }
+
+    std::string objectID(const std::string &prefix, std::size_t i) {
+        std::ostringstream s;
+        s << prefix << std::setw(7) << std::setfill('0') << i;
+        return s.str();
+    }
+
+    // Matching of file names and object IDs against the patterns typical of
+    // loadObject() and listObjectIDs().
+    void patternMatcher() {
+        const std::size_t N = 100000;
+        std::vector<std::string> values;
+        for (std::size_t i = 0; i < N; ++i)
+            values.push_back(objectID(i % 2 ? "EUR_SWAP_" : "usd_depo_", i) + ".xml");
+
+        const char *patterns[] = { "EUR_.*", ".*\\.xml", ".*SWAP.*" };
+        for (std::size_t p = 0; p < sizeof(patterns)/sizeof(const char*); ++p) {
+            std::size_t hits = 0;
+            Timer t1;
+            reposit::PatternMatcher matcher(patterns[p]);
+            for (std::size_t i = 0; i < N; ++i)
+                hits += matcher.matches(values[i]);
+            report(std::string("PatternMatcher ") + patterns[p], N, t1.elapsed());
+
+            std::size_t regexHits = 0;
+            Timer t2;
+            boost::regex r(patterns[p], boost::regex::perl | boost::regex::icase);
+            for (std::size_t i = 0; i < N; ++i)
+                regexHits += boost::regex_match(values[i], r);
+            report(std::string("boost::regex   ") + patterns[p], N, t2.elapsed());
+
+            if (hits != regexHits)
+                std::cout << "    error: results differ" << std::endl;
+        }
+    }
+
+    // Scan of a directory tree of 100,000 files for the files to be
+    // deserialized.  The write times of the directories are set back, as for
+    // a tree written before the session, so that the cache may trust them.
+    void scanDirectory() {
+        const std::size_t N = 100000;
+        Environment environment;
+        SerializationFactory &factory =
+            dynamic_cast<SerializationFactory&>(reposit::SerializationFactory::instance());
+
+        boost::filesystem::path root = boost::filesystem::temp_directory_path()
+            / boost::filesystem::unique_path("repositbenchmark-%%%%-%%%%");
+        for (std::size_t d = 0; d < 10; ++d) {
+            boost::filesystem::path directory = root / objectID("dir", d);
+            boost::filesystem::create_directories(directory);
+            for (std::size_t i = 0; i < N / 10; ++i)
+                std::ofstream((directory / (objectID("object", i)
+                    + (i % 10 ? ".txt" : ".xml"))).string().c_str());
+            boost::filesystem::last_write_time(directory, std::time(0) - 10);
+        }
+        boost::filesystem::last_write_time(root, std::time(0) - 10);
+
+        Timer t1;
+        std::size_t files = factory.scan(root.string(), ".*\\.xml", true).size();
+        report("scanDirectory .*\\.xml", N, t1.elapsed());
+
+        factory.setCacheDirectoryScans(true);
+        factory.scan(root.string(), ".*\\.xml", true);
+        Timer t2;
+        files += factory.scan(root.string(), ".*\\.xml", true).size();
+        report("scanDirectory .*\\.xml, cached", N, t2.elapsed());
+
+        boost::filesystem::remove_all(root);
+        if (files != N / 5)
+            std::cout << "    error: found " << files << " files" << std::endl;
+    }
+
+    // Calculation of a column of cells each of which constructs an object, with
+    // rpxl calling back into the Excel emulator.  The first calculation names
+    // the calling ranges, later ones replace the objects in place, finding
+    // the calling ranges by the identity of the caller.
+    void recalculation() {
+        const std::size_t N = 10000;
+        ExcelEnvironment environment;
+
+        Timer t1;
+        for (std::size_t i = 0; i < N; ++i)
+            callNode(1, i, 0, objectID("node", i), i);
+        report("first calculation", N, t1.elapsed());
+
+        environment.excel().reset();
+        Timer t2;
+        for (std::size_t i = 0; i < N; ++i)
+            callNode(1, i, 0, objectID("node", i), i);
+        report("recalculation", N, t2.elapsed());
+        std::cout << "    Excel callbacks per recalculated cell: "
+                  << static_cast<double>(environment.excel().calls()) / N
+                  << ", of which xlfReftext and xlfGetDef: "
+                  << static_cast<double>(environment.excel().calls(xlfReftext)
+                                         + environment.excel().calls(xlfGetDef)) / N << std::endl;
+
+        environment.excel().deleteRange(1, 0, 0, N, 1);
+        Timer t3;
+        reposit::RepositoryXL::instance().collectGarbage();
+        report("collectGarbage, all ranges orphaned", N, t3.elapsed());
+
+        if (reposit::RepositoryXL::instance().objectCount())
+            std::cout << "    error: objects remain after garbage collection" << std::endl;
+    }
+
+    // Successful calls of a function which reads an object, with the Excel
+    // callbacks made per call.  The FunctionCall constructor calls xlfCaller
+    // only, and fetches the reference text of the caller on demand, which
+    // the constructor previously did on every call.
+    void functionCall() {
+        const std::size_t N = 100000;
+        ExcelEnvironment environment;
+        callNode(1, 0, 1, "node", 1);
+
+        environment.excel().reset();
+        std::size_t failed = 0;
+        Timer t1;
+        for (std::size_t i = 0; i < N; ++i)
+            failed += !callNodeTotal(1, i % 1000, 0, 1, 1, "node");
+        report("xlNodeTotal", N, t1.elapsed());
+        std::cout << "    Excel callbacks per call: "
+                  << static_cast<double>(environment.excel().calls()) / N
+                  << ", of which xlfReftext: "
+                  << static_cast<double>(environment.excel().calls(xlfReftext)) / N << std::endl;
+
+        Timer t2;
+        for (std::size_t i = 0; i < N; ++i) {
+            ExcelEmulator::Call call(1, i % 1000, 0);
+            reposit::FunctionCall functionCall("functionCall");
+        }
+        report("FunctionCall", N, t2.elapsed());
+
+        Timer t3;
+        for (std::size_t i = 0; i < N; ++i) {
+            ExcelEmulator::Call call(1, i % 1000, 0);
+            reposit::FunctionCall functionCall("functionCall");
+            functionCall.refStr();
+        }
+        report("FunctionCall, xlfReftext on every call", N, t3.elapsed());
+
+        if (failed)
+            std::cout << "    error: " << failed << " calls failed" << std::endl;
+    }
+
+    // The first calculation of a column of cells each of which constructs an
+    // object, with the hidden names of the calling ranges created as each
+    // range is constructed, or deferred and created together afterwards.
+    void deferredNames() {
+        const std::size_t N = 10000;
+        for (int defer = 0; defer < 2; ++defer) {
+            ExcelEnvironment environment;
+            reposit::CallingRange::setDeferNames(defer != 0);
+            std::string mode = defer ? ", deferred" : "";
+
+            Timer t1;
+            for (std::size_t i = 0; i < N; ++i)
+                callNode(1, i, 0, objectID("node", i), i);
+            report("first calculation" + mode, N, t1.elapsed());
+            long calculationCalls = environment.excel().calls(xlfSetName);
+
+            environment.excel().reset();
+            Timer t2;
+            reposit::CallingRange::flushNames();
+            if (defer)
+                report("flushNames", N, t2.elapsed());
+            std::cout << "    xlfSetName calls during calculation: " << calculationCalls
+                      << ", on flush: " << environment.excel().calls(xlfSetName) << std::endl;
+
+            reposit::CallingRange::setDeferNames(false);
+            if (environment.excel().nameCount() != N)
+                std::cout << "    error: " << environment.excel().nameCount() << " names" << std::endl;
+        }
+    }
+
+    // Repeated construction and deletion of a sheet of calling ranges, as in
+    // a long session which rebuilds its sheets.  The keys of the deleted
+    // ranges are recycled, so the key numbers stay below the sheet size.
+    void churn() {
+        const std::size_t N = 10000, M = 20;
+        ExcelEnvironment environment;
+        std::size_t maxIndex = 0;
+
+        Timer t;
+        for (std::size_t j = 0; j < M; ++j) {
+            for (std::size_t i = 0; i < N; ++i)
+                callNode(1, i, 0, objectID("node", i), i);
+            std::size_t index;
+            if (reposit::CallingRange::parseKey(reposit::RepositoryXL::instance().callerKey(
+                std::vector<std::string>(1, objectID("node", N - 1)))[0], index))
+                maxIndex = std::max(maxIndex, index);
+            environment.excel().deleteRange(1, 0, 0, N, 1);
+            reposit::RepositoryXL::instance().collectGarbage();
+        }
+        report("create and delete calling range", N * M, t.elapsed());
+
+        if (maxIndex >= 2 * N)
+            std::cout << "    error: keys were not recycled" << std::endl;
+    }
+
+    // Construction and destruction of ObjectWrappers, as done by the
+    // Repository on every store and delete.
+    void allocation() {
+        const std::size_t N = 200000;
+        Environment environment;
+        boost::shared_ptr<reposit::Object> object = makeNode("node");
+        std::vector<boost::shared_ptr<reposit::ObjectWrapper> > wrappers(N);
+
+        Timer t1;
+        for (std::size_t i = 0; i < N; ++i)
+            wrappers[i] = boost::allocate_shared<reposit::ObjectWrapper>(
+                reposit::Allocator<reposit::ObjectWrapper>::type(), object);
+        wrappers.assign(N, boost::shared_ptr<reposit::ObjectWrapper>());
+        report("allocate_shared ObjectWrapper", N, t1.elapsed());
+
+        Timer t2;
+        for (std::size_t i = 0; i < N; ++i)
+            wrappers[i] = boost::shared_ptr<reposit::ObjectWrapper>(
+                new reposit::ObjectWrapper(object));
+        wrappers.assign(N, boost::shared_ptr<reposit::ObjectWrapper>());
+        report("shared_ptr(new ObjectWrapper)", N, t2.elapsed());
+
+        Timer t3;
+        for (std::size_t i = 0; i < N; ++i)
+            storeNode("node", i, std::vector<std::string>(), true);
+        report("storeObject, overwrite", N, t3.elapsed());
+
+        Timer t4;
+        for (std::size_t i = 0; i < N; ++i) {
+            reposit::Repository::instance().deleteObject("node");
+            storeNode("node", i);
+        }
+        report("deleteObject and storeObject", N, t4.elapsed());
+    }
+
+    // Throughput of storeObject(), which timestamps each ObjectWrapper with
+    // getTick().  The cost of getTime(), which was called instead before
+    // the introduction of the tick, is shown for comparison.
+    void timestamps() {
+        const std::size_t N = 200000;
+        Environment environment;
+        std::vector<std::string> ids;
+        ids.reserve(N);
+        for (std::size_t i = 0; i < N; ++i)
+            ids.push_back(objectID("node", i));
+
+        double sum = 0;
+        Timer t1;
+        for (std::size_t i = 0; i < N; ++i)
+            sum += reposit::getTime();
+        report("getTime", N, t1.elapsed());
+
+        reposit::Tick ticks = 0;
+        Timer t2;
+        for (std::size_t i = 0; i < N; ++i)
+            ticks += reposit::getTick();
+        report("getTick", N, t2.elapsed());
+
+        Timer t3;
+        for (std::size_t i = 0; i < N; ++i)
+            storeNode(ids[i], i);
+        report("storeObject, new IDs", N, t3.elapsed());
+
+        Timer t4;
+        for (std::size_t i = 0; i < N; ++i)
+            storeNode(ids[i], i, std::vector<std::string>(), true);
+        report("storeObject, overwrite", N, t4.elapsed());
+
+        if (sum <= 0 || !ticks)
+            std::cout << "    error: no time read" << std::endl;
+    }
+
+    // Deletion of a large graph of objects, with and without deferred
+    // destruction, and the reclamation of the deferred objects in slices.
+    void deferredDestruction() {
+        const std::size_t N = 100000;
+        Environment environment;
+        reposit::Repository &repository = reposit::Repository::instance();
+
+        for (std::size_t i = 0; i < N; ++i)
+            storeNode(objectID("node", i), i);
+        Timer t1;
+        repository.deleteAllObjects();
+        report("deleteAllObjects", N, t1.elapsed());
+
+        repository.setDeferredDestruction(true);
+        for (std::size_t i = 0; i < N; ++i)
+            storeNode(objectID("node", i), i);
+        Timer t2;
+        repository.deleteAllObjects();
+        report("deleteAllObjects, deferred", N, t2.elapsed());
+
+        Timer t3;
+        std::size_t slices = 0;
+        while (repository.reclaimObjects(1000))
+            ++slices;
+        report("reclaimObjects, slices of 1000", N, t3.elapsed());
+        repository.setDeferredDestruction(false);
+
+        if (slices != N / 1000 - 1)
+            std::cout << "    error: " << slices << " slices" << std::endl;
+    }
+
+    // Deletion of the transient objects from a Repository holding many
+    // permanent ones, as when a workbook is recalculated from scratch.  The
+    // permanent objects are not visited.
+    void permanent() {
+        const std::size_t N = 100000, M = 1000, R = 20;
+        Environment environment;
+        reposit::Repository &repository = reposit::Repository::instance();
+        for (std::size_t i = 0; i < N; ++i)
+            storeNode(objectID("permanent", i), i, std::vector<std::string>(), false, true);
+
+        double seconds = 0;
+        for (std::size_t j = 0; j < R; ++j) {
+            for (std::size_t i = 0; i < M; ++i)
+                storeNode(objectID("transient", i), i);
+            Timer t;
+            repository.deleteAllObjects();
+            seconds += t.elapsed();
+        }
+        std::ostringstream s;
+        s << "deleteAllObjects, " << M << " of " << N + M << " transient";
+        report(s.str(), M * R, seconds);
+
+        if (repository.objectCount() != static_cast<int>(N))
+            std::cout << "    error: permanent objects deleted" << std::endl;
+    }
+
+    // Listing the IDs which match a pattern with a literal prefix, as a
+    // sheet does when it repeatedly lists the objects of one family.
+    void listObjectIDs() {
+        const std::size_t N = 100000, R = 100;
+        const char *prefixes[] = { "EUR_SWAP_", "USD_SWAP_", "EUR_DEPO_", "GBP_SWAP_" };
+        Environment environment;
+        reposit::Repository &repository = reposit::Repository::instance();
+        for (std::size_t i = 0; i < N; ++i)
+            storeNode(objectID(prefixes[i % 4], i));
+        const std::string pattern("EUR_SWAP_.*");
+
+        std::size_t count = 0;
+        Timer t1;
+        for (std::size_t j = 0; j < R; ++j)
+            count += repository.listObjectIDs(pattern).size();
+        report("listObjectIDs " + pattern, R, t1.elapsed());
+
+        // Compiling the pattern on each call and visiting every ID, as
+        // before the prefix and the cache.
+        std::size_t naive = 0;
+        Timer t2;
+        for (std::size_t j = 0; j < R; ++j) {
+            boost::regex r(pattern, boost::regex::perl | boost::regex::icase);
+            std::vector<std::string> objectIDs = repository.listObjectIDs();
+            for (std::size_t i = 0; i < objectIDs.size(); ++i)
+                naive += boost::regex_match(objectIDs[i], r);
+        }
+        report("boost::regex over every ID", R, t2.elapsed());
+
+        if (count != naive || count != R * N / 4)
+            std::cout << "    error: results differ" << std::endl;
+    }
+
+    // Listing and counting the objects of one class in a Repository holding
+    // many classes, by the class index and by visiting every object.
+    void classIndex() {
+        const std::size_t N = 100000, C = 100, R = 10;
+        Environment environment;
+        reposit::Repository &repository = reposit::Repository::instance();
+        for (std::size_t i = 0; i < N; ++i)
+            storeNode(objectID("node", i), i, std::vector<std::string>(), false, false,
+                      objectID("Class", i % C));
+        const std::string className = objectID("Class", 0);
+
+        std::size_t count = 0;
+        Timer t1;
+        for (std::size_t j = 0; j < R; ++j)
+            count += repository.listObjectIDsByClass(className).size();
+        report("listObjectIDsByClass, 1 class of 100", R, t1.elapsed());
+
+        // The filtering of the full list, which was required without the index.
+        std::size_t naive = 0;
+        Timer t2;
+        for (std::size_t j = 0; j < R; ++j) {
+            std::vector<std::string> objectIDs = repository.listObjectIDs();
+            std::vector<std::string> classNames = repository.className(objectIDs);
+            naive += std::count(classNames.begin(), classNames.end(), className);
+        }
+        report("listObjectIDs and className", R, t2.elapsed());
+
+        if (count != naive || count != R * N / C)
+            std::cout << "    error: " << count << " objects of class "
+                      << className << std::endl;
+    }
+
+    // Retrieval of the dependents of an object in a tree of objects, each
+    // with ten dependents, by the dependent index and by visiting the
+    // precedents of every object.
+    void dependentIDs() {
+        const std::size_t N = 100000, M = 1000, R = 10;
+        Environment environment;
+        reposit::Repository &repository = reposit::Repository::instance();
+        storeNode(objectID("node", 0));
+        for (std::size_t i = 1; i < N; ++i)
+            storeNode(objectID("node", i), i, ids(objectID("node", (i - 1) / 10)));
+
+        std::size_t count = 0;
+        Timer t1;
+        for (std::size_t i = 0; i < M; ++i)
+            count += repository.dependentIDs(objectID("node", i)).size();
+        report("dependentIDs", M, t1.elapsed());
+
+        Timer t2;
+        std::size_t transitive = repository.dependentIDs(objectID("node", 0), true).size();
+        report("dependentIDs, transitive", transitive, t2.elapsed());
+
+        // The scan of the whole Repository, which was required without the index.
+        std::size_t naive = 0;
+        std::vector<std::string> objectIDs = repository.listObjectIDs();
+        Timer t3;
+        for (std::size_t i = 0; i < R; ++i) {
+            const std::string id = objectID("node", i);
+            for (std::size_t j = 0; j < objectIDs.size(); ++j) {
+                std::vector<std::string> precedents = repository.precedentIDs(objectIDs[j]);
+                naive += std::count(precedents.begin(), precedents.end(), id);
+            }
+        }
+        report("precedentIDs of every object", R, t3.elapsed());
+
+        if (count != M * 10 || transitive != N - 1 || naive != R * 10)
+            std::cout << "    error: " << count << " dependents" << std::endl;
+    }
+
+    // Rendering of the full ID, suffixed with the update count, which is
+    // returned to the calling cell each time an object is stored.
+    void updateID() {
+        const std::size_t N = 1000000;
+        ExcelEnvironment environment;
+        ExcelEmulator::Call call(1, 0, 0);
+        reposit::FunctionCall functionCall("updateID");
+        reposit::CallingRange callingRange;
+        const std::string id("EUR_SWAP_5Y");
+        std::string idFull;
+
+        std::size_t length = 0;
+        Timer t1;
+        for (std::size_t i = 0; i < N; ++i) {
+            callingRange.updateID(id, idFull);
+            length += idFull.length();
+        }
+        report("CallingRange::updateID", N, t1.elapsed());
+
+        // The formatting used before the count was rendered in place.
+        int count = 0;
+        Timer t2;
+        for (std::size_t i = 0; i < N; ++i) {
+            if (count > 9999) count = 0;
+            std::ostringstream s;
+            s << std::setw(4) << std::setfill('0') << count++;
+            idFull = id + '#' + s.str();
+            length -= idFull.length();
+        }
+        report("std::ostringstream", N, t2.elapsed());
+
+        if (length)
+            std::cout << "    error: results differ" << std::endl;
+    }
+
+    // Return of a column of object IDs to Excel, as by ohRepositoryListObjectIDs,
+    // and its release by xlAutoFree.
+    void stringArray() {
+        const std::size_t N = 1000, M = 200;
+        ExcelEnvironment environment;
+        ExcelEmulator::Call call(1, 0, 0, N, 1);
+        reposit::FunctionCall functionCall("stringArray");
+        std::vector<std::string> ids;
+        for (std::size_t i = 0; i < N; ++i)
+            ids.push_back(objectID("EUR_SWAP_", i));
+
+        Timer t1;
+        for (std::size_t j = 0; j < M; ++j) {
+            OPER xVector;
+            reposit::vectorToOper(ids, xVector);
+            freeOper(&xVector);
+        }
+        report("vectorToOper, single block", N * M, t1.elapsed());
+
+        // The allocation of one string per element which the block replaced.
+        Timer t2;
+        for (std::size_t j = 0; j < M; ++j) {
+            OPER xVector;
+            reposit::setVectorDimensions(N, xVector);
+            xVector.val.array.lparray = new OPER[N];
+            xVector.xltype = xltypeMulti | xlbitDLLFree;
+            for (std::size_t i = 0; i < N; ++i)
+                reposit::scalarToOper(ids[i], xVector.val.array.lparray[i], false);
+            freeOper(&xVector);
+        }
+        report("vectorToOper, string per element", N * M, t2.elapsed());
+    }
+
+    // Conversion of numeric ranges of increasing size to matrices, as for the
+    // inputs of the generated addin functions, by operToMatrix() and by the
+    // conversion of each element through ConvertOper which it replaced.
+    void operArray() {
+        const int sizes[] = { 100, 300, 1000 };
+        ExcelEnvironment environment;
+        for (std::size_t k = 0; k < sizeof(sizes) / sizeof(int); ++k) {
+            const int N = sizes[k];
+            const std::size_t M = 1000000 / (N * N) + 1;
+            std::vector<OPER> values(N * N);
+            for (int i = 0; i < N * N; ++i) {
+                values[i].xltype = xltypeNum;
+                values[i].val.num = i;
+            }
+            OPER xMatrix;
+            xMatrix.xltype = xltypeMulti;
+            xMatrix.val.array.rows = N;
+            xMatrix.val.array.columns = N;
+            xMatrix.val.array.lparray = &values[0];
+
+            double sum = 0;
+            Timer t1;
+            for (std::size_t j = 0; j < M; ++j)
+                sum += reposit::operToMatrix<double>(xMatrix, "matrix")[N - 1][N - 1];
+            std::ostringstream s1;
+            s1 << "operToMatrix, " << N << "x" << N;
+            report(s1.str(), N * N * M, t1.elapsed());
+
+            double elementSum = 0;
+            Timer t2;
+            for (std::size_t j = 0; j < M; ++j) {
+                std::vector<std::vector<double> > ret;
+                ret.reserve(N);
+                for (int r = 0; r < N; ++r) {
+                    std::vector<double> row;
+                    row.reserve(N);
+                    for (int c = 0; c < N; ++c)
+                        row.push_back(reposit::convert<double>(reposit::ConvertOper(values[r * N + c])));
+                    ret.push_back(row);
+                }
+                elementSum += ret[N - 1][N - 1];
+            }
+            std::ostringstream s2;
+            s2 << "ConvertOper per element, " << N << "x" << N;
+            report(s2.str(), N * N * M, t2.elapsed());
+
+            if (sum != elementSum)
+                std::cout << "    error: results differ" << std::endl;
+        }
+    }
+
+    // Transfer of a million cells in a single call through the XLOPER12
+    // conversions, which the Excel 97 grid would have split across 16 calls.
+    void largeGrid() {
+        const int N = 1000000;
+        ExcelEnvironment environment;
+        ExcelEmulator::Call call(1, 0, 0, N, 1);
+        reposit::FunctionCall functionCall("largeGrid");
+
+        std::vector<double> values(N);
+        for (int i = 0; i < N; ++i)
+            values[i] = i;
+        Timer t1;
+        OPER12 xNumbers;
+        reposit::vectorToOper(values, xNumbers);
+        report("vectorToOper, OPER12 numbers", N, t1.elapsed());
+
+        xNumbers.val.array.rows = 1000;
+        xNumbers.val.array.columns = 1000;
+        Timer t2;
+        std::vector<std::vector<double> > m = reposit::operToMatrix<double>(xNumbers, "matrix");
+        report("operToMatrix, OPER12 1000x1000", N, t2.elapsed());
+        freeOper(&xNumbers);
+
+        std::vector<std::string> ids;
+        ids.reserve(N);
+        for (int i = 0; i < N; ++i)
+            ids.push_back(objectID("EUR_SWAP_", i));
+        Timer t3;
+        OPER12 xStrings;
+        reposit::vectorToOper(ids, xStrings);
+        double seconds = t3.elapsed();
+        freeOper(&xStrings);
+        report("vectorToOper, OPER12 strings", N, seconds);
+
+        if (m[999][999] != N - 1)
+            std::cout << "    error: results differ" << std::endl;
+    }
+
+    // A loop function of the cost of a simple pricing, for the loop benchmark.
+    struct Discount {
+        double operator()(const double &t) {
+            double df = 1;
+            for (int i = 0; i < 2000; ++i)
+                df *= std::exp(-0.0001 * t);
+            return df;
+        }
+    };
+
+    // Evaluation of a loop function across a column of inputs, serially by
+    // loop() and on several threads by loopParallel().
+    void loop() {
+        const int N = 10000;
+        ExcelEnvironment environment;
+        std::vector<OPER> values(N);
+        for (int i = 0; i < N; ++i) {
+            values[i].xltype = xltypeNum;
+            values[i].val.num = i % 30;
+        }
+        OPER xIn;
+        xIn.xltype = xltypeMulti;
+        xIn.val.array.rows = N;
+        xIn.val.array.columns = 1;
+        xIn.val.array.lparray = &values[0];
+
+        ExcelEmulator::Call call(1, 0, 0, N, 1);
+        boost::shared_ptr<reposit::FunctionCall> functionCall(
+            new reposit::FunctionCall("loop", true));
+        Discount discount;
+
+        XLOPER xSerial, xParallel;
+        Timer t1;
+        reposit::loop<Discount, double, double>(functionCall, discount, &xIn, xSerial);
+        report("loop", N, t1.elapsed());
+
+        // At least four threads, so that the cost of the threads shows on a
+        // single processor.
+        unsigned int threads = std::max(4u, boost::thread::hardware_concurrency());
+        Timer t2;
+        reposit::loopParallel<Discount, double, double>(functionCall, discount, &xIn, xParallel, threads);
+        std::ostringstream s;
+        s << "loopParallel, " << threads << " threads";
+        report(s.str(), N, t2.elapsed());
+
+        for (int i = 0; i < N; ++i) {
+            if (xSerial.val.array.lparray[i].val.num != xParallel.val.array.lparray[i].val.num) {
+                std::cout << "    error: results differ" << std::endl;
+                break;
+            }
+        }
+        freeOper(&xSerial);
+        freeOper(&xParallel);
+    }
+
+    // Parsing of the references returned by xlfReftext, as done for every
+    // error logged and every call to retrieveError().
+    void rangeReference() {
+        const std::size_t N = 100000;
+        ExcelEnvironment environment;
+        std::vector<std::string> addresses;
+        for (std::size_t i = 0; i < N; ++i) {
+            std::ostringstream s;
+            s << (i % 2 ? "'[BOOK 1.XLSX]SHEET1'!R" : "[BOOK1]SHEET1!R") << i + 1 << "C" << i % 100 + 1;
+            if (i % 3 == 0)
+                s << ":R" << i + 10 << "C" << i % 100 + 5;
+            addresses.push_back(s.str());
+        }
+
+        long sum = 0;
+        Timer t1;
+        for (std::size_t i = 0; i < N; ++i)
+            sum += reposit::RangeReference(addresses[i]).rowEnd();
+        report("RangeReference", N, t1.elapsed());
+
+        // The regular expression which RangeReference used before the
+        // introduction of the hand-written parser.
+        long regexSum = 0;
+        Timer t2;
+        boost::regex r("=?'?.*\\[([\\.\\w\\s-]+)(?:\\.XLS)?\\]([\\w\\s]+)'?!"
+                       "R(\\d*)C(\\d*)(?::R(\\d*)C(\\d*))?");
+        for (std::size_t i = 0; i < N; ++i) {
+            boost::smatch m;
+            if (boost::regex_match(addresses[i], m, r))
+                regexSum += boost::lexical_cast<int>(m[5].matched ? m[5] : m[3]);
+        }
+        report("boost::regex", N, t2.elapsed());
+
+        if (sum != regexSum)
+            std::cout << "    error: results differ" << std::endl;
+    }
+
+    // Lookup of the error logged against a cell, with errors outstanding in
+    // many ranges, as when a precedent of a large sheet fails.
+    void errors() {
+        const std::size_t N = 10000;
+        ExcelEnvironment environment;
+        callNode(1, 0, 5, "node");
+
+        // Errors in two column ranges per row band, each 3 rows high.
+        double seconds;
+        {
+            Silence silence;
+            Timer t1;
+            for (std::size_t i = 0; i < N; ++i)
+                callNodeTotal(1, (i / 2) * 3, (i % 2) * 2, 3, 2, "missing");
+            seconds = t1.elapsed();
+        }
+        report("logError", N, seconds);
+
+        std::size_t found = 0;
+        Timer t2;
+        for (std::size_t i = 0; i < N; ++i)
+            found += !retrieveError(1, (i / 2) * 3 + 2, (i % 2) * 2 + 1).empty();
+        report("retrieveError, cell within range", N, t2.elapsed());
+
+        Timer t3;
+        for (std::size_t i = 0; i < N; ++i)
+            found += !retrieveError(1, i, 4).empty();
+        report("retrieveError, no error", N, t3.elapsed());
+
+        Timer t4;
+        for (std::size_t i = 0; i < N; ++i)
+            callNodeTotal(1, (i / 2) * 3, (i % 2) * 2, 3, 2, "node");
+        report("clearError", N, t4.elapsed());
+
+        if (found != N)
+            std::cout << "    error: found " << found << " errors" << std::endl;
+    }
+
+    struct Benchmark {
+        const char *name;
+        void (*run)();
+    };
+
+    const Benchmark benchmarks[] = {
+        { "patternmatcher", patternMatcher },
+        { "scandirectory", scanDirectory },
+        { "recalculation", recalculation },
+        { "functioncall", functionCall },
+        { "deferrednames", deferredNames },
+        { "churn", churn },
+        { "allocation", allocation },
+        { "timestamps", timestamps },
+        { "deferreddestruction", deferredDestruction },
+        { "permanent", permanent },
+        { "listobjectids", listObjectIDs },
+        { "classindex", classIndex },
+        { "dependentids", dependentIDs },
+        { "updateid", updateID },
+        { "stringarray", stringArray },
+        { "loop", loop },
+        { "operarray", operArray },
+        { "largegrid", largeGrid },
+        { "rangereference", rangeReference },
+        { "errors", errors }
+    };
+
+}
+
+int main(int argc, char *argv[]) {
+
+    try {
+        for (std::size_t i = 0; i < sizeof(benchmarks)/sizeof(Benchmark); ++i) {
+            bool selected = argc < 2;
+            for (int j = 1; j < argc; ++j)
+                selected = selected || !std::strcmp(argv[j], benchmarks[i].name);
+            if (!selected)
+                continue;
+            std::cout << benchmarks[i].name << ":" << std::endl;
+            benchmarks[i].run();
+        }
+        return 0;
+    } catch (const std::exception &e) {
+        std::cout << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
+
@@ -0,0 +1,48 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include <boost/test/included/unit_test.hpp>
+
+#include "callingrange.hpp"
+#include "conversions.hpp"
+#include "loop.hpp"
+#include "patternmatcher.hpp"
+#include "rangereference.hpp"
+#include "repository.hpp"
+#include "repositoryxl.hpp"
+#include "serializationfactory.hpp"
+
+using boost::unit_test_framework::test_suite;
+
+test_suite* init_unit_test_suite(int, char* []) {
+
+    test_suite* test = BOOST_TEST_SUITE("reposit test suite");
+
+    test->add(CallingRangeTest::suite());
+    test->add(ConversionsTest::suite());
+    test->add(LoopTest::suite());
+    test->add(PatternMatcherTest::suite());
+    test->add(RangeReferenceTest::suite());
+    test->add(RepositoryTest::suite());
+    test->add(RepositoryXLTest::suite());
+    test->add(SerializationFactoryTest::suite());
+
+    return test;
+}
+
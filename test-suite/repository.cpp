@@ -0,0 +1,565 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "repository.hpp"
+#include "utilities.hpp"
+#include <rp/repository.hpp>
+#include <rp/objectwrapper.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+using namespace RepositTest;
+using namespace boost::unit_test_framework;
+using reposit::Repository;
+
+namespace {
+
+    bool exists(const std::string &objectID) {
+        return Repository::instance().objectExists(ids(objectID))[0];
+    }
+
+    // An item of a batch for storeObjects().  The precedents are recorded in
+    // the ValueObject but not retrieved, so that they need not exist yet.
+    reposit::StoreItem item(const std::string &objectID, long value,
+                            const std::string &precedents = "") {
+        boost::shared_ptr<reposit::ValueObject> valueObject(
+            new NodeValueObject(objectID, value, ids(precedents), false));
+        boost::shared_ptr<reposit::Object> object(new NodeObject(
+            valueObject, value, std::vector<boost::shared_ptr<NodeObject> >(), false));
+        return reposit::StoreItem(objectID, object, valueObject);
+    }
+
+    long total(const std::string &objectID) {
+        boost::shared_ptr<NodeObject> node;
+        Repository::instance().retrieveObject(node, objectID);
+        return node->total();
+    }
+
+    // Restore a Node as does a load with overwrite, return the stored Object.
+    boost::shared_ptr<reposit::Object> restore(const std::string &objectID, long value,
+                                               const std::string &precedents = "",
+                                               bool permanent = false,
+                                               const std::string &className = "Node") {
+        boost::shared_ptr<reposit::ValueObject> valueObject(
+            new NodeValueObject(objectID, value, ids(precedents), permanent, className));
+        return reposit::SerializationFactory::instance().restoreObject(valueObject, true).second;
+    }
+
+    boost::shared_ptr<reposit::Object> retrieve(const std::string &objectID) {
+        boost::shared_ptr<reposit::Object> object;
+        Repository::instance().retrieveObject(object, objectID);
+        return object;
+    }
+
+    // Retrieve an Object under shared access, as do concurrent readers.
+    class Reader {
+    public:
+        Reader(const std::string &objectID, long &total)
+            : objectID_(objectID), total_(total) {}
+        void operator()() {
+            reposit::RepositoryReadLock lock;
+            total_ = total(objectID_);
+        }
+    private:
+        std::string objectID_;
+        long &total_;
+    };
+
+}
+
+void RepositoryTest::testStoreObject() {
+
+    BOOST_TEST_MESSAGE("Testing storage, retrieval and deletion of objects...");
+
+    Environment environment;
+
+    boost::shared_ptr<reposit::Object> object = makeNode("a", 1);
+    boost::weak_ptr<reposit::Object> weak(object);
+    BOOST_CHECK_EQUAL(Repository::instance().storeObject("a", object), "a");
+    object.reset();
+
+    // Case preserving retrieval.
+    boost::shared_ptr<NodeObject> node;
+    Repository::instance().retrieveObject(node, "A");
+    BOOST_CHECK_EQUAL(node->total(), 1);
+    node.reset();
+
+    BOOST_CHECK_THROW(storeNode("A", 2), std::exception);
+    storeNode("A", 2, std::vector<std::string>(), true);
+    BOOST_CHECK_EQUAL(Repository::instance().objectCount(), 1);
+    // The ID keeps the case in which it was first stored.
+    BOOST_CHECK_EQUAL(Repository::instance().listObjectIDs()[0], "a");
+    // The overwritten object was released along with its wrapper's reference.
+    BOOST_CHECK(weak.expired());
+
+    Repository::instance().retrieveObject(node, "a");
+    BOOST_CHECK_EQUAL(node->total(), 2);
+    weak = node;
+    node.reset();
+
+    Repository::instance().deleteObject("a");
+    BOOST_CHECK(!exists("a"));
+    BOOST_CHECK(weak.expired());
+    BOOST_CHECK_THROW(Repository::instance().retrieveObject(node, "a"), std::exception);
+
+    // Repeated store and delete, recycling the allocator's blocks.
+    for (int i = 0; i <= 1000; ++i) {
+        storeNode("b", i, std::vector<std::string>(), true);
+        if (i % 3 == 0)
+            Repository::instance().deleteObject("b");
+    }
+    Repository::instance().retrieveObject(node, "b");
+    BOOST_CHECK_EQUAL(node->total(), 1000);
+}
+
+void RepositoryTest::testStoreObjects() {
+
+    BOOST_TEST_MESSAGE("Testing storage of a batch of objects...");
+
+    Environment environment;
+
+    // Items may precede their precedents.
+    std::vector<reposit::StoreItem> items;
+    items.push_back(item("c", 3, "b"));
+    items.push_back(item("b", 2, "a"));
+    items.push_back(item("a", 1));
+    BOOST_CHECK_EQUAL(join(Repository::instance().storeObjects(items)), "c,b,a");
+    BOOST_CHECK_EQUAL(join(Repository::instance().precedentIDs("c")), "b");
+    BOOST_CHECK_EQUAL(join(Repository::instance().dependentIDs("a", true)), "b,c");
+
+    // Each item was registered as an observer of its precedents.
+    storeNode("a", 10, std::vector<std::string>(), true);
+    long creatorCalls = SerializationFactory::creatorCalls();
+    BOOST_CHECK_EQUAL(total("b"), 12);
+    BOOST_CHECK_EQUAL(SerializationFactory::creatorCalls() - creatorCalls, 1);
+
+    // A batch which would overwrite an existing object is rejected as a whole.
+    items.clear();
+    items.push_back(item("d", 4));
+    items.push_back(item("A", 5));
+    BOOST_CHECK_THROW(Repository::instance().storeObjects(items), std::exception);
+    BOOST_CHECK(!exists("d"));
+    BOOST_CHECK_EQUAL(total("a"), 10);
+
+    // So is a batch in which a precedent is neither in the batch nor stored.
+    items.clear();
+    items.push_back(item("d", 4, "a"));
+    items.push_back(item("f", 6, "d,x"));
+    items.push_back(item("g", 7, "d"));
+    BOOST_CHECK_THROW(Repository::instance().storeObjects(items), std::exception);
+    BOOST_CHECK(!exists("d"));
+    BOOST_CHECK(!exists("f"));
+    BOOST_CHECK(!exists("g"));
+    BOOST_CHECK_EQUAL(join(Repository::instance().dependentIDs("a", true)), "b,c");
+
+    // So is a batch in which an ID occurs more than once, unless overwrite
+    // is true in which case the last occurrence wins.
+    items.clear();
+    items.push_back(item("e", 1));
+    items.push_back(item("d", 4));
+    items.push_back(item("E", 2));
+    BOOST_CHECK_THROW(Repository::instance().storeObjects(items), std::exception);
+    BOOST_CHECK(!exists("d"));
+    BOOST_CHECK(!exists("e"));
+    BOOST_CHECK_EQUAL(join(Repository::instance().storeObjects(items, true)), "e,d,E");
+    BOOST_CHECK_EQUAL(total("e"), 2);
+    BOOST_CHECK_EQUAL(Repository::instance().objectCount(), 5);
+}
+
+void RepositoryTest::testRecreateChain() {
+
+    BOOST_TEST_MESSAGE("Testing the recreation of a chain of dirty objects...");
+
+    Environment environment;
+
+    storeNode("a", 1);
+    storeNode("b", 2, ids("a"));
+    storeNode("c", 3, ids("b"));
+
+    // Recreating c retrieves b, which is itself dirty and must be recreated
+    // by the same thread, which already holds the lock.
+    storeNode("a", 10, std::vector<std::string>(), true);
+    long creatorCalls = SerializationFactory::creatorCalls();
+    BOOST_CHECK_EQUAL(total("c"), 15);
+    BOOST_CHECK_EQUAL(SerializationFactory::creatorCalls() - creatorCalls, 2);
+    BOOST_CHECK_EQUAL(total("c"), 15);
+    BOOST_CHECK_EQUAL(SerializationFactory::creatorCalls() - creatorCalls, 2);
+
+    // Concurrent readers recreate each dirty object once.
+    storeNode("a", 20, std::vector<std::string>(), true);
+    creatorCalls = SerializationFactory::creatorCalls();
+    const int threadCount = 8;
+    std::vector<long> totals(threadCount);
+    boost::thread_group threads;
+    for (int i = 0; i < threadCount; ++i)
+        threads.create_thread(Reader(i % 2 ? "c" : "b", totals[i]));
+    threads.join_all();
+    for (int i = 0; i < threadCount; ++i)
+        BOOST_CHECK_EQUAL(totals[i], i % 2 ? 25 : 22);
+    BOOST_CHECK_EQUAL(SerializationFactory::creatorCalls() - creatorCalls, 2);
+}
+
+void RepositoryTest::testDeferredDestruction() {
+
+    BOOST_TEST_MESSAGE("Testing deferred destruction of deleted objects...");
+
+    Environment environment;
+    Repository &repository = Repository::instance();
+
+    storeNode("a", 1);
+    storeNode("b", 2);
+    storeNode("c", 3);
+    boost::shared_ptr<NodeObject> node;
+    repository.retrieveObject(node, "a");
+    boost::weak_ptr<NodeObject> weak(node);
+    node.reset();
+
+    // The deletion is visible at once, the destruction happens on reclamation.
+    repository.setDeferredDestruction(true);
+    BOOST_CHECK(repository.deferredDestruction());
+    repository.deleteObject("a");
+    BOOST_CHECK(!exists("a"));
+    BOOST_CHECK(!weak.expired());
+
+    // The ID may be reused while the old object awaits destruction.
+    storeNode("a", 10);
+    BOOST_CHECK_EQUAL(total("a"), 10);
+    BOOST_CHECK_EQUAL(repository.reclaimObjects(), 0u);
+    BOOST_CHECK(weak.expired());
+    BOOST_CHECK_EQUAL(total("a"), 10);
+
+    // Reclamation in slices.
+    repository.deleteAllObjects();
+    BOOST_CHECK_EQUAL(repository.objectCount(), 0);
+    BOOST_CHECK_EQUAL(repository.reclaimObjects(1), 2u);
+    BOOST_CHECK_EQUAL(repository.reclaimObjects(5), 0u);
+    BOOST_CHECK_EQUAL(repository.reclaimObjects(), 0u);
+
+    // Disabling deferral destroys whatever remains.
+    storeNode("d", 4);
+    repository.retrieveObject(node, "d");
+    weak = node;
+    node.reset();
+    repository.deleteObject("d");
+    BOOST_CHECK(!weak.expired());
+    repository.setDeferredDestruction(false);
+    BOOST_CHECK(weak.expired());
+
+    // The reclamation thread takes exclusive access for each slice.
+    repository.setDeferredDestruction(true);
+    for (int i = 0; i < 1000; ++i)
+        storeNode("e" + boost::lexical_cast<std::string>(i), i);
+    repository.retrieveObject(node, "e999");
+    weak = node;
+    node.reset();
+    repository.startReclamationThread(100);
+    {
+        reposit::RepositoryWriteLock lock;
+        repository.deleteAllObjects();
+    }
+    for (int i = 0; i < 500 && !weak.expired(); ++i)
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    BOOST_CHECK(weak.expired());
+    repository.stopReclamationThread();
+    BOOST_CHECK_EQUAL(repository.reclaimObjects(), 0u);
+
+    // The thread may be stopped by a caller holding exclusive access while
+    // the thread is waiting for it.
+    for (int i = 0; i < 10; ++i)
+        storeNode("f" + boost::lexical_cast<std::string>(i), i);
+    repository.startReclamationThread(1);
+    {
+        reposit::RepositoryWriteLock lock;
+        repository.deleteAllObjects();
+        boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+        repository.stopReclamationThread();
+        BOOST_CHECK_EQUAL(repository.reclaimObjects(), 0u);
+    }
+    repository.startReclamationThread(1);
+    {
+        reposit::RepositoryWriteLock lock;
+        storeNode("g", 1);
+        repository.deleteObject("g");
+        boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+        repository.setDeferredDestruction(false);
+    }
+    BOOST_CHECK_EQUAL(repository.reclaimObjects(), 0u);
+}
+
+void RepositoryTest::testPermanentObjects() {
+
+    BOOST_TEST_MESSAGE("Testing the deletion of transient and permanent objects...");
+
+    Environment environment;
+    Repository &repository = Repository::instance();
+
+    std::vector<std::string> none;
+    storeNode("p1", 1, none, false, true);
+    storeNode("t1", 2);
+    storeNode("p2", 3, none, false, true);
+    storeNode("t2", 4);
+    repository.deleteAllObjects();
+    BOOST_CHECK_EQUAL(join(repository.listObjectIDs()), "p1,p2");
+
+    // A deleted permanent object leaves the index consistent.
+    repository.deleteObject("p1");
+    storeNode("t3", 5);
+    repository.deleteAllObjects();
+    BOOST_CHECK_EQUAL(join(repository.listObjectIDs()), "p2");
+
+    // Overwriting an object may change its permanence.
+    storeNode("p2", 6, none, true, false);
+    storeNode("t4", 7);
+    storeNode("t4", 8, none, true, true);
+    repository.deleteAllObjects();
+    BOOST_CHECK_EQUAL(join(repository.listObjectIDs()), "t4");
+    BOOST_CHECK_EQUAL(total("t4"), 8);
+
+    // As may a batch.
+    std::vector<reposit::StoreItem> items;
+    items.push_back(reposit::StoreItem("t5", makeNode("t5", 9)));
+    items.push_back(reposit::StoreItem("t4", makeNode("t4", 10)));
+    items.push_back(reposit::StoreItem("p3", makeNode("p3", 11, none, true)));
+    repository.storeObjects(items, true);
+    repository.deleteAllObjects();
+    BOOST_CHECK_EQUAL(join(repository.listObjectIDs()), "p3");
+
+    repository.deleteAllObjects(true);
+    BOOST_CHECK_EQUAL(repository.objectCount(), 0);
+}
+
+void RepositoryTest::testListObjectIDs() {
+
+    BOOST_TEST_MESSAGE("Testing the listing of object IDs by pattern...");
+
+    Environment environment;
+    Repository &repository = Repository::instance();
+
+    const char *objectIDs[] = { "EUR_SWAP_1", "eur_swap_2", "EUR_SWAP", "EUR_FRA_1",
+                                "EURX", "USD_SWAP_1", "_EUR_SWAP_1", "a" };
+    for (std::size_t i = 0; i < sizeof(objectIDs)/sizeof(const char*); ++i)
+        storeNode(objectIDs[i]);
+
+    // A pattern with a literal prefix visits only the IDs which begin with
+    // it, case insensitively, and returns the same result as a full scan.
+    BOOST_CHECK_EQUAL(join(repository.listObjectIDs("EUR_SWAP_.*")), "EUR_SWAP_1,eur_swap_2");
+    BOOST_CHECK_EQUAL(join(repository.listObjectIDs("eur_swap.*")), "EUR_SWAP,EUR_SWAP_1,eur_swap_2");
+    BOOST_CHECK_EQUAL(join(repository.listObjectIDs("EUR_.*_1")), "EUR_FRA_1,EUR_SWAP_1");
+    BOOST_CHECK_EQUAL(join(repository.listObjectIDs("EURX")), "EURX");
+    BOOST_CHECK_EQUAL(join(repository.listObjectIDs("a.*")), "a");
+    BOOST_CHECK(repository.listObjectIDs("GBP.*").empty());
+    BOOST_CHECK(repository.listObjectIDs("z.*").empty());
+    BOOST_CHECK_EQUAL(join(repository.listObjectIDs(".*SWAP_1")), "EUR_SWAP_1,USD_SWAP_1,_EUR_SWAP_1");
+    BOOST_CHECK_EQUAL(join(repository.listObjectIDs("(EUR|USD)_SWAP_1")), "EUR_SWAP_1,USD_SWAP_1");
+    BOOST_CHECK_EQUAL(repository.listObjectIDs(".*").size(), 8u);
+    BOOST_CHECK_EQUAL(repository.listObjectIDs().size(), 8u);
+
+    // Compiled patterns are cached.  A cached pattern sees the current
+    // contents of the Repository, and the cache survives being emptied.
+    storeNode("EUR_SWAP_3");
+    BOOST_CHECK_EQUAL(join(repository.listObjectIDs("EUR_SWAP_.*")), "EUR_SWAP_1,eur_swap_2,EUR_SWAP_3");
+    for (int i = 0; i < 200; ++i)
+        repository.listObjectIDs("EUR_SWAP_" + boost::lexical_cast<std::string>(i));
+    BOOST_CHECK_EQUAL(join(repository.listObjectIDs("EUR_SWAP_.*")), "EUR_SWAP_1,eur_swap_2,EUR_SWAP_3");
+    BOOST_CHECK_EQUAL(join(repository.listObjectIDsByClass("Node", "EUR_SWAP_.*")), "EUR_SWAP_1,eur_swap_2,EUR_SWAP_3");
+
+    // An invalid pattern is not cached, and fails every time.
+    BOOST_CHECK_THROW(repository.listObjectIDs("EUR("), std::exception);
+    BOOST_CHECK_THROW(repository.listObjectIDs("EUR("), std::exception);
+}
+
+void RepositoryTest::testClassIndex() {
+
+    BOOST_TEST_MESSAGE("Testing the index of objects by class name...");
+
+    Environment environment;
+    Repository &repository = Repository::instance();
+
+    std::vector<std::string> none;
+    storeNode("curve2", 1, none, false, false, "Curve");
+    storeNode("swap1", 2, none, false, false, "Swap");
+    storeNode("Curve1", 3, none, false, false, "Curve");
+    storeNode("node1", 4);
+    BOOST_CHECK_EQUAL(join(repository.listClassNames()), "Curve,Node,Swap");
+
+    // Class names are case insensitive.
+    BOOST_CHECK_EQUAL(repository.objectCount("CURVE"), 2);
+    BOOST_CHECK_EQUAL(join(repository.listObjectIDsByClass("curve")), "Curve1,curve2");
+    BOOST_CHECK_EQUAL(join(repository.listObjectIDsByClass("Curve", ".*2")), "curve2");
+    BOOST_CHECK_EQUAL(repository.objectCount("Bond"), 0);
+    BOOST_CHECK(repository.listObjectIDsByClass("Bond").empty());
+
+    // Overwriting an object may change its class.
+    storeNode("swap1", 5, none, true, false, "Curve");
+    BOOST_CHECK_EQUAL(join(repository.listClassNames()), "Curve,Node");
+    BOOST_CHECK_EQUAL(join(repository.listObjectIDsByClass("Curve")), "Curve1,curve2,swap1");
+
+    // A class is dropped with its last object.
+    repository.deleteObject("node1");
+    BOOST_CHECK_EQUAL(join(repository.listClassNames()), "Curve");
+    BOOST_CHECK_EQUAL(repository.objectCount("Node"), 0);
+
+    // As are all of them with a batch.
+    std::vector<reposit::StoreItem> items;
+    items.push_back(reposit::StoreItem("swap2", makeNode("swap2", 6, none, false, "Swap")));
+    items.push_back(reposit::StoreItem("curve2", makeNode("curve2", 7, none, false, "Node")));
+    repository.storeObjects(items, true);
+    BOOST_CHECK_EQUAL(join(repository.listClassNames()), "Curve,Node,Swap");
+    BOOST_CHECK_EQUAL(repository.objectCount("Curve"), 2);
+
+    repository.deleteAllObjects();
+    BOOST_CHECK(repository.listClassNames().empty());
+    BOOST_CHECK_EQUAL(repository.objectCount("Curve"), 0);
+}
+
+void RepositoryTest::testDependentIDs() {
+
+    BOOST_TEST_MESSAGE("Testing the index of dependent objects...");
+
+    Environment environment;
+    Repository &repository = Repository::instance();
+
+    storeNode("a", 1);
+    storeNode("b", 2, ids("a"));
+    storeNode("c", 3, ids("A,b"));
+    storeNode("d", 4, ids("c"));
+    BOOST_CHECK_EQUAL(join(repository.dependentIDs("a")), "b,c");
+    BOOST_CHECK_EQUAL(join(repository.dependentIDs("A", true)), "b,c,d");
+    BOOST_CHECK_EQUAL(join(repository.dependentIDs("b", true)), "c,d");
+    BOOST_CHECK(repository.dependentIDs("d", true).empty());
+    BOOST_CHECK_THROW(repository.dependentIDs("e"), std::exception);
+
+    // Overwriting an object replaces its precedents.
+    storeNode("c", 5, ids("b"), true);
+    BOOST_CHECK_EQUAL(join(repository.dependentIDs("a")), "b");
+    BOOST_CHECK_EQUAL(join(repository.dependentIDs("a", true)), "b,c,d");
+
+    // Deleting an object removes it from the dependents of its precedents,
+    // while its own dependents remain indexed under its ID.
+    repository.deleteObject("d");
+    BOOST_CHECK(repository.dependentIDs("c").empty());
+    repository.deleteObject("b");
+    storeNode("b", 6);
+    BOOST_CHECK(repository.dependentIDs("a").empty());
+    BOOST_CHECK_EQUAL(join(repository.dependentIDs("b")), "c");
+
+    // A cycle is visited once.
+    std::vector<reposit::StoreItem> items;
+    items.push_back(item("x", 1, "y"));
+    items.push_back(item("y", 2, "x"));
+    repository.storeObjects(items);
+    BOOST_CHECK_EQUAL(join(repository.dependentIDs("x", true)), "x,y");
+
+    repository.deleteAllObjects();
+    storeNode("a", 7);
+    BOOST_CHECK(repository.dependentIDs("a", true).empty());
+}
+
+void RepositoryTest::testTimestamps() {
+
+    BOOST_TEST_MESSAGE("Testing the timestamps of ObjectWrapper...");
+
+    Environment environment;
+
+    // The times converted from the monotonic tick agree with the wall clock
+    // to within a second, and advance with each reset() and recreate().
+    const double tolerance = 1.0 / (24 * 60 * 60);
+    reposit::ObjectWrapper wrapper(makeNode("a", 1));
+    double creationTime = wrapper.creationTime();
+    BOOST_CHECK_SMALL(creationTime - reposit::getTime(), tolerance);
+    BOOST_CHECK_EQUAL(wrapper.updateTime(), creationTime);
+
+    double updateTime = creationTime;
+    for (int i = 0; i < 4; ++i) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(2));
+        if (i % 2)
+            wrapper.recreate();
+        else
+            wrapper.reset(makeNode("a", i));
+        BOOST_CHECK_GT(wrapper.updateTime(), updateTime);
+        BOOST_CHECK_SMALL(wrapper.updateTime() - reposit::getTime(), tolerance);
+        BOOST_CHECK_EQUAL(wrapper.creationTime(), creationTime);
+        updateTime = wrapper.updateTime();
+    }
+}
+
+void RepositoryTest::testRestoreUnchanged() {
+
+    BOOST_TEST_MESSAGE("Testing the reload of objects which have not changed...");
+
+    Environment environment;
+    const reposit::SerializationFactory &factory = reposit::SerializationFactory::instance();
+
+    restore("a", 1);
+    restore("b", 2, "a");
+    BOOST_CHECK_EQUAL(total("b"), 3);
+
+    // Reloading identical inputs keeps the same instance, and the dependent
+    // is not marked dirty so it is not recreated on retrieval.
+    boost::shared_ptr<reposit::Object> a = retrieve("a");
+    int skipped = factory.skippedObjectCount();
+    long creatorCalls = SerializationFactory::creatorCalls();
+    BOOST_CHECK(restore("a", 1) == a);
+    BOOST_CHECK(retrieve("a") == a);
+    BOOST_CHECK_EQUAL(factory.skippedObjectCount() - skipped, 1);
+    BOOST_CHECK_EQUAL(total("b"), 3);
+    BOOST_CHECK_EQUAL(SerializationFactory::creatorCalls() - creatorCalls, 0);
+
+    // A changed property forces recreation, and the dependent follows.
+    skipped = factory.skippedObjectCount();
+    creatorCalls = SerializationFactory::creatorCalls();
+    BOOST_CHECK(restore("a", 10) != a);
+    BOOST_CHECK_EQUAL(factory.skippedObjectCount() - skipped, 0);
+    BOOST_CHECK_EQUAL(total("b"), 12);
+    BOOST_CHECK_EQUAL(SerializationFactory::creatorCalls() - creatorCalls, 2);
+
+    // So does a changed class name.
+    a = retrieve("a");
+    BOOST_CHECK(restore("a", 10, "", false, "Curve") != a);
+    BOOST_CHECK_EQUAL(join(Repository::instance().listObjectIDsByClass("Curve")), "a");
+    BOOST_CHECK_EQUAL(factory.skippedObjectCount() - skipped, 0);
+
+    // And a changed permanent flag.
+    a = retrieve("a");
+    BOOST_CHECK(restore("a", 10, "", true, "Curve") != a);
+    BOOST_CHECK(retrieve("a")->permanent());
+    BOOST_CHECK_EQUAL(factory.skippedObjectCount() - skipped, 0);
+
+    a = retrieve("a");
+    BOOST_CHECK(restore("a", 10, "", true, "Curve") == a);
+    BOOST_CHECK_EQUAL(factory.skippedObjectCount() - skipped, 1);
+}
+
+test_suite* RepositoryTest::suite() {
+    test_suite* suite = BOOST_TEST_SUITE("Repository tests");
+    suite->add(BOOST_TEST_CASE(&RepositoryTest::testStoreObject));
+    suite->add(BOOST_TEST_CASE(&RepositoryTest::testStoreObjects));
+    suite->add(BOOST_TEST_CASE(&RepositoryTest::testRecreateChain));
+    suite->add(BOOST_TEST_CASE(&RepositoryTest::testDeferredDestruction));
+    suite->add(BOOST_TEST_CASE(&RepositoryTest::testPermanentObjects));
+    suite->add(BOOST_TEST_CASE(&RepositoryTest::testListObjectIDs));
+    suite->add(BOOST_TEST_CASE(&RepositoryTest::testClassIndex));
+    suite->add(BOOST_TEST_CASE(&RepositoryTest::testDependentIDs));
+    suite->add(BOOST_TEST_CASE(&RepositoryTest::testTimestamps));
+    suite->add(BOOST_TEST_CASE(&RepositoryTest::testRestoreUnchanged));
+    return suite;
+}
+
@@ -0,0 +1,751 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "repositoryxl.hpp"
+#include "excelutilities.hpp"
+#include <rpxl/functioncall.hpp>
+#include <rpxl/convert_oper.hpp>
+#include <rpxl/xloper.hpp>
+#include <rpxl/utilities/xlutilities.hpp>
+#include <xlsdk/xlsdkdefines.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+using namespace RepositTest;
+using namespace boost::unit_test_framework;
+using reposit::RepositoryXL;
+
+// Addin functions registered as thread safe.
+extern "C" {
+    OPER *ohObjectExists(OPER *ObjectID, OPER *Trigger);
+    OPER *ohObjectPropertyValues(char *ObjectId, OPER *PropertyName, OPER *Trigger);
+    OPER *ohRepositoryListObjectIDs(char *Regex, OPER *Trigger);
+    OPER12 *ohRepositoryListObjectIDs12(char *Regex, OPER *Trigger);
+}
+
+namespace {
+
+    bool exists(const std::string &objectID) {
+        return RepositoryXL::instance().objectExists(ids(objectID))[0];
+    }
+
+    // The first element of an array, or the value itself if not an array.
+    const OPER &first(const OPER &x) {
+        return (x.xltype & xltypeMulti) ? x.val.array.lparray[0] : x;
+    }
+
+    // The results of the calls made by one thread of testConcurrentReaders().
+    struct ReaderResults {
+        ReaderResults() : exists(0), values(0), listed(0), failures(0) {}
+        int exists, values, listed, failures;
+    };
+
+    // Call the thread safe addin functions from the formulas in the given
+    // row, as Excel does during multi-threaded recalculation.  The calls
+    // from column 1 refer to an object which does not exist.
+    class ConcurrentReader {
+    public:
+        ConcurrentReader(int row, int passes, ReaderResults &results)
+            : row_(row), passes_(passes), results_(results) {}
+        void operator()() {
+            OPER xMissing;
+            xMissing.xltype = xltypeMissing;
+            char objectID[] = "c", missingID[] = "missing", regex[] = "";
+            for (int i = 0; i < passes_; ++i) {
+                {
+                    ExcelEmulator::Call call(1, row_, 0, 1, 1, true);
+                    OPER *xRet = ohObjectExists(TempStrStl("c"), &xMissing);
+                    if (xRet && first(*xRet).xltype == xltypeBool && first(*xRet).val.xbool)
+                        ++results_.exists;
+                    if (xRet) freeOper(xRet);
+                    xRet = ohObjectPropertyValues(objectID, TempStrStl("VALUE"), &xMissing);
+                    if (xRet && first(*xRet).xltype == xltypeNum && first(*xRet).val.num == 3)
+                        ++results_.values;
+                    if (xRet) freeOper(xRet);
+                    xRet = ohRepositoryListObjectIDs(regex, &xMissing);
+                    if (xRet && (xRet->xltype & xltypeMulti)
+                        && xRet->val.array.rows * xRet->val.array.columns == 3)
+                        ++results_.listed;
+                    if (xRet) freeOper(xRet);
+                }
+                {
+                    ExcelEmulator::Call call(1, row_, 1, 1, 1, true);
+                    if (!ohObjectPropertyValues(missingID, TempStrStl("VALUE"), &xMissing))
+                        ++results_.failures;
+                }
+            }
+        }
+    private:
+        int row_, passes_;
+        ReaderResults &results_;
+    };
+
+    // Check that every value returned by Excel has been passed to xlFree.
+    void checkMemory(const ExcelEmulator &excel) {
+        BOOST_CHECK_EQUAL(excel.allocations(), 0u);
+        BOOST_CHECK_EQUAL(excel.invalidFrees(), 0);
+    }
+
+}
+
+void RepositoryXLTest::testFunctionCall() {
+
+    BOOST_TEST_MESSAGE("Testing FunctionCall against the Excel emulator...");
+
+    ExcelEnvironment environment;
+
+    {
+        ExcelEmulator::Call call(1, 1, 2);
+        reposit::FunctionCall functionCall("test");
+        BOOST_CHECK(functionCall.callerType() == reposit::CallerType::Cell);
+        reposit::CallerId callerId;
+        BOOST_REQUIRE(functionCall.callerId(callerId));
+        BOOST_CHECK_EQUAL(callerId.idSheet, 1u);
+        BOOST_CHECK_EQUAL(callerId.ref.rwFirst, 1);
+        BOOST_CHECK_EQUAL(callerId.ref.colFirst, 2);
+        BOOST_CHECK_EQUAL(functionCall.refStr(), "[Book1]Sheet1!R2C3");
+        BOOST_CHECK_EQUAL(functionCall.addressString(), "[Book1]Sheet1!R2C3");
+        BOOST_CHECK(functionCall.callerDimensions() == reposit::CallerDimensions::Column);
+    }
+
+    {
+        ExcelEmulator::Call call(1, 0, 0, 1, 3);
+        reposit::FunctionCall functionCall("test");
+        BOOST_CHECK_EQUAL(functionCall.refStr(), "[Book1]Sheet1!R1C1:R1C3");
+        BOOST_CHECK(functionCall.callerDimensions() == reposit::CallerDimensions::Row);
+    }
+
+    {
+        ExcelEmulator::Call call;
+        reposit::FunctionCall functionCall("test");
+        BOOST_CHECK(functionCall.callerType() == reposit::CallerType::VBA);
+        reposit::CallerId callerId;
+        BOOST_CHECK(!functionCall.callerId(callerId));
+        BOOST_CHECK(functionCall.refStr().empty());
+    }
+
+    checkMemory(environment.excel());
+}
+
+void RepositoryXLTest::testStoreObject() {
+
+    BOOST_TEST_MESSAGE("Testing RepositoryXL::storeObject against the Excel emulator...");
+
+    ExcelEnvironment environment;
+
+    // Each recalculation of the cell increments the update count.
+    BOOST_CHECK_EQUAL(callNode(1, 0, 0, "a", 1), "a#0000");
+    BOOST_CHECK_EQUAL(callNode(1, 0, 0, "a", 1), "a#0001");
+    BOOST_CHECK_EQUAL(callNode(1, 1, 0, "b", 2, "a#0001"), "b#0000");
+    BOOST_CHECK_EQUAL(environment.excel().nameCount(), 2u);
+    BOOST_CHECK_EQUAL(environment.excel().nameReference(
+        RepositoryXL::instance().callerKey(ids("a"))[0]), "[Book1]Sheet1!R1C1");
+
+    {
+        ExcelEmulator::Call call(1, 2, 0);
+        char id[] = "b";
+        double *total = xlNodeTotal(id);
+        BOOST_REQUIRE(total);
+        BOOST_CHECK_EQUAL(*total, 3);
+    }
+
+    // An anonymous object is named after its calling range.
+    std::string anonymous = callNode(1, 3, 0, "");
+    BOOST_CHECK_EQUAL(anonymous.substr(0, 4), "obj_");
+    BOOST_CHECK(exists(anonymous.substr(0, anonymous.find('#'))));
+
+    checkMemory(environment.excel());
+}
+
+void RepositoryXLTest::testStoreObjects() {
+
+    BOOST_TEST_MESSAGE("Testing RepositoryXL::storeObjects against the Excel emulator...");
+
+    ExcelEnvironment environment;
+
+    callNode(1, 0, 0, "a", 1);
+
+    std::vector<reposit::StoreItem> items;
+    items.push_back(reposit::StoreItem("b", makeNode("b", 2)));
+    items.push_back(reposit::StoreItem("c", makeNode("c", 3)));
+    items.push_back(reposit::StoreItem("B", makeNode("B", 4)));
+
+    ExcelEmulator::Call call(1, 1, 0);
+    reposit::FunctionCall functionCall("test");
+
+    // An ID which occurs more than once is rejected unless overwrite is true.
+    BOOST_CHECK_THROW(RepositoryXL::instance().storeObjects(items), std::exception);
+    BOOST_CHECK(!exists("b"));
+    BOOST_CHECK(!exists("c"));
+
+    // Otherwise the last occurrence wins, and each item gets the full ID
+    // of the object stored with its ID.  The objects are stored in the order
+    // of the batch, each incrementing the update count of the calling range.
+    BOOST_CHECK_EQUAL(join(RepositoryXL::instance().storeObjects(items, true)),
+                      "B#0001,c#0000,B#0001");
+    boost::shared_ptr<NodeObject> node;
+    RepositoryXL::instance().retrieveObject(node, "b");
+    BOOST_CHECK_EQUAL(node->total(), 4);
+
+    // An object resident in another cell may not be overwritten.
+    items.clear();
+    items.push_back(reposit::StoreItem("d", makeNode("d")));
+    items.push_back(reposit::StoreItem("a", makeNode("a")));
+    BOOST_CHECK_THROW(RepositoryXL::instance().storeObjects(items), std::exception);
+    BOOST_CHECK(!exists("d"));
+    BOOST_CHECK_EQUAL(RepositoryXL::instance().objectCount(), 3);
+}
+
+void RepositoryXLTest::testErrors() {
+
+    BOOST_TEST_MESSAGE("Testing error messages against the Excel emulator...");
+
+    ExcelEnvironment environment;
+
+    callNode(1, 0, 0, "a");
+
+    // An object may not take over the ID of an object resident in another cell.
+    BOOST_CHECK_EQUAL(callNode(1, 4, 1, "a"), "");
+    std::string message = retrieveError(1, 4, 1);
+    BOOST_CHECK(message.find("xlNode - Cannot create object with ID 'a'") != std::string::npos);
+    BOOST_CHECK_EQUAL(retrieveError(1, 0, 0), "");
+
+    // A successful call does not fetch the reference text of its caller.
+    environment.excel().reset();
+    BOOST_CHECK(callNodeTotal(1, 5, 1, 1, 1, "a"));
+    BOOST_CHECK_EQUAL(environment.excel().calls(xlfReftext), 0);
+
+    // The error is cleared when the cell recalculates successfully, by the
+    // identity of the caller rather than the text of its reference.
+    BOOST_CHECK(!callNodeTotal(1, 5, 1, 1, 1, "missing"));
+    BOOST_CHECK(!retrieveError(1, 5, 1).empty());
+    environment.excel().reset();
+    BOOST_CHECK(callNodeTotal(1, 5, 1, 1, 1, "a"));
+    BOOST_CHECK_EQUAL(environment.excel().calls(xlfReftext), 0);
+    BOOST_CHECK_EQUAL(retrieveError(1, 5, 1), "");
+    BOOST_CHECK_EQUAL(callNode(1, 4, 1, "c"), "c#0000");
+    BOOST_CHECK_EQUAL(retrieveError(1, 4, 1), "");
+
+    // A constructor recalculating in a cell which already has a calling range
+    // finds the range without the reference text or the name of its caller.
+    environment.excel().reset();
+    BOOST_CHECK_EQUAL(callNode(1, 4, 1, "c"), "c#0001");
+    BOOST_CHECK_EQUAL(environment.excel().calls(xlfReftext), 0);
+    BOOST_CHECK_EQUAL(environment.excel().calls(xlfGetDef), 0);
+
+    // Once the cell is deleted and its range collected, a new formula in its
+    // place is given a new calling range.
+    environment.excel().deleteRange(1, 4, 1);
+    RepositoryXL::instance().collectGarbage();
+    BOOST_CHECK(!exists("c"));
+    BOOST_CHECK_EQUAL(callNode(1, 4, 1, "c"), "c#0000");
+    BOOST_CHECK_EQUAL(callNode(1, 4, 1, "c"), "c#0001");
+
+    // An error in a multi-cell range is found from any cell in the range.
+    {
+        ExcelEmulator::Call call(1, 10, 0, 3, 2);
+        char id[] = "missing";
+        BOOST_CHECK(!xlNodeTotal(id));
+    }
+    BOOST_CHECK(retrieveError(1, 11, 1).find("xlNodeTotal") != std::string::npos);
+    BOOST_CHECK_EQUAL(retrieveError(1, 13, 1), "");
+
+    checkMemory(environment.excel());
+}
+
+void RepositoryXLTest::testThreadSafeErrors() {
+
+    BOOST_TEST_MESSAGE("Testing errors of functions called thread safe...");
+
+    ExcelEnvironment environment;
+
+    callNode(1, 0, 5, "a", 1);
+
+    // A thread safe reader which succeeds leaves the cell without an error.
+    BOOST_CHECK(callNodeTotal(1, 0, 0, 1, 1, "a", true));
+    BOOST_CHECK_EQUAL(retrieveError(1, 0, 0), "");
+
+    {
+        ExcelEmulator::Call call(1, 0, 0, 1, 1, true);
+        reposit::FunctionCall functionCall("test", true);
+        BOOST_CHECK(functionCall.readOnly());
+        BOOST_CHECK_THROW(functionCall.refStr(), std::exception);
+    }
+    {
+        ExcelEmulator::Call call(1, 0, 0);
+        reposit::FunctionCall functionCall("test");
+        BOOST_CHECK(!functionCall.readOnly());
+    }
+
+    // A thread safe reader which fails makes no callback for the reference of
+    // its caller, and its error is retrieved by the address of any cell in
+    // the calling range.
+    environment.excel().reset();
+    BOOST_CHECK(!callNodeTotal(1, 2, 0, 1, 1, "missing", true));
+    BOOST_CHECK_EQUAL(environment.excel().calls(xlfReftext), 0);
+    BOOST_CHECK_EQUAL(environment.excel().calls(xlfGetCell), 0);
+    BOOST_CHECK(retrieveError(1, 2, 0).find("missing") != std::string::npos);
+    BOOST_CHECK(!callNodeTotal(1, 4, 0, 2, 2, "missing", true));
+    BOOST_CHECK(!retrieveError(1, 5, 1).empty());
+    BOOST_CHECK_EQUAL(retrieveError(1, 6, 0), "");
+
+    // Errors are cleared by the identity of the caller, whether logged with
+    // or without thread safety, and whether or not they have been retrieved.
+    BOOST_CHECK(callNodeTotal(1, 2, 0, 1, 1, "a", true));
+    BOOST_CHECK_EQUAL(retrieveError(1, 2, 0), "");
+    BOOST_CHECK(!callNodeTotal(1, 2, 0, 1, 1, "missing", true));
+    BOOST_CHECK(callNodeTotal(1, 2, 0, 1, 1, "a", true));
+    BOOST_CHECK_EQUAL(retrieveError(1, 2, 0), "");
+    BOOST_CHECK(!callNodeTotal(1, 0, 0, 1, 1, "missing"));
+    BOOST_CHECK(!retrieveError(1, 0, 0).empty());
+    BOOST_CHECK(callNodeTotal(1, 0, 0, 1, 1, "a", true));
+    BOOST_CHECK_EQUAL(retrieveError(1, 0, 0), "");
+    BOOST_CHECK(!callNodeTotal(1, 0, 0, 1, 1, "missing", true));
+    BOOST_CHECK(callNodeTotal(1, 0, 0, 1, 1, "a"));
+    BOOST_CHECK_EQUAL(retrieveError(1, 0, 0), "");
+
+    checkMemory(environment.excel());
+}
+
+void RepositoryXLTest::testConcurrentReaders() {
+
+    BOOST_TEST_MESSAGE("Testing concurrent calls to thread safe functions...");
+
+    ExcelEnvironment environment;
+    ExcelEmulator &excel = environment.excel();
+
+    callNode(1, 0, 5, "a", 1);
+    callNode(1, 1, 5, "b", 2, "a");
+    callNode(1, 2, 5, "c", 3, "b");
+
+    const int threadCount = 8, passes = 20;
+    for (int recalc = 0; recalc < 3; ++recalc) {
+
+        // Changing a marks b and c dirty, so the first readers of c recreate them.
+        callNode(1, 0, 5, "a", 10 + recalc);
+        long creatorCalls = SerializationFactory::creatorCalls();
+        excel.reset();
+
+        std::vector<ReaderResults> results(threadCount);
+        boost::thread_group threads;
+        for (int i = 0; i < threadCount; ++i)
+            threads.create_thread(ConcurrentReader(10 + i, passes, results[i]));
+        threads.join_all();
+
+        // No thread made a callback which Excel forbids during
+        // multi-threaded recalculation.
+        BOOST_CHECK_EQUAL(excel.refusedCalls(), 0);
+        BOOST_CHECK_EQUAL(excel.calls(xlfReftext), 0);
+        BOOST_CHECK_EQUAL(excel.calls(xlfGetDef), 0);
+        BOOST_CHECK_EQUAL(SerializationFactory::creatorCalls() - creatorCalls, 2);
+
+        for (int i = 0; i < threadCount; ++i) {
+            BOOST_CHECK_EQUAL(results[i].exists, passes);
+            BOOST_CHECK_EQUAL(results[i].values, passes);
+            BOOST_CHECK_EQUAL(results[i].listed, passes);
+            BOOST_CHECK_EQUAL(results[i].failures, passes);
+            // Each failing call logged its error against its own cell, and
+            // each successful call cleared any error from its cell.
+            BOOST_CHECK(retrieveError(1, 10 + i, 1).find(
+                "ohObjectPropertyValues - reposit error: attempt to retrieve object with unknown ID 'missing'")
+                != std::string::npos);
+            BOOST_CHECK_EQUAL(retrieveError(1, 10 + i, 0), "");
+        }
+    }
+
+    BOOST_CHECK(callNodeTotal(1, 3, 5, 1, 1, "c"));
+    checkMemory(excel);
+}
+
+void RepositoryXLTest::testErrorIndex() {
+
+    BOOST_TEST_MESSAGE("Testing the lookup of errors in ranges of varying size...");
+
+    ExcelEnvironment environment;
+    callNode(1, 200, 0, "a");
+
+    // Tile a block of the sheet with ranges of random height, in strips one
+    // or two columns wide, and log an error against half of the ranges.
+    // owner[row][col] is the ID in the error logged against the cell's range.
+    const int rows = 60, cols = 12;
+    std::vector<std::vector<std::string> > owner(rows, std::vector<std::string>(cols));
+    std::vector<std::vector<int> > errors;
+    std::srand(7);
+    for (int col = 0; col < cols; ) {
+        int width = std::min(cols - col, 1 + std::rand() % 2);
+        for (int row = 0; row < rows; ) {
+            int height = std::min(rows - row, 1 + std::rand() % 8);
+            if (std::rand() % 2) {
+                std::ostringstream id;
+                id << "missing_" << row << "_" << col;
+                BOOST_CHECK(!callNodeTotal(1, row, col, height, width, id.str()));
+                for (int r = row; r < row + height; ++r)
+                    for (int c = col; c < col + width; ++c)
+                        owner[r][c] = id.str();
+                int error[] = { row, col, height, width };
+                errors.push_back(std::vector<int>(error, error + 4));
+            }
+            row += height;
+        }
+        col += width;
+    }
+
+    // An error on another sheet, overlapping the block, does not interfere.
+    IDSHEET sheet2 = environment.excel().addSheet("Sheet2");
+    BOOST_CHECK(!callNodeTotal(sheet2, 0, 0, rows, cols, "missing_sheet2"));
+    BOOST_CHECK(retrieveError(sheet2, 30, 5).find("'missing_sheet2'") != std::string::npos);
+
+    for (std::size_t pass = 0; pass < 2; ++pass) {
+        for (int row = 0; row < rows; ++row) {
+            for (int col = 0; col < cols; ++col) {
+                std::string message = retrieveError(1, row, col);
+                if (owner[row][col].empty()) {
+                    if (!message.empty())
+                        BOOST_ERROR("cell (" << row << ", " << col << ") has error " << message);
+                } else if (message.find("'" + owner[row][col] + "'") == std::string::npos) {
+                    BOOST_ERROR("cell (" << row << ", " << col << ") expected error "
+                                << owner[row][col] << " found " << message);
+                }
+            }
+        }
+
+        // Recalculate every other range successfully, clearing its error.
+        for (std::size_t i = pass; i < errors.size(); i += 2) {
+            const std::vector<int> &e = errors[i];
+            BOOST_CHECK(callNodeTotal(1, e[0], e[1], e[2], e[3], "a"));
+            for (int r = e[0]; r < e[0] + e[2]; ++r)
+                for (int c = e[1]; c < e[1] + e[3]; ++c)
+                    owner[r][c].clear();
+        }
+    }
+
+    // A selection spanning several ranges returns the error of the range
+    // containing the whole selection, or nothing.
+    BOOST_CHECK(retrieveError(sheet2, 2, 2, 3, 3).find("'missing_sheet2'") != std::string::npos);
+    BOOST_CHECK_EQUAL(retrieveError(sheet2, rows - 1, cols - 1, 2, 1), "");
+
+    // Once the widest range is cleared, narrower ones are still found.
+    BOOST_CHECK(callNodeTotal(sheet2, 0, 0, rows, cols, "a"));
+    BOOST_CHECK(!callNodeTotal(sheet2, 3, 7, 1, 1, "missing_narrow"));
+    BOOST_CHECK(!callNodeTotal(sheet2, 10, 4, 2, 3, "missing_wide"));
+    BOOST_CHECK(retrieveError(sheet2, 3, 7).find("'missing_narrow'") != std::string::npos);
+    BOOST_CHECK(retrieveError(sheet2, 11, 6).find("'missing_wide'") != std::string::npos);
+    BOOST_CHECK_EQUAL(retrieveError(sheet2, 30, 5), "");
+    BOOST_CHECK_EQUAL(retrieveError(sheet2, 11, 7), "");
+
+    checkMemory(environment.excel());
+}
+
+void RepositoryXLTest::testGarbageCollection() {
+
+    BOOST_TEST_MESSAGE("Testing garbage collection against the Excel emulator...");
+
+    ExcelEnvironment environment;
+
+    callNode(1, 0, 0, "a");
+    callNode(1, 1, 0, "b");
+    callNode(1, 2, 0, "c", 0, "", true);
+    BOOST_CHECK_EQUAL(environment.excel().nameCount(), 3u);
+
+    // Deleting the calling range orphans its objects.
+    environment.excel().deleteRange(1, 0, 0);
+    environment.excel().deleteRange(1, 2, 0);
+    std::vector<bool> orphans = RepositoryXL::instance().isOrphan(ids("a,b,c"));
+    BOOST_CHECK(orphans[0] && !orphans[1] && orphans[2]);
+    RepositoryXL::instance().collectGarbage();
+    BOOST_CHECK(!exists("a"));
+    BOOST_CHECK(exists("b"));
+    BOOST_CHECK(exists("c"));
+    BOOST_CHECK_EQUAL(environment.excel().nameCount(), 2u);
+
+    // Permanent objects are collected only on request.
+    RepositoryXL::instance().collectGarbage(true);
+    BOOST_CHECK(!exists("c"));
+    BOOST_CHECK_EQUAL(environment.excel().nameCount(), 1u);
+
+    checkMemory(environment.excel());
+}
+
+void RepositoryXLTest::testIncrementalGarbageCollection() {
+
+    BOOST_TEST_MESSAGE("Testing incremental garbage collection against the Excel emulator...");
+
+    ExcelEnvironment environment;
+
+    for (int row = 0; row < 10; ++row)
+        callNode(1, row, 0, "node" + boost::lexical_cast<std::string>(row));
+    environment.excel().deleteRange(1, 2, 0, 2, 1);
+    environment.excel().deleteRange(1, 7, 0);
+
+    // The first call checks four ranges, two of which are collected.
+    BOOST_CHECK_EQUAL(RepositoryXL::instance().collectGarbageIncremental(4), 6);
+    BOOST_CHECK(!exists("node2"));
+    BOOST_CHECK(!exists("node3"));
+    BOOST_CHECK(exists("node7"));
+
+    // A range created behind the cursor is not checked until the next pass.
+    callNode(1, 20, 0, "node20");
+    BOOST_CHECK_EQUAL(RepositoryXL::instance().collectGarbageIncremental(4), 2);
+    BOOST_CHECK(!exists("node7"));
+    BOOST_CHECK_EQUAL(RepositoryXL::instance().collectGarbageIncremental(4), 0);
+    BOOST_CHECK_EQUAL(RepositoryXL::instance().objectCount(), 8);
+
+    // The next call starts a new pass.
+    environment.excel().deleteRange(1, 20, 0);
+    BOOST_CHECK_EQUAL(RepositoryXL::instance().collectGarbageIncremental(1), 7);
+    BOOST_CHECK_EQUAL(RepositoryXL::instance().collectGarbageIncremental(100), 0);
+    BOOST_CHECK(!exists("node20"));
+    BOOST_CHECK_EQUAL(RepositoryXL::instance().objectCount(), 7);
+
+    // The count is kept in step with the ranges collected by collectGarbage().
+    environment.excel().deleteRange(1, 0, 0);
+    BOOST_CHECK_EQUAL(RepositoryXL::instance().collectGarbageIncremental(2), 5);
+    environment.excel().deleteRange(1, 9, 0);
+    RepositoryXL::instance().collectGarbage();
+    BOOST_CHECK_EQUAL(RepositoryXL::instance().collectGarbageIncremental(100), 0);
+    BOOST_CHECK_EQUAL(RepositoryXL::instance().objectCount(), 5);
+
+    BOOST_CHECK_THROW(RepositoryXL::instance().collectGarbageIncremental(0), std::exception);
+
+    checkMemory(environment.excel());
+}
+
+void RepositoryXLTest::testConversions() {
+
+    BOOST_TEST_MESSAGE("Testing OPER conversions against the Excel emulator...");
+
+    ExcelEnvironment environment;
+    ExcelEmulator::Call call(1, 0, 0);
+
+    BOOST_CHECK_EQUAL(static_cast<double>(reposit::ConvertOper(*TempStrStl("2.5"))), 2.5);
+    BOOST_CHECK_EQUAL(static_cast<long>(reposit::ConvertOper(*TempStrStl("42"))), 42);
+    BOOST_CHECK(static_cast<bool>(reposit::ConvertOper(*TempStrStl("true"))));
+    BOOST_CHECK_EQUAL(static_cast<std::string>(reposit::ConvertOper(*TempNum(1.5))), "1.5");
+    BOOST_CHECK_THROW(static_cast<double>(reposit::ConvertOper(*TempStrStl("abc"))),
+                      std::exception);
+
+    XCHAR str[] = { 2, '1', '7' };
+    XLOPER12 xStr;
+    xStr.xltype = xltypeStr;
+    xStr.val.str = str;
+    BOOST_CHECK_EQUAL(static_cast<long>(reposit::ConvertOper12(xStr)), 17);
+    BOOST_CHECK_EQUAL(static_cast<std::string>(reposit::ConvertOper12(xStr)), "17");
+
+    // Strings are converted between wide characters and the ANSI code page,
+    // which the emulator takes to be Latin-1, so that an ID containing a
+    // character above 0x7F has the same value in an OPER12 as in an OPER.
+    const std::string id("caf\xe9");
+    BOOST_CHECK_EQUAL(callNode(1, 1, 0, id), id + "#0000");
+    OPER xMissing;
+    xMissing.xltype = xltypeMissing;
+    char regex[] = "";
+    OPER *xIDs = ohRepositoryListObjectIDs(regex, &xMissing);
+    BOOST_REQUIRE(xIDs);
+    BOOST_CHECK_EQUAL(static_cast<std::string>(reposit::ConvertOper(xIDs->val.array.lparray[0])), id);
+    freeOper(xIDs);
+    OPER12 *xIDs12 = ohRepositoryListObjectIDs12(regex, &xMissing);
+    BOOST_REQUIRE(xIDs12);
+    const XCHAR *wide = xIDs12->val.array.lparray[0].val.str;
+    BOOST_REQUIRE_EQUAL(wide[0], 4);
+    BOOST_CHECK_EQUAL(wide[4], 0xE9);
+    std::string narrow = reposit::ConvertOper12(xIDs12->val.array.lparray[0]);
+    BOOST_CHECK_EQUAL(narrow, id);
+    BOOST_CHECK(exists(narrow));
+    freeOper(xIDs12);
+    // A character outside the code page is not truncated to another character.
+    XCHAR euro[] = { 1, 0x20AC };
+    xStr.val.str = euro;
+    BOOST_CHECK_EQUAL(static_cast<std::string>(reposit::ConvertOper12(xStr)), "?");
+
+    // A reference is coerced to the values of its cells.
+    environment.excel().setCell(1, 5, 0, 1.0);
+    environment.excel().setCell(1, 5, 1, "x");
+    XLMREF xMref;
+    xMref.count = 1;
+    xMref.reftbl[0].rwFirst = xMref.reftbl[0].rwLast = 5;
+    xMref.reftbl[0].colFirst = 0;
+    xMref.reftbl[0].colLast = 2;
+    XLOPER xRef;
+    xRef.xltype = xltypeRef;
+    xRef.val.mref.idSheet = 1;
+    xRef.val.mref.lpmref = &xMref;
+    {
+        reposit::Xloper xMulti;
+        Excel(xlCoerce, &xMulti, 2, &xRef, TempInt(xltypeMulti));
+        BOOST_REQUIRE(xMulti->xltype == xltypeMulti);
+        BOOST_CHECK_EQUAL(xMulti->val.array.columns, 3);
+        BOOST_CHECK_EQUAL(xMulti->val.array.lparray[0].val.num, 1.0);
+        BOOST_CHECK_EQUAL(static_cast<std::string>(
+            reposit::ConvertOper(xMulti->val.array.lparray[1])), "x");
+        BOOST_CHECK(xMulti->val.array.lparray[2].xltype == xltypeNil);
+    }
+
+    checkMemory(environment.excel());
+}
+
+void RepositoryXLTest::testObjectUnchanged() {
+
+    BOOST_TEST_MESSAGE("Testing that objectUnchanged does not name the calling range...");
+
+    ExcelEnvironment environment;
+
+    callNode(1, 0, 0, "a", 1);
+    boost::shared_ptr<reposit::ValueObject> same(
+        new NodeValueObject("a", 1, std::vector<std::string>(), false));
+    boost::shared_ptr<reposit::ValueObject> changed(
+        new NodeValueObject("a", 2, std::vector<std::string>(), false));
+
+    {
+        ExcelEmulator::Call call(1, 0, 0);
+        reposit::FunctionCall functionCall("test");
+        BOOST_CHECK(RepositoryXL::instance().objectUnchanged("a", same));
+        BOOST_CHECK(!RepositoryXL::instance().objectUnchanged("a", changed));
+    }
+
+    // From a cell without a calling range the object is never unchanged,
+    // and the query must not create a range or define a name.
+    environment.excel().reset();
+    {
+        ExcelEmulator::Call call(1, 5, 0);
+        reposit::FunctionCall functionCall("test");
+        BOOST_CHECK(!RepositoryXL::instance().objectUnchanged("a", same));
+    }
+    BOOST_CHECK_EQUAL(environment.excel().calls(xlfSetName), 0);
+    BOOST_CHECK_EQUAL(environment.excel().nameCount(), 1u);
+
+    checkMemory(environment.excel());
+}
+
+void RepositoryXLTest::testDeferredDestruction() {
+
+    BOOST_TEST_MESSAGE("Testing deferred destruction against the Excel emulator...");
+
+    ExcelEnvironment environment;
+
+    callNode(1, 0, 0, "a", 1);
+    callNode(1, 1, 0, "b", 2);
+    RepositoryXL::instance().setDeferredDestruction(true);
+
+    // The cell reuses the ID of its deleted object before the old wrapper
+    // is destroyed, which must leave the new one registered with the range.
+    RepositoryXL::instance().deleteObject("a");
+    BOOST_CHECK(!exists("a"));
+    BOOST_CHECK_EQUAL(callNode(1, 0, 0, "a", 3), "a#0001");
+    BOOST_CHECK_EQUAL(RepositoryXL::instance().reclaimObjects(), 0u);
+    BOOST_CHECK(exists("a"));
+    environment.excel().deleteRange(1, 0, 0);
+    RepositoryXL::instance().collectGarbage();
+    BOOST_CHECK(!exists("a"));
+    // The queued wrapper holds the range, and so its name, until reclaimed.
+    BOOST_CHECK_EQUAL(environment.excel().nameCount(), 2u);
+    RepositoryXL::instance().reclaimObjects();
+    BOOST_CHECK_EQUAL(environment.excel().nameCount(), 1u);
+
+    // Clearing the Repository defers the destruction of all its objects,
+    // which are destroyed when deferral is disabled.
+    RepositoryXL::instance().clear();
+    BOOST_CHECK_EQUAL(RepositoryXL::instance().objectCount(), 0);
+    RepositoryXL::instance().setDeferredDestruction(false);
+    BOOST_CHECK_EQUAL(RepositoryXL::instance().reclaimObjects(), 0u);
+    BOOST_CHECK_EQUAL(environment.excel().nameCount(), 0u);
+
+    checkMemory(environment.excel());
+}
+
+void RepositoryXLTest::testPermanentObjects() {
+
+    BOOST_TEST_MESSAGE("Testing permanent objects against the Excel emulator...");
+
+    ExcelEnvironment environment;
+
+    // A cell whose object changes permanence is collected accordingly.
+    callNode(1, 0, 0, "a", 0, "", true);
+    callNode(1, 0, 0, "a", 0, "", false);
+    callNode(1, 1, 0, "b", 0, "", false);
+    callNode(1, 1, 0, "b", 0, "", true);
+    environment.excel().deleteRange(1, 0, 0, 2, 1);
+    RepositoryXL::instance().collectGarbage();
+    BOOST_CHECK(!exists("a"));
+    BOOST_CHECK(exists("b"));
+    RepositoryXL::instance().collectGarbage(true);
+    BOOST_CHECK(!exists("b"));
+
+    // Bulk deletion leaves the permanent objects and their calling ranges.
+    callNode(1, 2, 0, "c", 0, "", true);
+    callNode(1, 3, 0, "d");
+    RepositoryXL::instance().deleteAllObjects();
+    BOOST_CHECK(exists("c"));
+    BOOST_CHECK(!exists("d"));
+    BOOST_CHECK_EQUAL(callNode(1, 2, 0, "c", 0, "", true), "c#0001");
+
+    checkMemory(environment.excel());
+}
+
+void RepositoryXLTest::testDependentIDs() {
+
+    BOOST_TEST_MESSAGE("Testing dependent IDs against the Excel emulator...");
+
+    ExcelEnvironment environment;
+    RepositoryXL &repository = RepositoryXL::instance();
+
+    // Precedents are given by full ID, and indexed by the ID without the
+    // update count, so that the index survives the recalculation of the
+    // precedent.
+    callNode(1, 0, 0, "a", 1);
+    callNode(1, 1, 0, "b", 2, "a#0000");
+    callNode(1, 2, 0, "c", 3, "b#0000");
+    BOOST_CHECK_EQUAL(callNode(1, 0, 0, "a", 4), "a#0001");
+    BOOST_CHECK_EQUAL(join(repository.dependentIDs("a#0001")), "b");
+    BOOST_CHECK_EQUAL(join(repository.dependentIDs("a", true)), "b,c");
+
+    // As is the ID of an object which is recalculated with new precedents.
+    callNode(1, 2, 0, "c", 3, "a#0001");
+    BOOST_CHECK_EQUAL(join(repository.dependentIDs("a#0001")), "b,c");
+    BOOST_CHECK(repository.dependentIDs("b#0000").empty());
+
+    // Garbage collection removes the collected objects from the index.
+    environment.excel().deleteRange(1, 1, 0);
+    repository.collectGarbage();
+    BOOST_CHECK_EQUAL(join(repository.dependentIDs("a")), "c");
+
+    checkMemory(environment.excel());
+}
+
+test_suite* RepositoryXLTest::suite() {
+    test_suite* suite = BOOST_TEST_SUITE("RepositoryXL tests");
+    suite->add(BOOST_TEST_CASE(&RepositoryXLTest::testFunctionCall));
+    suite->add(BOOST_TEST_CASE(&RepositoryXLTest::testStoreObject));
+    suite->add(BOOST_TEST_CASE(&RepositoryXLTest::testStoreObjects));
+    suite->add(BOOST_TEST_CASE(&RepositoryXLTest::testErrors));
+    suite->add(BOOST_TEST_CASE(&RepositoryXLTest::testThreadSafeErrors));
+    suite->add(BOOST_TEST_CASE(&RepositoryXLTest::testConcurrentReaders));
+    suite->add(BOOST_TEST_CASE(&RepositoryXLTest::testErrorIndex));
+    suite->add(BOOST_TEST_CASE(&RepositoryXLTest::testGarbageCollection));
+    suite->add(BOOST_TEST_CASE(&RepositoryXLTest::testIncrementalGarbageCollection));
+    suite->add(BOOST_TEST_CASE(&RepositoryXLTest::testConversions));
+    suite->add(BOOST_TEST_CASE(&RepositoryXLTest::testObjectUnchanged));
+    suite->add(BOOST_TEST_CASE(&RepositoryXLTest::testDeferredDestruction));
+    suite->add(BOOST_TEST_CASE(&RepositoryXLTest::testPermanentObjects));
+    suite->add(BOOST_TEST_CASE(&RepositoryXLTest::testDependentIDs));
+    return suite;
+}
+
@@ -0,0 +1,45 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#ifndef reposit_test_repositoryxl_hpp
+#define reposit_test_repositoryxl_hpp
+
+#include <boost/test/unit_test.hpp>
+
+class RepositoryXLTest {
+  public:
+    static void testFunctionCall();
+    static void testStoreObject();
+    static void testStoreObjects();
+    static void testErrors();
+    static void testThreadSafeErrors();
+    static void testConcurrentReaders();
+    static void testErrorIndex();
+    static void testGarbageCollection();
+    static void testIncrementalGarbageCollection();
+    static void testConversions();
+    static void testObjectUnchanged();
+    static void testDeferredDestruction();
+    static void testPermanentObjects();
+    static void testDependentIDs();
+    static boost::unit_test_framework::test_suite* suite();
+};
+
+#endif
+
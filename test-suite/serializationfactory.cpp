@@ -0,0 +1,178 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "serializationfactory.hpp"
+#include "utilities.hpp"
+#include <boost/filesystem.hpp>
+#include <boost/regex.hpp>
+#include <ctime>
+#include <fstream>
+
+using namespace RepositTest;
+using namespace boost::unit_test_framework;
+namespace fs = boost::filesystem;
+
+namespace {
+
+    SerializationFactory &factory() {
+        return dynamic_cast<SerializationFactory&>(reposit::SerializationFactory::instance());
+    }
+
+    void createFile(const fs::path &path) {
+        std::ofstream(path.string().c_str());
+    }
+
+    // A temporary directory tree, deleted by the destructor.
+    class Tree {
+    public:
+        Tree() : root_(fs::temp_directory_path() / fs::unique_path("repositestsuite-%%%%-%%%%")) {
+            fs::create_directories(root_ / "a" / "b");
+            fs::create_directories(root_ / "c");
+            fs::create_directories(root_ / "dir.xml");
+            const char *files[] = { "1.xml", "2.txt", "a/3.xml", "a/4.XML", "a/b/5.xml",
+                                    "a/b/6.xmlx", "c/7.xml", "dir.xml/8.xml" };
+            for (std::size_t i = 0; i < sizeof(files)/sizeof(files[0]); ++i)
+                createFile(root_ / files[i]);
+            fs::create_symlink(root_ / "a", root_ / "c" / "link.xml");
+            fs::create_symlink(root_ / "1.xml", root_ / "c" / "filelink.xml");
+        }
+        ~Tree() {
+            fs::remove_all(root_);
+        }
+        const fs::path &root() const { return root_; }
+        // Set the write time of every directory in the tree, as if the tree
+        // had been written the given number of seconds ago.
+        void age(std::time_t seconds) {
+            std::time_t t = std::time(0) - seconds;
+            fs::last_write_time(root_, t);
+            for (fs::recursive_directory_iterator i(root_); i != fs::recursive_directory_iterator(); ++i)
+                if (fs::is_directory(i->symlink_status()))
+                    fs::last_write_time(i->path(), t);
+        }
+    private:
+        fs::path root_;
+    };
+
+    // The regular files matching the pattern, found as loadObject() did
+    // before the introduction of scanDirectory().
+    std::vector<std::string> expected(const fs::path &root, const std::string &pattern, bool recurse) {
+        boost::regex r(pattern, boost::regex::perl | boost::regex::icase);
+        std::vector<std::string> ret;
+        if (recurse) {
+            for (fs::recursive_directory_iterator i(root); i != fs::recursive_directory_iterator(); ++i)
+                if (regex_match(i->path().leaf().string(), r) && fs::is_regular(i->status()))
+                    ret.push_back(i->path().string());
+        } else {
+            for (fs::directory_iterator i(root); i != fs::directory_iterator(); ++i)
+                if (regex_match(i->path().leaf().string(), r) && fs::is_regular(i->status()))
+                    ret.push_back(i->path().string());
+        }
+        return ret;
+    }
+
+    std::string scan(const Tree &tree, bool recurse = true) {
+        return join(factory().scan(tree.root().string(), ".*\\.xml", recurse));
+    }
+
+}
+
+void SerializationFactoryTest::testScanDirectory() {
+
+    BOOST_TEST_MESSAGE("Testing the scan of a directory for the files to be loaded...");
+
+    Environment environment;
+    Tree tree;
+    std::string root = tree.root().string();
+
+    // Directories and links to directories are never returned, whatever
+    // their names, and links are not followed into other directories.
+    for (int recurse = 0; recurse < 2; ++recurse) {
+        std::vector<std::string> files = factory().scan(root, ".*\\.xml", recurse != 0);
+        BOOST_CHECK_EQUAL(join(files), join(expected(tree.root(), ".*\\.xml", recurse != 0)));
+        BOOST_CHECK_EQUAL(files.size(), recurse ? 7u : 1u);
+        for (std::vector<std::string>::const_iterator i = files.begin(); i != files.end(); ++i) {
+            BOOST_CHECK_MESSAGE(fs::is_regular(*i), *i);
+            BOOST_CHECK_MESSAGE(i->find("link.xml") == std::string::npos
+                || i->find("filelink.xml") != std::string::npos, *i);
+        }
+    }
+
+    const char *patterns[] = { "[0-9]\\.xml", "a", "", "4.*", ".*" };
+    for (std::size_t i = 0; i < sizeof(patterns)/sizeof(patterns[0]); ++i)
+        BOOST_CHECK_EQUAL(join(factory().scan(root, patterns[i], true)),
+                          join(expected(tree.root(), patterns[i], true)));
+}
+
+void SerializationFactoryTest::testScanCache() {
+
+    BOOST_TEST_MESSAGE("Testing the cache of directory scans...");
+
+    Environment environment;
+    Tree tree;
+    tree.age(10);
+    factory().setCacheDirectoryScans(true);
+    std::string files = scan(tree);
+
+    // The cached list is returned while no directory write time changes.
+    // Restoring the write time of a directory after adding a file hides the
+    // addition, which shows that the list came from the cache.
+    createFile(tree.root() / "a" / "9.xml");
+    tree.age(10);
+    BOOST_CHECK_EQUAL(scan(tree), files);
+
+    // Adding a file invalidates the list.
+    createFile(tree.root() / "a" / "b" / "10.xml");
+    files = scan(tree);
+    BOOST_CHECK(files.find("10.xml") != std::string::npos);
+    BOOST_CHECK(files.find("9.xml") != std::string::npos);
+    BOOST_CHECK_EQUAL(files, join(expected(tree.root(), ".*\\.xml", true)));
+
+    // So does removing one.
+    tree.age(10);
+    BOOST_CHECK_EQUAL(scan(tree), files);
+    fs::remove(tree.root() / "c" / "7.xml");
+    files = scan(tree);
+    BOOST_CHECK(files.find("7.xml") == std::string::npos);
+    BOOST_CHECK_EQUAL(files, join(expected(tree.root(), ".*\\.xml", true)));
+
+    // A directory written in the second in which the scan started, or later,
+    // is never trusted, because a file may have been added within that second
+    // without changing the write time.
+    tree.age(-1);
+    scan(tree);
+    createFile(tree.root() / "c" / "11.xml");
+    tree.age(-1);
+    files = scan(tree);
+    BOOST_CHECK(files.find("11.xml") != std::string::npos);
+
+    // The list depends on the recursion flag, and on the pattern.
+    BOOST_CHECK_EQUAL(scan(tree, false), join(expected(tree.root(), ".*\\.xml", false)));
+    BOOST_CHECK_EQUAL(join(factory().scan(tree.root().string(), "1.*", true)),
+                      join(expected(tree.root(), "1.*", true)));
+
+    factory().setCacheDirectoryScans(false);
+}
+
+test_suite* SerializationFactoryTest::suite() {
+    test_suite* suite = BOOST_TEST_SUITE("SerializationFactory tests");
+    suite->add(BOOST_TEST_CASE(&SerializationFactoryTest::testScanDirectory));
+    suite->add(BOOST_TEST_CASE(&SerializationFactoryTest::testScanCache));
+    return suite;
+}
+
@@ -0,0 +1,205 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "utilities.hpp"
+#include <rp/exception.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
+
+namespace RepositTest {
+
+    namespace {
+        const char *propertyNames[] = { "Value", "Precedents", "Permanent" };
+        long creatorCalls_ = 0;
+    }
+
+    NodeValueObject::NodeValueObject(
+        const std::string &objectID,
+        long value,
+        const std::vector<std::string> &precedents,
+        bool permanent,
+        const std::string &className)
+        : reposit::ValueObject(objectID, className, permanent),
+          value_(value), precedents_(precedents) {
+        for (std::vector<std::string>::const_iterator i = precedents.begin();
+            i != precedents.end(); ++i)
+            processPrecedentID(*i);
+    }
+
+    const std::set<std::string>& NodeValueObject::getSystemPropertyNames() const {
+        static std::set<std::string> ret(propertyNames,
+            propertyNames + sizeof(propertyNames)/sizeof(const char*));
+        return ret;
+    }
+
+    std::vector<std::string> NodeValueObject::getPropertyNamesVector() const {
+        std::vector<std::string> ret(propertyNames,
+            propertyNames + sizeof(propertyNames)/sizeof(const char*));
+        for (std::map<std::string, reposit::property_t>::const_iterator i
+            = userProperties.begin(); i != userProperties.end(); ++i)
+            ret.push_back(i->first);
+        return ret;
+    }
+
+    reposit::property_t NodeValueObject::getSystemProperty(const std::string &name) const {
+        std::string nameUpper = boost::algorithm::to_upper_copy(name);
+        if (nameUpper == "OBJECTID")
+            return objectId_;
+        else if (nameUpper == "CLASSNAME")
+            return className_;
+        else if (nameUpper == "PERMANENT")
+            return permanent_;
+        else if (nameUpper == "VALUE")
+            return value_;
+        else if (nameUpper == "PRECEDENTS")
+            return join(precedents_);
+        else
+            RP_FAIL("Error: attempt to retrieve non-existent Property: '" + name + "'");
+    }
+
+    void NodeValueObject::setSystemProperty(const std::string &name, const reposit::property_t &value) {
+        std::string nameUpper = boost::algorithm::to_upper_copy(name);
+        if (nameUpper == "OBJECTID")
+            objectId_ = boost::get<std::string>(value);
+        else if (nameUpper == "CLASSNAME")
+            className_ = boost::get<std::string>(value);
+        else if (nameUpper == "PERMANENT")
+            permanent_ = boost::get<bool>(value);
+        else if (nameUpper == "VALUE")
+            value_ = boost::get<long>(value);
+        else if (nameUpper == "PRECEDENTS")
+            precedents_ = ids(boost::get<std::string>(value));
+        else
+            RP_FAIL("Error: attempt to set non-existent Property: '" + name + "'");
+    }
+
+    NodeObject::NodeObject(
+        const boost::shared_ptr<reposit::ValueObject> &properties,
+        long value,
+        const std::vector<boost::shared_ptr<NodeObject> > &precedents,
+        bool permanent)
+        : reposit::Object(properties, permanent),
+          value_(value), precedents_(precedents) {}
+
+    long NodeObject::total() const {
+        long ret = value_;
+        for (std::vector<boost::shared_ptr<NodeObject> >::const_iterator i = precedents_.begin();
+            i != precedents_.end(); ++i)
+            ret += (*i)->total();
+        return ret;
+    }
+
+    boost::shared_ptr<reposit::Object> createNode(
+        const boost::shared_ptr<reposit::ValueObject> &valueObject) {
+
+        boost::shared_ptr<NodeValueObject> nodeValueObject =
+            boost::dynamic_pointer_cast<NodeValueObject>(valueObject);
+        RP_REQUIRE(nodeValueObject, "Unable to recreate Object of class "
+            << valueObject->className() << " - not a Node");
+
+        std::vector<boost::shared_ptr<NodeObject> > precedents;
+        for (std::vector<std::string>::const_iterator i = nodeValueObject->precedents().begin();
+            i != nodeValueObject->precedents().end(); ++i) {
+            RP_GET_OBJECT(precedent, *i, NodeObject)
+            precedents.push_back(precedent);
+        }
+
+        ++creatorCalls_;
+        return boost::shared_ptr<reposit::Object>(new NodeObject(
+            valueObject, nodeValueObject->value(), precedents,
+            reposit::convert<bool>(valueObject->getProperty("Permanent"))));
+    }
+
+    SerializationFactory::SerializationFactory() {
+        registerCreator("Node", createNode);
+        registerCreator("Curve", createNode);
+        registerCreator("Swap", createNode);
+    }
+
+    long SerializationFactory::creatorCalls() {
+        return creatorCalls_;
+    }
+
+    void SerializationFactory::register_out(boost::archive::xml_oarchive &,
+        std::vector<boost::shared_ptr<reposit::ValueObject> >&) {
+        RP_FAIL("Serialization of Node objects is not supported");
+    }
+
+    void SerializationFactory::register_in(boost::archive::xml_iarchive &,
+        std::vector<boost::shared_ptr<reposit::ValueObject> >&) {
+        RP_FAIL("Serialization of Node objects is not supported");
+    }
+
+    Environment::Environment() {
+        repository_.deleteAllObjects(true);
+    }
+
+    Environment::~Environment() {
+        repository_.setDeferredDestruction(false);
+        repository_.deleteAllObjects(true);
+    }
+
+    boost::shared_ptr<reposit::Object> makeNode(
+        const std::string &objectID,
+        long value,
+        const std::vector<std::string> &precedents,
+        bool permanent,
+        const std::string &className) {
+
+        boost::shared_ptr<reposit::ValueObject> valueObject(
+            new NodeValueObject(objectID, value, precedents, permanent, className));
+        return createNode(valueObject);
+    }
+
+    std::string storeNode(
+        const std::string &objectID,
+        long value,
+        const std::vector<std::string> &precedents,
+        bool overwrite,
+        bool permanent,
+        const std::string &className) {
+
+        return reposit::Repository::instance().storeObject(objectID,
+            makeNode(objectID, value, precedents, permanent, className), overwrite);
+    }
+
+    std::vector<std::string> ids(const std::string &list) {
+        std::vector<std::string> ret;
+        std::string::size_type begin = 0;
+        while (begin < list.length()) {
+            std::string::size_type end = list.find(',', begin);
+            if (end == std::string::npos)
+                end = list.length();
+            ret.push_back(list.substr(begin, end - begin));
+            begin = end + 1;
+        }
+        return ret;
+    }
+
+    std::string join(const std::vector<std::string> &list) {
+        std::string ret;
+        for (std::vector<std::string>::const_iterator i = list.begin(); i != list.end(); ++i) {
+            if (i != list.begin())
+                ret += ',';
+            ret += *i;
+        }
+        return ret;
+    }
+
+}
+
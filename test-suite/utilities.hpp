@@ -0,0 +1,141 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file
+    \brief Objects and fixtures shared by the test suite and the benchmark
+*/
+
+#ifndef reposit_test_utilities_hpp
+#define reposit_test_utilities_hpp
+
+#include <rp/object.hpp>
+#include <rp/valueobject.hpp>
+#include <rp/repository.hpp>
+#include <rp/processor.hpp>
+#include <rp/serializationfactory.hpp>
+#include <string>
+#include <vector>
+
+namespace RepositTest {
+
+    //! ValueObject of the test class Node.
+    /*! Records the value of the Node and the IDs of its precedents.  The
+        class name may be chosen by the caller, so that the tests can populate
+        the Repository with Objects of several classes.
+    */
+    class NodeValueObject : public reposit::ValueObject {
+    public:
+        NodeValueObject(
+            const std::string &objectID,
+            long value,
+            const std::vector<std::string> &precedents,
+            bool permanent,
+            const std::string &className = "Node");
+
+        const std::set<std::string>& getSystemPropertyNames() const;
+        std::vector<std::string> getPropertyNamesVector() const;
+        reposit::property_t getSystemProperty(const std::string &name) const;
+        void setSystemProperty(const std::string &name, const reposit::property_t &value);
+
+        long value() const { return value_; }
+        const std::vector<std::string> &precedents() const { return precedents_; }
+    private:
+        long value_;
+        std::vector<std::string> precedents_;
+    };
+
+    //! Test Object whose total is its own value plus the totals of its precedents.
+    class NodeObject : public reposit::Object {
+    public:
+        NodeObject(
+            const boost::shared_ptr<reposit::ValueObject> &properties,
+            long value,
+            const std::vector<boost::shared_ptr<NodeObject> > &precedents,
+            bool permanent);
+        long total() const;
+    private:
+        long value_;
+        std::vector<boost::shared_ptr<NodeObject> > precedents_;
+    };
+
+    //! Construct a Node from its ValueObject, retrieving its precedents from the Repository.
+    boost::shared_ptr<reposit::Object> createNode(
+        const boost::shared_ptr<reposit::ValueObject> &valueObject);
+
+    //! SerializationFactory which recreates Node objects.
+    /*! Serialization to and from files is not supported.
+    */
+    class SerializationFactory : public reposit::SerializationFactory {
+    public:
+        SerializationFactory();
+        //! The number of Node objects created by createNode() so far.
+        static long creatorCalls();
+        //! Public access to scanDirectory() for the benchmark.
+        std::vector<std::string> scan(const std::string &directory,
+                                      const std::string &pattern,
+                                      bool recurse) {
+            return scanDirectory(directory, pattern, recurse);
+        }
+    protected:
+        virtual void register_out(boost::archive::xml_oarchive &ar,
+            std::vector<boost::shared_ptr<reposit::ValueObject> >& valueObjects);
+        virtual void register_in(boost::archive::xml_iarchive &ar,
+            std::vector<boost::shared_ptr<reposit::ValueObject> >& valueObjects);
+    };
+
+    //! The global objects required by the Repository.
+    /*! Instantiate one of these at the start of each test.  The destructor
+        deletes all Objects, so that each test starts with an empty Repository.
+    */
+    class Environment {
+    public:
+        Environment();
+        ~Environment();
+    private:
+        reposit::Repository repository_;
+        reposit::ProcessorFactory processorFactory_;
+        SerializationFactory serializationFactory_;
+    };
+
+    //! Construct a Node without storing it in the Repository.
+    boost::shared_ptr<reposit::Object> makeNode(
+        const std::string &objectID,
+        long value = 0,
+        const std::vector<std::string> &precedents = std::vector<std::string>(),
+        bool permanent = false,
+        const std::string &className = "Node");
+
+    //! Construct a Node and store it in the Repository, return its ID.
+    std::string storeNode(
+        const std::string &objectID,
+        long value = 0,
+        const std::vector<std::string> &precedents = std::vector<std::string>(),
+        bool overwrite = false,
+        bool permanent = false,
+        const std::string &className = "Node");
+
+    //! Split a comma delimited list, e.g. ids("a,b") returns {"a", "b"}.
+    std::vector<std::string> ids(const std::string &list);
+    //! Join a list of IDs with commas, the inverse of ids().
+    std::string join(const std::vector<std::string> &list);
+
+}
+
+#endif
+
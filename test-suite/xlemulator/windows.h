@@ -0,0 +1,128 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*  Stand-in for the Windows header, for use with the Excel emulator.
+
+    Declares just those parts of the Win32 API which are used by xlsdk and
+    rpxl, so that they may be compiled on other platforms.  The directory
+    containing this file must be on the include path only when building
+    against the emulator.  The window functions do nothing, and the module
+    functions resolve only the callback MdCallBack12 of the emulator.  The
+    code page conversions treat the ANSI code page as Latin-1, in which each
+    byte is the character of the same number.
+*/
+
+#ifndef xlemulator_windows_h
+#define xlemulator_windows_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+
+typedef int32_t INT32;
+typedef uint16_t WORD;
+typedef unsigned int UINT;
+typedef int BOOL;
+typedef unsigned long DWORD;
+typedef uintptr_t DWORD_PTR;
+typedef unsigned char BYTE;
+typedef short SHORT;
+typedef unsigned short USHORT;
+typedef long LONG;
+typedef unsigned long ULONG;
+typedef wchar_t WCHAR;
+typedef char *LPSTR;
+typedef void VOID;
+typedef void *HANDLE;
+typedef void *HWND;
+typedef void *HMODULE;
+typedef intptr_t LPARAM;
+typedef int (*FARPROC)();
+typedef int (*WNDENUMPROC)(HWND, LPARAM);
+typedef struct { LONG x; LONG y; } POINT;
+
+#define far
+#define FAR
+#define pascal
+#define PASCAL
+#define _cdecl
+#define __cdecl
+#define CALLBACK
+#define WINAPI
+#define __declspec(x)
+
+#define TRUE 1
+#define FALSE 0
+
+#define CP_ACP 0
+
+#define LOWORD(x) ((WORD)((DWORD_PTR)(x) & 0xffff))
+#define __min(a, b) ((a) < (b) ? (a) : (b))
+#define stricmp strcasecmp
+
+inline int GetClassName(HWND, char *buffer, int size) {
+    if (size > 0) buffer[0] = 0;
+    return 0;
+}
+inline HWND GetParent(HWND) { return 0; }
+inline int EnumWindows(WNDENUMPROC, LPARAM) { return TRUE; }
+
+// Returns the number of characters written, or required if size is zero,
+// or zero if the buffer is too small.
+inline int MultiByteToWideChar(UINT, DWORD, const char *value, int len,
+                               WCHAR *buffer, int size) {
+    if (size == 0)
+        return len;
+    if (size < len)
+        return 0;
+    for (int i = 0; i < len; ++i)
+        buffer[i] = static_cast<unsigned char>(value[i]);
+    return len;
+}
+
+// As MultiByteToWideChar(), characters outside Latin-1 are replaced by
+// the default character, or '?' if that is null.
+inline int WideCharToMultiByte(UINT, DWORD, const WCHAR *value, int len,
+                               char *buffer, int size,
+                               const char *defaultChar, BOOL *usedDefaultChar) {
+    if (usedDefaultChar)
+        *usedDefaultChar = FALSE;
+    if (size == 0)
+        return len;
+    if (size < len)
+        return 0;
+    for (int i = 0; i < len; ++i) {
+        if (value[i] >= 0 && value[i] <= 0xFF) {
+            buffer[i] = static_cast<char>(value[i]);
+        } else {
+            buffer[i] = defaultChar ? *defaultChar : '?';
+            if (usedDefaultChar)
+                *usedDefaultChar = TRUE;
+        }
+    }
+    return len;
+}
+
+HMODULE GetModuleHandle(const char *moduleName);
+FARPROC GetProcAddress(HMODULE module, const char *procName);
+
+#endif
+
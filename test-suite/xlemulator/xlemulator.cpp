@@ -0,0 +1,921 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include "xlemulator.hpp"
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/thread/mutex.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace RepositTest {
+
+    ExcelEmulator *ExcelEmulator::instance_ = 0;
+
+    namespace {
+
+        const char bookName[] = "Book1";
+
+        // The size of the array returned by xlfGetWorkspace(37), and the
+        // positions of the row and column characters within it.
+        const int WORKSPACE_SIZE = 45;
+        const int ROW_CHARACTER = 5;
+        const int COL_CHARACTER = 6;
+
+        // A rectangular reference, with zero based coordinates.
+        struct Reference {
+            IDSHEET sheet;
+            int rwFirst, rwLast, colFirst, colLast;
+        };
+
+        bool operator<(const Reference &lhs, const Reference &rhs) {
+            if (lhs.sheet != rhs.sheet) return lhs.sheet < rhs.sheet;
+            if (lhs.rwFirst != rhs.rwFirst) return lhs.rwFirst < rhs.rwFirst;
+            if (lhs.colFirst != rhs.colFirst) return lhs.colFirst < rhs.colFirst;
+            if (lhs.rwLast != rhs.rwLast) return lhs.rwLast < rhs.rwLast;
+            return lhs.colLast < rhs.colLast;
+        }
+
+        // The contents of a cell, or a scalar argument.  Integers are held as
+        // numbers and booleans as 0 or 1.
+        struct Value {
+            Value() : type(xltypeNil), num(0), err(0) {}
+            DWORD type;
+            double num;
+            std::string str;
+            int err;
+        };
+
+        struct Name {
+            std::string name;
+            Reference reference;
+            bool valid;
+        };
+
+        typedef std::pair<IDSHEET, std::pair<int, int> > CellKey;
+        typedef std::map<CellKey, Value> CellMap;
+        // Names keyed by their upper case text.
+        typedef std::map<std::string, Name> NameMap;
+        // The upper case text of the valid names, keyed by their reference.
+        typedef std::multimap<Reference, std::string> DefinitionMap;
+
+        std::vector<std::string> sheets_;
+        CellMap cells_;
+        NameMap names_;
+        DefinitionMap definitions_;
+        std::map<int, long> calls_;
+        // The calls refused with xlretNotThreadSafe.
+        long refusedCalls_ = 0;
+        // The memory returned to the caller which has yet to be passed to xlFree.
+        std::set<const void*> allocations_;
+        long invalidFrees_ = 0;
+        // Guards all of the above, the caller is local to each thread.
+        boost::mutex mutex_;
+
+        __thread const ExcelEmulator::Call *caller_ = 0;
+
+        template <class Oper> struct Traits;
+
+        template <> struct Traits<XLOPER> {
+            typedef char Char;
+            typedef XLMREF Mref;
+            static const int maxLength = 255;
+            static const int minInt = -32768;
+            static const int maxInt = 32767;
+        };
+
+        template <> struct Traits<XLOPER12> {
+            typedef XCHAR Char;
+            typedef XLMREF12 Mref;
+            static const int maxLength = 32767;
+            static const int minInt = -2147483647 - 1;
+            static const int maxInt = 2147483647;
+        };
+
+        std::size_t stringLength(const char *s) { return static_cast<unsigned char>(s[0]); }
+        std::size_t stringLength(const XCHAR *s) { return static_cast<std::size_t>(s[0]); }
+
+        std::string upper(const std::string &s) {
+            return boost::algorithm::to_upper_copy(s);
+        }
+
+        // Conversions between operands and the values of the model.
+
+        template <class Oper>
+        std::string readString(const Oper &oper) {
+            std::string ret;
+            std::size_t length = stringLength(oper.val.str);
+            for (std::size_t i = 1; i <= length; ++i)
+                ret += static_cast<char>(oper.val.str[i]);
+            return ret;
+        }
+
+        template <class Oper>
+        void writeString(Oper &oper, const std::string &s) {
+            typedef typename Traits<Oper>::Char Char;
+            std::size_t length = std::min<std::size_t>(s.length(), Traits<Oper>::maxLength);
+            Char *str = new Char[length + 1];
+            str[0] = static_cast<Char>(length);
+            for (std::size_t i = 0; i < length; ++i)
+                str[i + 1] = static_cast<Char>(static_cast<unsigned char>(s[i]));
+            oper.val.str = str;
+            oper.xltype = xltypeStr;
+        }
+
+        template <class Oper>
+        void writeError(Oper &oper, int err) {
+            oper.xltype = xltypeErr;
+            oper.val.err = err;
+        }
+
+        template <class Oper>
+        void writeBool(Oper &oper, bool value) {
+            oper.xltype = xltypeBool;
+            oper.val.xbool = value;
+        }
+
+        template <class Oper>
+        void writeInt(Oper &oper, int value) {
+            oper.xltype = xltypeInt;
+            oper.val.w = value;
+        }
+
+        template <class Oper>
+        Value readValue(const Oper &oper) {
+            Value ret;
+            switch (oper.xltype & ~(xlbitXLFree | xlbitDLLFree)) {
+              case xltypeNum:
+                ret.type = xltypeNum;
+                ret.num = oper.val.num;
+                break;
+              case xltypeInt:
+                ret.type = xltypeNum;
+                ret.num = oper.val.w;
+                break;
+              case xltypeBool:
+                ret.type = xltypeBool;
+                ret.num = oper.val.xbool ? 1 : 0;
+                break;
+              case xltypeStr:
+                ret.type = xltypeStr;
+                ret.str = readString(oper);
+                break;
+              case xltypeErr:
+                ret.type = xltypeErr;
+                ret.err = oper.val.err;
+                break;
+              default:
+                break;
+            }
+            return ret;
+        }
+
+        template <class Oper>
+        void writeValue(Oper &oper, const Value &value) {
+            switch (value.type) {
+              case xltypeNum:
+                oper.xltype = xltypeNum;
+                oper.val.num = value.num;
+                break;
+              case xltypeBool:
+                writeBool(oper, value.num != 0);
+                break;
+              case xltypeStr:
+                writeString(oper, value.str);
+                break;
+              case xltypeErr:
+                writeError(oper, value.err);
+                break;
+              default:
+                oper.xltype = xltypeNil;
+                break;
+            }
+        }
+
+        template <class Oper>
+        int readInt(const Oper &oper) {
+            Value value = readValue(oper);
+            return value.type == xltypeNum ? static_cast<int>(value.num) : 0;
+        }
+
+        // Scalar coercions, following the rules of the worksheet.
+
+        bool toNumber(const Value &value, double &ret) {
+            if (value.type == xltypeNum || value.type == xltypeBool) {
+                ret = value.num;
+                return true;
+            } else if (value.type == xltypeNil) {
+                ret = 0;
+                return true;
+            } else if (value.type == xltypeStr && !value.str.empty()) {
+                char *end;
+                ret = std::strtod(value.str.c_str(), &end);
+                return *end == 0;
+            }
+            return false;
+        }
+
+        bool toBool(const Value &value, bool &ret) {
+            if (value.type == xltypeNum || value.type == xltypeBool) {
+                ret = value.num != 0;
+                return true;
+            } else if (value.type == xltypeNil) {
+                ret = false;
+                return true;
+            } else if (value.type == xltypeStr) {
+                std::string s = upper(value.str);
+                ret = s == "TRUE";
+                return ret || s == "FALSE";
+            }
+            return false;
+        }
+
+        bool toString(const Value &value, std::string &ret) {
+            if (value.type == xltypeStr) {
+                ret = value.str;
+            } else if (value.type == xltypeNum) {
+                char buffer[32];
+                std::sprintf(buffer, "%.15g", value.num);
+                ret = buffer;
+            } else if (value.type == xltypeBool) {
+                ret = value.num ? "TRUE" : "FALSE";
+            } else if (value.type == xltypeNil) {
+                ret.clear();
+            } else {
+                return false;
+            }
+            return true;
+        }
+
+        template <class Oper>
+        bool coerceScalar(const Value &value, DWORD types, Oper &result) {
+            double num;
+            bool b;
+            std::string s;
+            if (value.type & types) {
+                writeValue(result, value);
+                return true;
+            } else if (types & xltypeNum && toNumber(value, num)) {
+                result.xltype = xltypeNum;
+                result.val.num = num;
+                return true;
+            } else if (types & xltypeInt && toNumber(value, num)
+                && num >= Traits<Oper>::minInt && num <= Traits<Oper>::maxInt) {
+                writeInt(result, static_cast<int>(num));
+                return true;
+            } else if (types & xltypeBool && toBool(value, b)) {
+                writeBool(result, b);
+                return true;
+            } else if (types & xltypeStr && toString(value, s)) {
+                writeString(result, s);
+                return true;
+            }
+            return false;
+        }
+
+        // References.
+
+        bool validSheet(IDSHEET sheet) {
+            return sheet >= 1 && sheet <= sheets_.size();
+        }
+
+        template <class Oper>
+        bool readReference(const Oper &oper, Reference &reference) {
+            DWORD type = oper.xltype & ~(xlbitXLFree | xlbitDLLFree);
+            if (type == xltypeRef) {
+                if (!oper.val.mref.lpmref || oper.val.mref.lpmref->count != 1)
+                    return false;
+                reference.sheet = oper.val.mref.idSheet;
+                reference.rwFirst = oper.val.mref.lpmref->reftbl[0].rwFirst;
+                reference.rwLast = oper.val.mref.lpmref->reftbl[0].rwLast;
+                reference.colFirst = oper.val.mref.lpmref->reftbl[0].colFirst;
+                reference.colLast = oper.val.mref.lpmref->reftbl[0].colLast;
+            } else if (type == xltypeSRef) {
+                // A reference to the sheet of the caller.
+                reference.sheet = caller_ && !caller_->vba() ? caller_->sheet() : 1;
+                reference.rwFirst = oper.val.sref.ref.rwFirst;
+                reference.rwLast = oper.val.sref.ref.rwLast;
+                reference.colFirst = oper.val.sref.ref.colFirst;
+                reference.colLast = oper.val.sref.ref.colLast;
+            } else {
+                return false;
+            }
+            return validSheet(reference.sheet);
+        }
+
+        template <class Oper>
+        void writeReference(Oper &oper, const Reference &reference) {
+            typedef typename Traits<Oper>::Mref Mref;
+            Mref *mref = new Mref;
+            mref->count = 1;
+            mref->reftbl[0].rwFirst = reference.rwFirst;
+            mref->reftbl[0].rwLast = reference.rwLast;
+            mref->reftbl[0].colFirst = reference.colFirst;
+            mref->reftbl[0].colLast = reference.colLast;
+            oper.xltype = xltypeRef;
+            oper.val.mref.lpmref = mref;
+            oper.val.mref.idSheet = reference.sheet;
+        }
+
+        std::string cellText(int row, int col) {
+            std::ostringstream s;
+            s << 'R' << row + 1 << 'C' << col + 1;
+            return s.str();
+        }
+
+        // The text of a reference in the style returned by xlfReftext, e.g.
+        // [Book1]Sheet1!R1C1 or [Book1]Sheet1!R1C1:R2C2.
+        std::string referenceText(const Reference &reference, bool topLeft = false) {
+            std::string ret = std::string("[") + bookName + "]" + sheets_[reference.sheet - 1]
+                + "!" + cellText(reference.rwFirst, reference.colFirst);
+            if (!topLeft && (reference.rwLast != reference.rwFirst
+                || reference.colLast != reference.colFirst))
+                ret += ":" + cellText(reference.rwLast, reference.colLast);
+            return ret;
+        }
+
+        bool parseCell(const std::string &s, std::string::size_type &i, int &row, int &col) {
+            int *values[] = { &row, &col };
+            const char prefixes[] = "RC";
+            for (int n = 0; n < 2; ++n) {
+                if (i >= s.length() || std::toupper(s[i]) != prefixes[n])
+                    return false;
+                std::string::size_type start = ++i;
+                *values[n] = 0;
+                while (i < s.length() && s[i] >= '0' && s[i] <= '9')
+                    *values[n] = *values[n] * 10 + (s[i++] - '0');
+                if (i == start || *values[n] < 1)
+                    return false;
+                --*values[n];
+            }
+            return true;
+        }
+
+        // Parse text of the form returned by referenceText(), in which the
+        // book may be omitted.
+        bool parseReference(const std::string &text, Reference &reference) {
+            std::string::size_type begin = !text.empty() && text[0] == '=' ? 1 : 0;
+            std::string::size_type bang = text.rfind('!');
+            if (bang == std::string::npos || bang == begin)
+                return false;
+            std::string sheet = text.substr(begin, bang - begin);
+            if (sheet.length() > 1 && sheet[0] == '\'' && sheet[sheet.length() - 1] == '\'')
+                sheet = sheet.substr(1, sheet.length() - 2);
+            if (!sheet.empty() && sheet[0] == '[') {
+                std::string::size_type close = sheet.find(']');
+                if (close == std::string::npos
+                    || upper(sheet.substr(1, close - 1)) != upper(bookName))
+                    return false;
+                sheet = sheet.substr(close + 1);
+            }
+            reference.sheet = 0;
+            for (std::size_t i = 0; i < sheets_.size(); ++i) {
+                if (upper(sheets_[i]) == upper(sheet))
+                    reference.sheet = i + 1;
+            }
+            if (!reference.sheet)
+                return false;
+
+            std::string::size_type i = bang + 1;
+            if (!parseCell(text, i, reference.rwFirst, reference.colFirst))
+                return false;
+            if (i < text.length() && text[i] == ':') {
+                if (!parseCell(text, ++i, reference.rwLast, reference.colLast))
+                    return false;
+            } else {
+                reference.rwLast = reference.rwFirst;
+                reference.colLast = reference.colFirst;
+            }
+            return i == text.length()
+                && reference.rwFirst <= reference.rwLast
+                && reference.colFirst <= reference.colLast;
+        }
+
+        const Value &cellValue(IDSHEET sheet, int row, int col) {
+            static const Value empty;
+            CellMap::const_iterator i = cells_.find(std::make_pair(sheet, std::make_pair(row, col)));
+            return i == cells_.end() ? empty : i->second;
+        }
+
+        // Memory management.
+
+        template <class Oper>
+        void freeMemory(Oper &oper) {
+            DWORD type = oper.xltype & ~(xlbitXLFree | xlbitDLLFree);
+            if (type == xltypeStr) {
+                delete [] oper.val.str;
+            } else if (type == xltypeRef) {
+                delete oper.val.mref.lpmref;
+            } else if (type == xltypeMulti) {
+                int size = oper.val.array.rows * oper.val.array.columns;
+                for (int i = 0; i < size; ++i)
+                    freeMemory(oper.val.array.lparray[i]);
+                delete [] oper.val.array.lparray;
+            }
+        }
+
+        template <class Oper>
+        const void *memory(const Oper &oper) {
+            DWORD type = oper.xltype & ~(xlbitXLFree | xlbitDLLFree);
+            if (type == xltypeStr)
+                return oper.val.str;
+            else if (type == xltypeRef)
+                return oper.val.mref.lpmref;
+            else if (type == xltypeMulti)
+                return oper.val.array.lparray;
+            return 0;
+        }
+
+        template <class Oper>
+        Oper *allocateArray(Oper &oper, int rows, int cols) {
+            oper.xltype = xltypeMulti;
+            oper.val.array.rows = rows;
+            oper.val.array.columns = cols;
+            oper.val.array.lparray = new Oper[rows * cols];
+            return oper.val.array.lparray;
+        }
+
+        // The implementations of the functions of the C API.
+
+        template <class Oper>
+        int coerce(const Oper &source, DWORD types, Oper &result) {
+            DWORD type = source.xltype & ~(xlbitXLFree | xlbitDLLFree);
+            if (type == xltypeRef || type == xltypeSRef) {
+                Reference reference;
+                if (!readReference(source, reference))
+                    return xlretInvXloper;
+                if (types & xltypeMulti) {
+                    int rows = reference.rwLast - reference.rwFirst + 1;
+                    int cols = reference.colLast - reference.colFirst + 1;
+                    Oper *array = allocateArray(result, rows, cols);
+                    for (int r = 0; r < rows; ++r) {
+                        for (int c = 0; c < cols; ++c)
+                            writeValue(array[r * cols + c], cellValue(reference.sheet,
+                                reference.rwFirst + r, reference.colFirst + c));
+                    }
+                    return xlretSuccess;
+                }
+                return coerceScalar(cellValue(reference.sheet, reference.rwFirst,
+                    reference.colFirst), types, result) ? xlretSuccess : xlretFailed;
+            } else if (type == xltypeMulti) {
+                int size = source.val.array.rows * source.val.array.columns;
+                if (types & xltypeMulti) {
+                    Oper *array = allocateArray(result, source.val.array.rows, source.val.array.columns);
+                    for (int i = 0; i < size; ++i)
+                        writeValue(array[i], readValue(source.val.array.lparray[i]));
+                    return xlretSuccess;
+                }
+                if (!size)
+                    return xlretFailed;
+                return coerceScalar(readValue(source.val.array.lparray[0]), types, result)
+                    ? xlretSuccess : xlretFailed;
+            } else {
+                Value value = readValue(source);
+                if (types & xltypeMulti && !(types & value.type)) {
+                    writeValue(*allocateArray(result, 1, 1), value);
+                    return xlretSuccess;
+                }
+                return coerceScalar(value, types, result) ? xlretSuccess : xlretFailed;
+            }
+        }
+
+        bool restricted(int xlfn) {
+            // The functions equivalent to those of a macro sheet may not be
+            // called during multi-threaded recalculation.
+            switch (xlfn) {
+              case xlfReftext:
+              case xlfTextref:
+              case xlfSetName:
+              case xlfGetName:
+              case xlfGetDef:
+              case xlfGetCell:
+              case xlfGetWorkspace:
+              case xlfRegister:
+              case xlfUnregister:
+              case xlcAlert:
+                return true;
+              default:
+                return false;
+            }
+        }
+
+        void undefine(NameMap::iterator name) {
+            if (name->second.valid) {
+                std::pair<DefinitionMap::iterator, DefinitionMap::iterator> range =
+                    definitions_.equal_range(name->second.reference);
+                for (DefinitionMap::iterator i = range.first; i != range.second; ++i) {
+                    if (i->second == name->first) {
+                        definitions_.erase(i);
+                        break;
+                    }
+                }
+            }
+            names_.erase(name);
+        }
+
+        template <class Oper>
+        int evaluate(int xlfn, int count, Oper *opers[], Oper &result) {
+            Reference reference;
+            switch (xlfn) {
+              case xlCoerce:
+                if (count != 2)
+                    return xlretInvCount;
+                return coerce(*opers[0], readInt(*opers[1]), result);
+              case xlfCaller:
+                if (!caller_ || caller_->vba()) {
+                    writeError(result, xlerrRef);
+                } else {
+                    reference.sheet = caller_->sheet();
+                    reference.rwFirst = caller_->row();
+                    reference.rwLast = caller_->row() + caller_->rows() - 1;
+                    reference.colFirst = caller_->col();
+                    reference.colLast = caller_->col() + caller_->cols() - 1;
+                    writeReference(result, reference);
+                }
+                return xlretSuccess;
+              case xlfReftext:
+                if (count < 1)
+                    return xlretInvCount;
+                if (readReference(*opers[0], reference))
+                    writeString(result, referenceText(reference));
+                else
+                    writeError(result, xlerrValue);
+                return xlretSuccess;
+              case xlfTextref:
+                if (count < 1)
+                    return xlretInvCount;
+                if (parseReference(readValue(*opers[0]).str, reference))
+                    writeReference(result, reference);
+                else
+                    writeError(result, xlerrRef);
+                return xlretSuccess;
+              case xlfSetName: {
+                if (count < 1 || count > 2)
+                    return xlretInvCount;
+                std::string name = readValue(*opers[0]).str;
+                if (name.empty()) {
+                    writeError(result, xlerrValue);
+                    return xlretSuccess;
+                }
+                NameMap::iterator i = names_.find(upper(name));
+                if (count == 1) {
+                    // Delete the name.
+                    if (i == names_.end()) {
+                        writeError(result, xlerrName);
+                    } else {
+                        undefine(i);
+                        writeBool(result, true);
+                    }
+                    return xlretSuccess;
+                }
+                if (!readReference(*opers[1], reference)) {
+                    writeError(result, xlerrValue);
+                    return xlretSuccess;
+                }
+                if (i != names_.end())
+                    undefine(i);
+                Name &definition = names_[upper(name)];
+                definition.name = name;
+                definition.reference = reference;
+                definition.valid = true;
+                definitions_.insert(std::make_pair(reference, upper(name)));
+                writeBool(result, true);
+                return xlretSuccess;
+              }
+              case xlfGetName: {
+                if (count < 1)
+                    return xlretInvCount;
+                NameMap::const_iterator i = names_.find(upper(readValue(*opers[0]).str));
+                if (i == names_.end())
+                    writeError(result, xlerrName);
+                else
+                    writeString(result, "=" + (i->second.valid
+                        ? referenceText(i->second.reference) : std::string("#REF!")));
+                return xlretSuccess;
+              }
+              case xlfGetDef: {
+                if (count < 1)
+                    return xlretInvCount;
+                DefinitionMap::const_iterator i = definitions_.end();
+                if (parseReference(readValue(*opers[0]).str, reference))
+                    i = definitions_.find(reference);
+                if (i == definitions_.end())
+                    writeError(result, xlerrName);
+                else
+                    writeString(result, names_[i->second].name);
+                return xlretSuccess;
+              }
+              case xlfGetCell:
+                if (count != 2)
+                    return xlretInvCount;
+                if (readInt(*opers[0]) == 1 && readReference(*opers[1], reference))
+                    writeString(result, referenceText(reference, true));
+                else
+                    writeError(result, xlerrValue);
+                return xlretSuccess;
+              case xlfGetWorkspace:
+                if (count != 1)
+                    return xlretInvCount;
+                if (readInt(*opers[0]) == 37) {
+                    Oper *array = allocateArray(result, 1, WORKSPACE_SIZE);
+                    for (int i = 0; i < WORKSPACE_SIZE; ++i)
+                        writeString(array[i], i == ROW_CHARACTER ? "R"
+                            : i == COL_CHARACTER ? "C" : "");
+                } else {
+                    writeError(result, xlerrValue);
+                }
+                return xlretSuccess;
+              case xlSheetId:
+                result.xltype = xltypeRef;
+                result.val.mref.lpmref = 0;
+                result.val.mref.idSheet = caller_ && !caller_->vba() ? caller_->sheet() : 1;
+                return xlretSuccess;
+              case xlGetHwnd:
+                writeInt(result, 1);
+                return xlretSuccess;
+              case xlGetName:
+                writeString(result, "reposit.xll");
+                return xlretSuccess;
+              case xlStack:
+                writeInt(result, 10000);
+                return xlretSuccess;
+              case xlAbort:
+                writeBool(result, false);
+                return xlretSuccess;
+              case xlfRegister:
+                result.xltype = xltypeNum;
+                result.val.num = static_cast<double>(calls_[xlfRegister]);
+                return xlretSuccess;
+              case xlfUnregister:
+              case xlEventRegister:
+              case xlcAlert:
+                writeBool(result, true);
+                return xlretSuccess;
+              default:
+                return xlretInvXlfn;
+            }
+        }
+
+        template <class Oper>
+        int dispatch(int xlfn, Oper *result, int count, Oper *opers[]) {
+            boost::mutex::scoped_lock lock(mutex_);
+            ++calls_[xlfn];
+            if (caller_ && caller_->threadSafe() && restricted(xlfn)) {
+                ++refusedCalls_;
+                return xlretNotThreadSafe;
+            }
+            for (int i = 0; i < count; ++i) {
+                if (!opers[i])
+                    return xlretInvXloper;
+            }
+
+            if (xlfn == xlFree) {
+                for (int i = 0; i < count; ++i) {
+                    const void *p = memory(*opers[i]);
+                    if (!p)
+                        continue;
+                    if (allocations_.erase(p))
+                        freeMemory(*opers[i]);
+                    else
+                        ++invalidFrees_;
+                }
+                return xlretSuccess;
+            }
+
+            Oper ret;
+            ret.xltype = xltypeNil;
+            int xlret = evaluate(xlfn, count, opers, ret);
+            if (xlret != xlretSuccess)
+                return xlret;
+            if (result) {
+                if (const void *p = memory(ret))
+                    allocations_.insert(p);
+                *result = ret;
+            } else {
+                freeMemory(ret);
+            }
+            return xlretSuccess;
+        }
+
+    }
+
+    ExcelEmulator::Call::Call()
+        : vba_(true), threadSafe_(false), sheet_(0), row_(0), col_(0), rows_(0), cols_(0),
+          previous_(caller_) {
+        caller_ = this;
+    }
+
+    ExcelEmulator::Call::Call(IDSHEET sheet, int row, int col, int rows, int cols, bool threadSafe)
+        : vba_(false), threadSafe_(threadSafe), sheet_(sheet), row_(row), col_(col),
+          rows_(rows), cols_(cols), previous_(caller_) {
+        caller_ = this;
+    }
+
+    ExcelEmulator::Call::~Call() {
+        caller_ = previous_;
+    }
+
+    ExcelEmulator::ExcelEmulator() {
+        if (instance_)
+            throw std::logic_error("Multiple instances of ExcelEmulator");
+        instance_ = this;
+        boost::mutex::scoped_lock lock(mutex_);
+        sheets_.assign(1, "Sheet1");
+    }
+
+    ExcelEmulator::~ExcelEmulator() {
+        boost::mutex::scoped_lock lock(mutex_);
+        sheets_.clear();
+        cells_.clear();
+        names_.clear();
+        definitions_.clear();
+        calls_.clear();
+        refusedCalls_ = 0;
+        allocations_.clear();
+        invalidFrees_ = 0;
+        instance_ = 0;
+    }
+
+    ExcelEmulator &ExcelEmulator::instance() {
+        if (!instance_)
+            throw std::logic_error("Attempt to reference uninitialized ExcelEmulator");
+        return *instance_;
+    }
+
+    IDSHEET ExcelEmulator::addSheet(const std::string &name) {
+        boost::mutex::scoped_lock lock(mutex_);
+        sheets_.push_back(name);
+        return sheets_.size();
+    }
+
+    void ExcelEmulator::setCell(IDSHEET sheet, int row, int col, double value) {
+        boost::mutex::scoped_lock lock(mutex_);
+        Value &cell = cells_[std::make_pair(sheet, std::make_pair(row, col))];
+        cell.type = xltypeNum;
+        cell.num = value;
+    }
+
+    void ExcelEmulator::setCell(IDSHEET sheet, int row, int col, const std::string &value) {
+        boost::mutex::scoped_lock lock(mutex_);
+        Value &cell = cells_[std::make_pair(sheet, std::make_pair(row, col))];
+        cell.type = xltypeStr;
+        cell.str = value;
+    }
+
+    void ExcelEmulator::deleteRange(IDSHEET sheet, int row, int col, int rows, int cols) {
+        boost::mutex::scoped_lock lock(mutex_);
+        for (NameMap::iterator i = names_.begin(); i != names_.end(); ++i) {
+            Name &name = i->second;
+            if (name.valid && name.reference.sheet == sheet
+                && name.reference.rwFirst >= row && name.reference.rwLast < row + rows
+                && name.reference.colFirst >= col && name.reference.colLast < col + cols) {
+                std::pair<DefinitionMap::iterator, DefinitionMap::iterator> range =
+                    definitions_.equal_range(name.reference);
+                for (DefinitionMap::iterator j = range.first; j != range.second; ++j) {
+                    if (j->second == i->first) {
+                        definitions_.erase(j);
+                        break;
+                    }
+                }
+                name.valid = false;
+            }
+        }
+        for (int r = row; r < row + rows; ++r) {
+            for (int c = col; c < col + cols; ++c)
+                cells_.erase(std::make_pair(sheet, std::make_pair(r, c)));
+        }
+    }
+
+    std::size_t ExcelEmulator::nameCount() const {
+        boost::mutex::scoped_lock lock(mutex_);
+        return names_.size();
+    }
+
+    std::string ExcelEmulator::nameReference(const std::string &name) const {
+        boost::mutex::scoped_lock lock(mutex_);
+        NameMap::const_iterator i = names_.find(upper(name));
+        if (i == names_.end())
+            return "";
+        return i->second.valid ? referenceText(i->second.reference) : "#REF!";
+    }
+
+    long ExcelEmulator::calls(int xlfn) const {
+        boost::mutex::scoped_lock lock(mutex_);
+        std::map<int, long>::const_iterator i = calls_.find(xlfn);
+        return i == calls_.end() ? 0 : i->second;
+    }
+
+    long ExcelEmulator::calls() const {
+        boost::mutex::scoped_lock lock(mutex_);
+        long ret = 0;
+        for (std::map<int, long>::const_iterator i = calls_.begin(); i != calls_.end(); ++i)
+            ret += i->second;
+        return ret;
+    }
+
+    long ExcelEmulator::refusedCalls() const {
+        boost::mutex::scoped_lock lock(mutex_);
+        return refusedCalls_;
+    }
+
+    std::size_t ExcelEmulator::allocations() const {
+        boost::mutex::scoped_lock lock(mutex_);
+        return allocations_.size();
+    }
+
+    long ExcelEmulator::invalidFrees() const {
+        boost::mutex::scoped_lock lock(mutex_);
+        return invalidFrees_;
+    }
+
+    void ExcelEmulator::reset() {
+        boost::mutex::scoped_lock lock(mutex_);
+        calls_.clear();
+        refusedCalls_ = 0;
+    }
+
+    int ExcelEmulator::call(int xlfn, LPXLOPER result, int count, LPXLOPER opers[]) {
+        return dispatch(xlfn, result, count, opers);
+    }
+
+    int ExcelEmulator::call(int xlfn, LPXLOPER12 result, int count, LPXLOPER12 opers[]) {
+        return dispatch(xlfn, result, count, opers);
+    }
+
+}
+
+// The entry points of the C API.  Excel12v() is implemented by framewrk.cpp,
+// which obtains the callback MdCallBack12 from GetProcAddress().
+
+namespace {
+
+    // The maximum number of arguments to a function of the C API.
+    const int MAX_ARGS = 255;
+
+    int MdCallBack12(int xlfn, int count, LPXLOPER12 *opers, LPXLOPER12 result) {
+        return RepositTest::ExcelEmulator::instance().call(xlfn, result, count, opers);
+    }
+
+}
+
+extern "C" {
+
+    int Excel4v(int xlfn, LPXLOPER operRes, int count, LPXLOPER opers[]) {
+        return RepositTest::ExcelEmulator::instance().call(xlfn, operRes, count, opers);
+    }
+
+    int Excel4(int xlfn, LPXLOPER operRes, int count, ...) {
+        LPXLOPER opers[MAX_ARGS];
+        if (count > MAX_ARGS)
+            return xlretInvCount;
+        va_list args;
+        va_start(args, count);
+        for (int i = 0; i < count; ++i)
+            opers[i] = va_arg(args, LPXLOPER);
+        va_end(args);
+        return Excel4v(xlfn, operRes, count, opers);
+    }
+
+    int XLCallVer() {
+        return 0x0C00;
+    }
+
+    long LPenHelper(int, VOID *) {
+        return 0;
+    }
+
+}
+
+HMODULE GetModuleHandle(const char *) {
+    return 0;
+}
+
+FARPROC GetProcAddress(HMODULE, const char *procName) {
+    if (!std::strcmp(procName, "MdCallBack12"))
+        return reinterpret_cast<FARPROC>(MdCallBack12);
+    return 0;
+}
+
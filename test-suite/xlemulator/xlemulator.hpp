@@ -0,0 +1,119 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ Copyright (C) 2014 Eric Ehlers
+
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*  An in-process stand-in for Excel, allowing rpxl to be tested and profiled
+    on platforms other than Windows.
+
+    The emulator implements Excel4v() and the callback MdCallBack12, which
+    serves Excel12v(), for those functions of the C API which are called by
+    xlsdk and rpxl.  The functions operate on a synthetic model of a single
+    workbook, Book1, comprising worksheets, the values of their cells and the
+    names defined on their ranges.  The workspace uses the R1C1 reference style.
+
+    The caller seen by xlfCaller is set by instantiating ExcelEmulator::Call
+    on the stack around the invocation of a worksheet function.  A call may
+    be marked thread safe, in which case the functions which Excel forbids
+    during multi-threaded recalculation fail with xlretNotThreadSafe.
+*/
+
+#ifndef repositest_xlemulator_hpp
+#define repositest_xlemulator_hpp
+
+#include <windows.h>
+#include <xlsdk/xlcall.h>
+#include <string>
+
+namespace RepositTest {
+
+    class ExcelEmulator {
+      public:
+        //! The formula, or VBA procedure, invoking a worksheet function.
+        class Call {
+          public:
+            //! A call from VBA, for which xlfCaller returns #REF!.
+            Call();
+            //! A call from the formula in the given range, whose coordinates are zero based.
+            Call(IDSHEET sheet, int row, int col, int rows = 1, int cols = 1,
+                 bool threadSafe = false);
+            ~Call();
+            bool vba() const { return vba_; }
+            bool threadSafe() const { return threadSafe_; }
+            IDSHEET sheet() const { return sheet_; }
+            int row() const { return row_; }
+            int col() const { return col_; }
+            int rows() const { return rows_; }
+            int cols() const { return cols_; }
+          private:
+            Call(const Call&);
+            Call &operator=(const Call&);
+            bool vba_, threadSafe_;
+            IDSHEET sheet_;
+            int row_, col_, rows_, cols_;
+            const Call *previous_;
+        };
+
+        //! Create the emulator, with a workbook containing the sheet Sheet1.
+        ExcelEmulator();
+        ~ExcelEmulator();
+        static ExcelEmulator &instance();
+
+        //! \name Sheet model
+        //@{
+        //! Add a worksheet to the book and return its ID.
+        IDSHEET addSheet(const std::string &name);
+        void setCell(IDSHEET sheet, int row, int col, double value);
+        void setCell(IDSHEET sheet, int row, int col, const std::string &value);
+        //! Delete the given range, so that the names defined within it refer to #REF!.
+        void deleteRange(IDSHEET sheet, int row, int col, int rows = 1, int cols = 1);
+        //! The number of names defined in the book, including those which refer to #REF!.
+        std::size_t nameCount() const;
+        //! The R1C1 text of the reference of the given name, or an empty string.
+        std::string nameReference(const std::string &name) const;
+        //@}
+
+        //! \name Instrumentation
+        //@{
+        //! The number of calls made to the given function since the last reset().
+        long calls(int xlfn) const;
+        //! The number of calls made to all functions since the last reset().
+        long calls() const;
+        //! The number of calls refused with xlretNotThreadSafe since the last reset().
+        long refusedCalls() const;
+        //! The number of values returned by Excel which are yet to be passed to xlFree.
+        std::size_t allocations() const;
+        //! The number of calls to xlFree for memory which Excel did not allocate.
+        long invalidFrees() const;
+        //! Reset the call counters.
+        void reset();
+        //@}
+
+        //! The implementation of the callbacks, public only for use by the C entry points.
+        int call(int xlfn, LPXLOPER result, int count, LPXLOPER opers[]);
+        int call(int xlfn, LPXLOPER12 result, int count, LPXLOPER12 opers[]);
+
+      private:
+        ExcelEmulator(const ExcelEmulator&);
+        ExcelEmulator &operator=(const ExcelEmulator&);
+        static ExcelEmulator *instance_;
+    };
+
+}
+
+#endif
+
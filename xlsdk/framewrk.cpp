@@ -1,13 +1,136 @@
+#if defined(_MSC_VER)
 #pragma warning(disable : 4996)
+#endif
 
 #include <windows.h>
 #include <xlsdk/xlcall.h>
 #include <xlsdk/framewrk.hpp>
 #include <sstream>
-#include <exception>
+#include <stdexcept>
+#include <stdlib.h>
 
-char vMemBlock[MEMORYSIZE]; // Memory for temporary XLOPERs
-int vOffsetMemBlock=0;      // Offset of next memory block to allocate
+//
+// Temporary memory is held per thread, so that functions registered as
+// thread safe may call Excel() concurrently.  Each thread allocates first
+// from its own vMemBlock and, once that is exhausted, from a chain of
+// chunks obtained from the heap.  The chunks are retained when the memory
+// is freed, so that a thread reaches a steady state after its first few
+// calls.
+//
+
+// A __declspec(thread) variable of a DLL loaded by LoadLibrary, as an XLL
+// is, is only supported from Windows Vista onwards.  On earlier versions
+// of Windows its use faults.
+
+#if defined(_MSC_VER)
+#define THREADLOCAL __declspec(thread)
+#else
+#define THREADLOCAL __thread
+#endif
+
+// Header of a chunk of temporary memory obtained from the heap.
+// The memory itself immediately follows the header.
+struct TempChunk
+{
+    TempChunk *next;
+    int size;
+};
+
+THREADLOCAL char vMemBlock[MEMORYSIZE]; // Memory for temporary XLOPERs
+THREADLOCAL int vOffsetMemBlock=0;      // Offset of next memory block to allocate in the current chunk
+THREADLOCAL TempChunk *vCurrentChunk=0; // Chunk currently in use, 0 for vMemBlock
+THREADLOCAL TempChunk *vFirstChunk=0;   // Chain of chunks obtained from the heap
+THREADLOCAL TempChunk *vLastChunk=0;    // Last chunk in the chain
+THREADLOCAL int vUsedMemory=0;          // Bytes allocated since FreeAllTempMemory()
+THREADLOCAL int vHighWaterMemory=0;     // Largest value of vUsedMemory
+THREADLOCAL int vReservedMemory=MEMORYSIZE; // Total size of vMemBlock and the chunks
+
+///***************************************************************************
+// NextTempChunk()
+//
+// Purpose:
+//           Moves the allocation of temporary memory on to the next
+//           chunk of at least cBytes bytes, obtaining a new chunk from
+//           the heap if necessary.
+//
+// Parameters:
+//
+//      int cBytes      How many bytes must be available in the chunk
+//
+// Comments:
+//
+//      Chunks too small for the request are skipped until the
+//      memory is next freed.  Each new chunk is twice the size of
+//      the previous one, or larger if the request requires it.
+//
+///***************************************************************************
+
+static void NextTempChunk(int cBytes)
+{
+    TempChunk *lpChunk = vCurrentChunk ? vCurrentChunk->next : vFirstChunk;
+    while (lpChunk && lpChunk->size < cBytes)
+        lpChunk = lpChunk->next;
+
+    if (!lpChunk)
+    {
+        int size = 2 * (vLastChunk ? vLastChunk->size : MEMORYSIZE);
+        if (size < cBytes) size = cBytes;
+
+        lpChunk = (TempChunk *) malloc(sizeof(TempChunk) + size);
+        if (!lpChunk)
+            throw std::runtime_error("unable to allocate temporary memory");
+        lpChunk->next = 0;
+        lpChunk->size = size;
+
+        if (vLastChunk)
+            vLastChunk->next = lpChunk;
+        else
+            vFirstChunk = lpChunk;
+        vLastChunk = lpChunk;
+        vReservedMemory += size;
+    }
+
+    vCurrentChunk = lpChunk;
+    vOffsetMemBlock = 0;
+}
+
+///***************************************************************************
+// TrimTempChunks()
+//
+// Purpose:
+//           Returns to the heap the chunks at the end of the chain
+//           beyond the first cRetained bytes.  The memory must not
+//           be in use.
+//
+// Parameters:
+//
+//      int cRetained   How many bytes of chunks to keep
+//
+///***************************************************************************
+
+static void TrimTempChunks(int cRetained)
+{
+    TempChunk **lpNext = &vFirstChunk;
+    TempChunk *lpLast = 0;
+    int retained = 0;
+    while (*lpNext && retained + (*lpNext)->size <= cRetained)
+    {
+        lpLast = *lpNext;
+        retained += lpLast->size;
+        lpNext = &lpLast->next;
+    }
+
+    TempChunk *lpChunk = *lpNext;
+    *lpNext = 0;
+    while (lpChunk)
+    {
+        TempChunk *lpFree = lpChunk;
+        lpChunk = lpChunk->next;
+        vReservedMemory -= lpFree->size;
+        free(lpFree);
+    }
+    vLastChunk = lpLast;
+}
 
 ///***************************************************************************
 // GetTempMemory()
@@ -23,52 +146,55 @@ int vOffsetMemBlock=0;      // Offset of next memory block to allocate
 //
 // Returns:
 //
-//      LPSTR           A pointer to the allocated memory,
-//                      or 0 if more memory cannot be
-//                      allocated. If this fails,
-//                      check that you are initializing
-//                      vOffsetMemBlock to 0, and check that
-//                      MEMORYSIZE is big enough.
+//      LPSTR           A pointer to the allocated memory.
+//                      Throws if the memory cannot be
+//                      obtained from the heap.
 //
 // Comments:
 //
 //        Algorithm:
 //
-//             The memory allocation algorithm is extremely
+//             The memory allocation algorithm is very
 //             simple: on each call, allocate the next cBytes
-//             bytes of a static memory buffer. If the buffer
-//             becomes too full, simply fail. To free memory,
-//             simply reset the pointer (vOffsetMemBlock)
-//             back to zero. This memory scheme is very fast
-//             and is optimized for the assumption that the
-//             only thing you are using temporary memory
-//             for is to hold arguments while you call Excel().
-//             We rely on the fact that you will free all the
-//             temporary memory at the same time. We also
-//             assume you will not need more memory than
-//             the amount required to hold a few arguments
-//             to Excel().
+//             bytes of the current chunk, which is initially
+//             the static buffer vMemBlock. If the chunk
+//             becomes too full, move on to the next chunk,
+//             see NextTempChunk(). To free memory, simply
+//             reset the pointer (vOffsetMemBlock) back to
+//             zero and return to vMemBlock. This memory scheme
+//             is very fast and is optimized for the assumption
+//             that the only thing you are using temporary
+//             memory for is to hold arguments while you call
+//             Excel(). We rely on the fact that you will free
+//             all the temporary memory at the same time.
 //
 ///***************************************************************************
 
 LPSTR GetTempMemory(int cBytes)
 {
     LPSTR lpMemory;
+    int size = vCurrentChunk ? vCurrentChunk->size : MEMORYSIZE;
 
-    if (vOffsetMemBlock + cBytes > MEMORYSIZE)
-    {
-        //return 0;
-        throw std::exception("buffer overflow");
-    }
+    if (vOffsetMemBlock + cBytes > size)
+        NextTempChunk(cBytes);
+
+    if (vCurrentChunk)
+        lpMemory = (LPSTR) (vCurrentChunk + 1) + vOffsetMemBlock;
     else
-    {
         lpMemory = (LPSTR) &vMemBlock + vOffsetMemBlock;
-        vOffsetMemBlock += cBytes;
+    vOffsetMemBlock += cBytes;
+    vUsedMemory += cBytes;
 
-        /* Prevent odd pointers */
-        if (vOffsetMemBlock & 1) vOffsetMemBlock++;
-        return lpMemory;
+    /* Prevent odd pointers */
+    if (vOffsetMemBlock & 1)
+    {
+        vOffsetMemBlock++;
+        vUsedMemory++;
     }
+
+    if (vUsedMemory > vHighWaterMemory)
+        vHighWaterMemory = vUsedMemory;
+    return lpMemory;
 }
 
 ///***************************************************************************
@@ -77,6 +203,7 @@ LPSTR GetTempMemory(int cBytes)
 // Purpose:
 //
 //          Frees all temporary memory that has been allocated
+//          by the calling thread
 //
 // Parameters:
 //
@@ -84,69 +211,221 @@ LPSTR GetTempMemory(int cBytes)
 //
 // Comments:
 //
-//      Unlike the usual string functions, lpstricmp
-//      doesn't care about collating sequence.
+//      The chunks obtained from the heap are retained for
+//      subsequent calls to GetTempMemory().
 //
 ///***************************************************************************
 
 void FreeAllTempMemory(void)
 {
     vOffsetMemBlock = 0;
+    vCurrentChunk = 0;
+    vUsedMemory = 0;
+
+    if (vReservedMemory > MEMORYSIZE + MAXRETAINEDMEMORY)
+        TrimTempChunks(MAXRETAINEDMEMORY);
 }
 
-void Excel(int xlfn, LPXLOPER pxResult, int count, ...) {
+///***************************************************************************
+// ReleaseTempMemory()
+//
+// Purpose:
+//
+//          Frees all temporary memory that has been allocated
+//          by the calling thread, and returns the chunks
+//          obtained from the heap
+//
+// Comments:
+//
+//      Call this before the XLL is unloaded.  It affects only the
+//      calling thread; the chunks of other threads are returned
+//      by FreeAllTempMemory() only once they exceed
+//      MAXRETAINEDMEMORY.
+//
+///***************************************************************************
+
+void ReleaseTempMemory(void)
+{
+    vOffsetMemBlock = 0;
+    vCurrentChunk = 0;
+    vUsedMemory = 0;
+    TrimTempChunks(0);
+}
+
+///***************************************************************************
+// TempMemoryHighWater()
+//
+// Purpose:
+//
+//          Returns the largest number of bytes of temporary
+//          memory held at one time by the calling thread
+//
+///***************************************************************************
+
+int TempMemoryHighWater(void)
+{
+    return vHighWaterMemory;
+}
+
+///***************************************************************************
+// TempMemoryReserved()
+//
+// Purpose:
+//
+//          Returns the number of bytes of temporary memory
+//          available to the calling thread, including the
+//          chunks obtained from the heap
+//
+///***************************************************************************
 
-    //int xlret = Excel4v(xlfn, pxResult, count, (LPXLOPER FAR *)(&count+1));
+int TempMemoryReserved(void)
+{
+    return vReservedMemory;
+}
 
-    int ver = XLCallVer();
+///***************************************************************************
+// ThrowExcelError()
+//
+// Purpose:
+//          Throws an exception describing the failure of a call
+//          to Excel, given the function number and return code.
+//
+///***************************************************************************
 
+static void ThrowExcelError(int xlfn, int xlret)
+{
+    std::ostringstream msg;
+    msg << "Error in call to Excel: (";
+    if (xlfn & xlCommand)       msg << "xlCommand | ";
+    if (xlfn & xlSpecial)       msg << "xlSpecial | ";
+    if (xlfn & xlIntl)          msg << "xlIntl | ";
+    if (xlfn & xlPrompt)        msg << "xlPrompt | ";
+    msg << (xlfn & 0x0FFF) << ") callback failed: ";
+    if (xlret & xlretAbort)     msg << " Macro Halted ";
+    if (xlret & xlretInvXlfn)   msg << " Invalid Function Number "
+        "- this error may occur when a function which is not registered as a macro "
+        "(trailing # in the argument list passed to xlfRegister) "
+        "attempts to call a function restricted to macros e.g. xlfCaller.";
+    if (xlret & xlretInvCount)  msg << " Invalid Number of Arguments ";
+    if (xlret & xlretInvXloper) msg << " Invalid XLOPER ";
+    if (xlret & xlretStackOvfl) msg << " Stack Overflow ";
+    if (xlret & xlretFailed)    msg << " Command failed ";
+    if (xlret & xlretUncalced)  msg << " Uncalced cell ";
+    throw std::runtime_error(msg.str());
+}
+
+void Excel(int xlfn, LPXLOPER pxResult, int count, ...) {
+
+    LPXLOPER rgx[MAXARGS];
     va_list ppxArgs;
 
-    LPXLOPER px;
-    int i;
+    if (count > MAXARGS)
+        ThrowExcelError(xlfn, xlretInvCount);
 
     va_start(ppxArgs, count);
-
-    for (i = 0; i<count; i++)
+    for (int i = 0; i < count; i++)
     {
-        px = va_arg(ppxArgs, LPXLOPER);
+        rgx[i] = va_arg(ppxArgs, LPXLOPER);
 
-        if (px == NULL)
+        if (rgx[i] == NULL)
         {
+            va_end(ppxArgs);
             FreeAllTempMemory();
             return;
         }
     }
+    va_end(ppxArgs);
 
+    int xlret = Excel4v(xlfn, pxResult, count, rgx);
+
+    FreeAllTempMemory();
+
+    if (xlret != xlretSuccess)
+        ThrowExcelError(xlfn, xlret);
+
+}
+
+///***************************************************************************
+// Excel12(), Excel12v()
+//
+// Purpose:
+//          The entry points of the Excel 2007 C API.  These are not
+//          exported by xlcall32.lib, instead each call is forwarded to
+//          the callback MdCallBack12 exported by the Excel process.
+//
+// Returns:
+//
+//      int             The return code from Excel, or xlretFailed
+//                      if the running version of Excel does not
+//                      support XLOPER12.
+//
+///***************************************************************************
+
+typedef int (PASCAL *EXCEL12PROC)(int xlfn, int coper, LPXLOPER12 *rgpxloper12, LPXLOPER12 xloper12Res);
+
+static EXCEL12PROC pexcel12 =
+    (EXCEL12PROC) GetProcAddress(GetModuleHandle(NULL), "MdCallBack12");
+
+int pascal Excel12v(int xlfn, LPXLOPER12 operRes, int count, LPXLOPER12 opers[])
+{
+    if (!pexcel12)
+        return xlretFailed;
+    return pexcel12(xlfn, count, opers, operRes);
+}
+
+int _cdecl Excel12(int xlfn, LPXLOPER12 operRes, int count, ...)
+{
+    LPXLOPER12 rgx[MAXARGS12];
+    va_list ppxArgs;
+
+    if (count > MAXARGS12)
+        return xlretInvCount;
+
+    va_start(ppxArgs, count);
+    for (int i = 0; i < count; i++)
+        rgx[i] = va_arg(ppxArgs, LPXLOPER12);
     va_end(ppxArgs);
 
+    return Excel12v(xlfn, operRes, count, rgx);
+}
+
+///***************************************************************************
+// Excel12f()
+//
+// Purpose:
+//          As Excel(), for functions which take and return XLOPER12s.
+//          Frees all temporary memory and throws if the call fails.
+//
+///***************************************************************************
+
+void Excel12f(int xlfn, LPXLOPER12 pxResult, int count, ...) {
+
+    LPXLOPER12 rgx[MAXARGS12];
+    va_list ppxArgs;
+
+    if (count > MAXARGS12)
+        ThrowExcelError(xlfn, xlretInvCount);
 
     va_start(ppxArgs, count);
-    int xlret = Excel4v(xlfn, pxResult, count, (LPXLOPER *)ppxArgs);
+    for (int i = 0; i < count; i++)
+    {
+        rgx[i] = va_arg(ppxArgs, LPXLOPER12);
+
+        if (rgx[i] == NULL)
+        {
+            va_end(ppxArgs);
+            FreeAllTempMemory();
+            return;
+        }
+    }
     va_end(ppxArgs);
 
+    int xlret = Excel12v(xlfn, pxResult, count, rgx);
+
     FreeAllTempMemory();
 
-    if (xlret != xlretSuccess) {
-        std::ostringstream msg;
-        msg << "Error in call to Excel: (";
-        if (xlfn & xlCommand)       msg << "xlCommand | ";
-        if (xlfn & xlSpecial)       msg << "xlSpecial | ";
-        if (xlfn & xlIntl)          msg << "xlIntl | ";
-        if (xlfn & xlPrompt)        msg << "xlPrompt | ";
-        msg << (xlfn & 0x0FFF) << ") callback failed: ";
-        if (xlret & xlretAbort)     msg << " Macro Halted ";
-        if (xlret & xlretInvXlfn)   msg << " Invalid Function Number "
-            "- this error may occur when a function which is not registered as a macro "
-            "(trailing # in the argument list passed to xlfRegister) "
-            "attempts to call a function restricted to macros e.g. xlfCaller.";
-        if (xlret & xlretInvCount)  msg << " Invalid Number of Arguments ";
-        if (xlret & xlretInvXloper) msg << " Invalid XLOPER ";
-        if (xlret & xlretStackOvfl) msg << " Stack Overflow ";
-        if (xlret & xlretFailed)    msg << " Command failed ";
-        if (xlret & xlretUncalced)  msg << " Uncalced cell ";
-        throw std::exception(msg.str().c_str());
-    }
+    if (xlret != xlretSuccess)
+        ThrowExcelError(xlfn, xlret);
 
 }
 
@@ -360,6 +639,34 @@ LPXLOPER TempInt(short int i)
     return lpx;
 }
 
+///***************************************************************************
+// TempInt12()
+//
+// Purpose:
+//          Creates a temporary integer XLOPER12.
+//
+// Parameters:
+//
+//      int i           The integer
+//
+// Returns:
+//
+//      LPXLOPER12      The temporary XLOPER12.
+//
+///***************************************************************************
+
+LPXLOPER12 TempInt12(int i)
+{
+    LPXLOPER12 lpx;
+
+    lpx = (LPXLOPER12) GetTempMemory(sizeof(XLOPER12));
+
+    lpx->xltype = xltypeInt;
+    lpx->val.w = i;
+
+    return lpx;
+}
+
 ///***************************************************************************
 // TempErr()
 //
@@ -17,11 +17,31 @@
 
 #include <string>
 //
-// Total amount of memory to allocate for all temporary XLOPERs
+// Amount of memory for temporary XLOPERs held by each thread before
+// further memory is obtained from the heap
 //
 
 #define MEMORYSIZE 1024
 
+//
+// Amount of memory obtained from the heap which each thread retains
+// when its temporary memory is freed
+//
+
+#define MAXRETAINEDMEMORY 65536
+
+//
+// Maximum number of arguments in a call to Excel()
+//
+
+#define MAXARGS 30
+
+//
+// Maximum number of arguments in a call to Excel12()
+//
+
+#define MAXARGS12 255
+
 
 // 
 // Function prototypes
@@ -30,13 +50,18 @@
 void far __cdecl debugPrintf(LPSTR lpFormat, ...);
 LPSTR GetTempMemory(int cBytes);
 void FreeAllTempMemory(void);
+void ReleaseTempMemory(void);
+int TempMemoryHighWater(void);
+int TempMemoryReserved(void);
 void __cdecl Excel(int xlfn, LPXLOPER pxResult, int count, ...);
+void __cdecl Excel12f(int xlfn, LPXLOPER12 pxResult, int count, ...);
 LPXLOPER TempNum(double d);
 //LPXLOPER TempStr(LPSTR lpstr);
 LPXLOPER TempStrNoSize(LPSTR lpstr);
 LPXLOPER TempStrStl(const std::string &s);
 LPXLOPER TempBool(int b);
 LPXLOPER TempInt(short int i);
+LPXLOPER12 TempInt12(int i);
 LPXLOPER TempActiveRef(WORD rwFirst,WORD rwLast,BYTE colFirst,BYTE colLast);
 LPXLOPER TempActiveCell(WORD rw, BYTE col);
 LPXLOPER TempActiveRow(WORD rw);
@@ -28,9 +28,12 @@
 #define VECTOR "<VECTOR>"
 #define MATRIX "<MATRIX>"
 #define XL_MAX_STR_LEN 256
+#define XL_MAX_STR_LEN12 32768
 
 // parameters registered with Excel as OPER (P) are declared as XLOPER
 #define OPER XLOPER
+// parameters registered with Excel as OPER12 (Q) are declared as XLOPER12
+#define OPER12 XLOPER12
 
 //typedef struct {
 //    WORD rows;